@@ -0,0 +1,387 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+// Benchmarks of the distortion models on the example calibrations:
+//  - CPU: warp map generation (per instruction set and direction) and remapping
+//  - GPU: the distortion pass of the example shaders, analytic (generic and
+//    specialized program variant) and with a warp map
+// Results are printed as a table and optionally written as JSON to track trends.
+//
+//   camera_distortion_bench [--configs dir] [--shaders dir] [--sizes 640x480,1920x1080]
+//                           [--iterations N] [--json file] [--no-cpu] [--no-gpu]
+
+#include "camdistort.h"
+#include "camera_params_yaml.h"
+#ifdef CAMERA_DISTORTION_BENCH_HAVE_EGL
+#include "gl_bench.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct BenchResult {
+    string model;
+    string config;
+    int width;
+    int height;
+    // e.g. "cpu.warp_map.forward", "gpu.pass.analytic"
+    string name;
+    string isa;
+    vector<double> samplesMs;
+};
+
+struct Size {
+    int width;
+    int height;
+};
+
+static double percentile(vector<double> a_samples, double a_fraction)
+{
+    if (a_samples.empty()){
+        return 0.0;
+    }
+    sort(a_samples.begin(), a_samples.end());
+    size_t index = (size_t)(a_fraction * (a_samples.size() - 1) + 0.5);
+    return a_samples[min(index, a_samples.size() - 1)];
+}
+
+static double mean(const vector<double> &a_samples)
+{
+    double sum = 0.0;
+    for (size_t i = 0 ; i < a_samples.size() ; i++){
+        sum += a_samples[i];
+    }
+    return a_samples.empty() ? 0.0 : sum / a_samples.size();
+}
+
+// Wall time of a_function in milliseconds, after one warm-up call
+static vector<double> timeCpu(const function<void()> &a_function, int a_iterations)
+{
+    typedef chrono::steady_clock Clock;
+    a_function();
+    vector<double> samples;
+    for (int i = 0 ; i < a_iterations ; i++){
+        Clock::time_point start = Clock::now();
+        a_function();
+        samples.push_back(chrono::duration<double, milli>(Clock::now() - start).count());
+    }
+    return samples;
+}
+
+static string modelName(DistortionType a_type)
+{
+    switch (a_type) {
+    case DistortionType::PINHOLE:
+        return "pinhole";
+    case DistortionType::FISHEYE:
+        return "fisheye";
+    case DistortionType::PANOTOOL:
+        return "panotool";
+    case DistortionType::REMAP:
+        return "remap";
+    case DistortionType::DOUBLE_SPHERE:
+        return "double_sphere";
+    }
+    return "unknown";
+}
+
+static string jsonEscape(const string &a_value)
+{
+    string escaped;
+    for (size_t i = 0 ; i < a_value.size() ; i++){
+        char c = a_value[i];
+        if (c == '"' || c == '\\'){
+            escaped += '\\';
+            escaped += c;
+        }
+        else if ((unsigned char)c < 0x20){
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else{
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static bool writeJson(const string &a_filename, const string &a_renderer, const vector<BenchResult> &a_results)
+{
+    ofstream file(a_filename.c_str());
+    if (!file){
+        cerr << "ERROR! Can't write " << a_filename << endl;
+        return false;
+    }
+    file << setprecision(6);
+    file << "{\n";
+    file << "  \"version\": 1,\n";
+    file << "  \"best_isa\": \"" << camdistort::getIsaName(camdistort::getBestIsa()) << "\",\n";
+    file << "  \"threads\": " << thread::hardware_concurrency() << ",\n";
+    file << "  \"gpu_renderer\": \"" << jsonEscape(a_renderer) << "\",\n";
+    file << "  \"results\": [\n";
+    for (size_t i = 0 ; i < a_results.size() ; i++){
+        const BenchResult &result = a_results[i];
+        file << "    {\"name\": \"" << result.name << "\", \"model\": \"" << result.model
+             << "\", \"config\": \"" << jsonEscape(result.config) << "\", \"width\": " << result.width
+             << ", \"height\": " << result.height << ", \"isa\": \"" << result.isa
+             << "\", \"iterations\": " << result.samplesMs.size()
+             << ", \"min_ms\": " << percentile(result.samplesMs, 0.0)
+             << ", \"median_ms\": " << percentile(result.samplesMs, 0.5)
+             << ", \"mean_ms\": " << mean(result.samplesMs)
+             << ", \"p95_ms\": " << percentile(result.samplesMs, 0.95)
+             << ", \"max_ms\": " << percentile(result.samplesMs, 1.0) << "}"
+             << (i + 1 < a_results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return true;
+}
+
+static void printResult(const BenchResult &a_result)
+{
+    cout << left << setw(14) << a_result.model << setw(11)
+         << (to_string(a_result.width) + "x" + to_string(a_result.height)) << setw(32) << a_result.name
+         << setw(8) << a_result.isa << right << fixed << setprecision(3)
+         << setw(10) << percentile(a_result.samplesMs, 0.5) << " ms (min "
+         << percentile(a_result.samplesMs, 0.0) << ")" << endl;
+}
+
+static vector<Size> parseSizes(const string &a_list)
+{
+    vector<Size> sizes;
+    stringstream stream(a_list);
+    string item;
+    while (getline(stream, item, ',')){
+        Size size;
+        if (sscanf(item.c_str(), "%dx%d", &size.width, &size.height) == 2 && size.width > 0 && size.height > 0){
+            sizes.push_back(size);
+        }
+        else{
+            cerr << "WARNING! Ignoring size " << item << endl;
+        }
+    }
+    return sizes;
+}
+
+static void benchCpu(const CameraParams &a_params, const string &a_config, const Size &a_size, int a_iterations,
+                     vector<BenchResult> &a_results)
+{
+    size_t numPixels = (size_t)a_size.width * a_size.height;
+    vector<float> warpMap(numPixels * 4);
+    string model = modelName(a_params.distortion_type);
+
+    vector<camdistort::Isa> isas(1, camdistort::Isa::SCALAR);
+    if (camdistort::getBestIsa() != camdistort::Isa::SCALAR){
+        isas.push_back(camdistort::getBestIsa());
+    }
+
+    for (size_t i = 0 ; i < isas.size() ; i++){
+        for (int direction = 0 ; direction < 2 ; direction++){
+            camdistort::WarpMapOptions options;
+            options.isa = isas[i];
+            options.direction = direction == 0 ? camdistort::WarpDirection::FORWARD : camdistort::WarpDirection::INVERSE;
+            BenchResult result = {model, a_config, a_size.width, a_size.height,
+                                  direction == 0 ? "cpu.warp_map.forward" : "cpu.warp_map.inverse",
+                                  camdistort::getIsaName(isas[i]), vector<double>()};
+            result.samplesMs = timeCpu([&]{ camdistort::buildWarpMap(a_params, a_size.width, a_size.height, warpMap.data(), options); },
+                                       a_iterations);
+            printResult(result);
+            a_results.push_back(result);
+        }
+    }
+
+    // Remap a synthetic frame of the same size through the forward map
+    camdistort::buildWarpMap(a_params, a_size.width, a_size.height, warpMap.data());
+    vector<uint8_t> source(numPixels * 4), target(numPixels * 4);
+    vector<float> depth(numPixels), depthTarget(numPixels);
+    for (size_t i = 0 ; i < numPixels ; i++){
+        source[i * 4 + 0] = (uint8_t)(i * 7);
+        source[i * 4 + 1] = (uint8_t)(i * 13);
+        source[i * 4 + 2] = (uint8_t)(i * 29);
+        source[i * 4 + 3] = 255;
+        depth[i] = (float)(i % 1000) / 1000.0f;
+    }
+
+    for (size_t i = 0 ; i < isas.size() ; i++){
+        camdistort::RemapOptions options;
+        options.isa = isas[i];
+        BenchResult rgba = {model, a_config, a_size.width, a_size.height, "cpu.remap.rgba8", camdistort::getIsaName(isas[i]), vector<double>()};
+        rgba.samplesMs = timeCpu([&]{ camdistort::remapRGBA8(source.data(), a_size.width, a_size.height, warpMap.data(), a_size.width, a_size.height,
+                                                             a_params.aberr_scale, target.data(), options); }, a_iterations);
+        printResult(rgba);
+        a_results.push_back(rgba);
+
+        BenchResult depthResult = {model, a_config, a_size.width, a_size.height, "cpu.remap.depth", camdistort::getIsaName(isas[i]), vector<double>()};
+        depthResult.samplesMs = timeCpu([&]{ camdistort::remapDepth(depth.data(), a_size.width, a_size.height, warpMap.data(), a_size.width, a_size.height,
+                                                                    depthTarget.data(), options); }, a_iterations);
+        printResult(depthResult);
+        a_results.push_back(depthResult);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    string configDir = CAMERA_DISTORTION_SOURCE_DIR "/example/config_file";
+    string shaderDir = CAMERA_DISTORTION_SOURCE_DIR "/example/shaders";
+    string jsonFile;
+    vector<Size> sizes = parseSizes("640x480,1280x720,1920x1080,3840x2160");
+    int iterations = 10;
+    bool runCpu = true;
+    bool runGpu = true;
+
+    for (int i = 1 ; i < argc ; i++){
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--configs" && hasValue){
+            configDir = argv[++i];
+        }
+        else if (arg == "--shaders" && hasValue){
+            shaderDir = argv[++i];
+        }
+        else if (arg == "--sizes" && hasValue){
+            sizes = parseSizes(argv[++i]);
+        }
+        else if (arg == "--iterations" && hasValue){
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--json" && hasValue){
+            jsonFile = argv[++i];
+        }
+        else if (arg == "--no-cpu"){
+            runCpu = false;
+        }
+        else if (arg == "--no-gpu"){
+            runGpu = false;
+        }
+        else{
+            cerr << "Usage: " << argv[0] << " [--configs dir] [--shaders dir] [--sizes WxH,...] [--iterations N] [--json file] [--no-cpu] [--no-gpu]" << endl;
+            return 1;
+        }
+    }
+
+    // The standard inputs, one calibration per model
+    const char* configNames[] = {"example_pinhole.yaml", "example_fisheye.yaml", "example_panotool.yaml", "example_double_sphere.yaml"};
+    vector<CameraParams> params;
+    vector<string> configs;
+    for (size_t i = 0 ; i < sizeof(configNames) / sizeof(configNames[0]) ; i++){
+        CameraParams cameraParams;
+        string filename = configDir + "/" + configNames[i];
+        if (!readCameraParams(filename, cameraParams)){
+            cerr << "ERROR! Can't read " << filename << endl;
+            return 1;
+        }
+        params.push_back(cameraParams);
+        configs.push_back(configNames[i]);
+    }
+
+    vector<BenchResult> results;
+    string renderer;
+
+    if (runCpu){
+        cout << "CPU (" << thread::hardware_concurrency() << " threads, best ISA "
+             << camdistort::getIsaName(camdistort::getBestIsa()) << ")" << endl;
+        for (size_t p = 0 ; p < params.size() ; p++){
+            for (size_t s = 0 ; s < sizes.size() ; s++){
+                benchCpu(params[p], configs[p], sizes[s], iterations, results);
+            }
+        }
+    }
+
+    if (runGpu){
+#ifdef CAMERA_DISTORTION_BENCH_HAVE_EGL
+        GLBench gl;
+        if (gl.init(shaderDir + "/camera_distortion.vs", shaderDir + "/camera_distortion.fs")){
+            renderer = gl.getRenderer();
+            cout << "GPU (" << renderer << ")" << endl;
+            for (size_t p = 0 ; p < params.size() ; p++){
+                for (size_t s = 0 ; s < sizes.size() ; s++){
+                    // generic analytic, specialized analytic, warp map
+                    for (int pass = 0 ; pass < 3 ; pass++){
+                        const char* names[3] = {"gpu.pass.analytic", "gpu.pass.analytic_variant", "gpu.pass.warp_map"};
+                        string name = names[pass];
+                        string defines = pass == 1 ? camdistort::getShaderDefines(params[p]) : string();
+                        BenchResult result = {modelName(params[p].distortion_type), configs[p], sizes[s].width, sizes[s].height,
+                                              name, "gl", vector<double>()};
+                        BenchResult wall = result;
+                        wall.name = name + ".wall";
+                        if (gl.timePass(params[p], sizes[s].width, sizes[s].height, pass == 2, iterations, result.samplesMs, wall.samplesMs, defines)){
+                            printResult(result);
+                            printResult(wall);
+                            results.push_back(result);
+                            results.push_back(wall);
+                        }
+                    }
+                }
+            }
+        }
+        else{
+            cerr << "WARNING! No offscreen OpenGL context, skipping GPU timings" << endl;
+        }
+#else
+        cerr << "WARNING! Built without EGL, skipping GPU timings" << endl;
+#endif
+    }
+
+    if (!jsonFile.empty()){
+        if (!writeJson(jsonFile, renderer, results)){
+            return 1;
+        }
+        cout << "Wrote " << results.size() << " results to " << jsonFile << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,336 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#define GL_GLEXT_PROTOTYPES
+#include "gl_bench.h"
+#include "camdistort.h"
+#include <chrono>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static bool readFile(const string &a_filename, string &a_source)
+{
+    ifstream file(a_filename.c_str());
+    if (!file){
+        cerr << "ERROR! Can't open " << a_filename << endl;
+        return false;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    a_source = buffer.str();
+    return true;
+}
+
+static GLuint compileShader(GLenum a_type, const string &a_source, const string &a_name)
+{
+    GLuint shader = glCreateShader(a_type);
+    const char* source = a_source.c_str();
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status){
+        char log[4096];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        cerr << "ERROR! Compiling " << a_name << ": " << log << endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLBench::GLBench()
+{
+    m_display = EGL_NO_DISPLAY;
+    m_context = EGL_NO_CONTEXT;
+}
+
+GLBench::~GLBench()
+{
+    shutdown();
+}
+
+bool GLBench::init(const string &a_vertexShader, const string &a_fragmentShader)
+{
+    // Surfaceless display first so that no X server is needed
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay){
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY){
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)){
+        cerr << "ERROR! No EGL display" << endl;
+        return false;
+    }
+    m_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)){
+        cerr << "ERROR! EGL has no desktop OpenGL" << endl;
+        return false;
+    }
+    const EGLint configAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+    // The shaders use the fixed function built-ins, so ask for a compatibility context
+    const EGLint contextAttribs[] = {EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE};
+    EGLContext context = eglCreateContext(display, numConfigs > 0 ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        cerr << "ERROR! Can't create a surfaceless OpenGL context (0x" << hex << eglGetError() << dec << ")" << endl;
+        return false;
+    }
+    m_context = context;
+    m_renderer = (const char*)glGetString(GL_RENDERER);
+
+    if (!readFile(a_vertexShader, m_vertexSource) || !readFile(a_fragmentShader, m_fragmentSource)){
+        return false;
+    }
+    return getProgram("") != 0;
+}
+
+// Defines go after the #version line, as in afResourceCache
+static string insertDefines(const string &a_source, const string &a_defines)
+{
+    size_t insertAt = 0;
+    size_t version = a_source.find("#version");
+    if (version != string::npos && a_source.find_first_not_of(" \t\r\n") == version){
+        insertAt = a_source.find('\n', version);
+        insertAt = insertAt == string::npos ? a_source.size() : insertAt + 1;
+    }
+    return a_source.substr(0, insertAt) + a_defines + a_source.substr(insertAt);
+}
+
+unsigned GLBench::getProgram(const string &a_defines)
+{
+    map<string, unsigned>::iterator it = m_programs.find(a_defines);
+    if (it != m_programs.end()){
+        return it->second;
+    }
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, insertDefines(m_vertexSource, a_defines), "camera_distortion.vs");
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, insertDefines(m_fragmentSource, a_defines), "camera_distortion.fs");
+    if (!vertexShader || !fragmentShader){
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glBindAttribLocation(program, 1, "aTexCoord");
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status){
+        char log[4096];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        cerr << "ERROR! Linking the distortion program: " << log << endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    m_programs[a_defines] = program;
+    return program;
+}
+
+void GLBench::shutdown()
+{
+    if (m_context != EGL_NO_CONTEXT){
+        for (map<string, unsigned>::iterator it = m_programs.begin() ; it != m_programs.end() ; ++it){
+            glDeleteProgram(it->second);
+        }
+        m_programs.clear();
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    if (m_display != EGL_NO_DISPLAY){
+        eglTerminate(m_display);
+        m_display = EGL_NO_DISPLAY;
+    }
+}
+
+static GLuint createTexture(GLint a_internalFormat, int a_width, int a_height, GLenum a_format, GLenum a_type, const void* a_data, GLint a_filter)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, a_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, a_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, a_internalFormat, a_width, a_height, 0, a_format, a_type, a_data);
+    return texture;
+}
+
+bool GLBench::timePass(const CameraParams &a_params, int a_width, int a_height, bool a_useWarpMap, int a_iterations,
+                       vector<double> &a_gpuMs, vector<double> &a_wallMs, const string &a_defines)
+{
+    GLuint program = getProgram(a_defines);
+    if (!program){
+        return false;
+    }
+
+    // Checkerboard source, as rendered into the scene framebuffer by the plugin
+    vector<unsigned char> source((size_t)a_width * a_height * 4);
+    for (int y = 0 ; y < a_height ; y++){
+        for (int x = 0 ; x < a_width ; x++){
+            unsigned char value = (((x / 32) + (y / 32)) & 1) ? 255 : 32;
+            unsigned char* pixel = &source[((size_t)y * a_width + x) * 4];
+            pixel[0] = value;
+            pixel[1] = (unsigned char)(x * 255 / a_width);
+            pixel[2] = (unsigned char)(y * 255 / a_height);
+            pixel[3] = 255;
+        }
+    }
+    GLuint sourceTexture = createTexture(GL_RGBA8, a_width, a_height, GL_RGBA, GL_UNSIGNED_BYTE, source.data(), GL_LINEAR);
+
+    GLuint warpTexture = 0;
+    if (a_useWarpMap){
+        vector<float> warpMap((size_t)a_width * a_height * 4);
+        camdistort::buildWarpMap(a_params, a_width, a_height, warpMap.data());
+        warpTexture = createTexture(GL_RGBA32F, a_width, a_height, GL_RGBA, GL_FLOAT, warpMap.data(), GL_NEAREST);
+    }
+
+    GLuint targetTexture = createTexture(GL_RGBA8, a_width, a_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST);
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targetTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Same texture units and uniforms as afCameraDistortionPlugin::updateCameraParams()
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, sourceTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, warpTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "WarpTexture"), 2);
+    glUniform1i(glGetUniformLocation(program, "WarpMap"), 3);
+    glUniform1i(glGetUniformLocation(program, "UseWarpMap"), a_useWarpMap);
+    glUniform1i(glGetUniformLocation(program, "WriteDepth"), 0);
+    glUniform1i(glGetUniformLocation(program, "DistortionType"), static_cast<int>(a_params.distortion_type));
+    glUniform3fv(glGetUniformLocation(program, "ChromaticAberr"), 1, a_params.aberr_scale);
+    glUniform2fv(glGetUniformLocation(program, "LensCenter"), 1, a_params.lens_center);
+    glUniform2f(glGetUniformLocation(program, "Center"), a_params.cx, a_params.cy);
+    glUniform2f(glGetUniformLocation(program, "FocalLength"), a_params.fx, a_params.fy);
+    glUniform2f(glGetUniformLocation(program, "ImageSize"), a_params.width, a_params.height);
+    glUniform2f(glGetUniformLocation(program, "WindowSize"), (float)a_width, (float)a_height);
+    glUniform4fv(glGetUniformLocation(program, "RadialDistortion"), 1, a_params.radial_distortion_coeffs);
+    glUniform2fv(glGetUniformLocation(program, "TangentialDistortion"), 1, a_params.tangential_distortion_coeffs);
+    glUniform3fv(glGetUniformLocation(program, "RationalDistortion"), 1, a_params.rational_distortion_coeffs);
+    glUniform4fv(glGetUniformLocation(program, "ThinPrism"), 1, a_params.thin_prism_coeffs);
+    double tilt[9];
+    camdistort::computeTiltMatrix(a_params.tilt[0], a_params.tilt[1], tilt);
+    for (int i = 0 ; i < 3 ; i++){
+        string name = "TiltMatrix[" + to_string(i) + "]";
+        glUniform3f(glGetUniformLocation(program, name.c_str()), (float)tilt[3 * i], (float)tilt[3 * i + 1], (float)tilt[3 * i + 2]);
+    }
+    glUniform1i(glGetUniformLocation(program, "Blackout"), a_params.blackout);
+    glUniform4f(glGetUniformLocation(program, "SourceRect"), 0.0f, 0.0f, 1.0f, 1.0f);
+
+    // Full screen quad as two triangles, texture coordinates through aTexCoord
+    const float positions[] = {-1, 1, 0,  -1, -1, 0,  1, -1, 0,  -1, 1, 0,  1, -1, 0,  1, 1, 0};
+    const float texCoords[] = {0, 1, 1,  0, 0, 1,  1, 0, 1,  0, 1, 1,  1, 0, 1,  1, 1, 1};
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, positions);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, texCoords);
+    glViewport(0, 0, a_width, a_height);
+    glDisable(GL_DEPTH_TEST);
+
+    vector<GLuint> queries(a_iterations + 1);
+    glGenQueries((GLsizei)queries.size(), queries.data());
+    // The first pass is a warm-up that absorbs shader compilation in the driver
+    typedef chrono::steady_clock Clock;
+    a_wallMs.clear();
+    glFinish();
+    for (size_t i = 0 ; i < queries.size() && complete ; i++){
+        Clock::time_point start = Clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[i]);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        if (i > 0){
+            a_wallMs.push_back(chrono::duration<double, milli>(Clock::now() - start).count());
+        }
+    }
+    a_gpuMs.clear();
+    for (size_t i = 1 ; i < queries.size() && complete ; i++){
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+        a_gpuMs.push_back(elapsed * 1e-6);
+    }
+    glDeleteQueries((GLsizei)queries.size(), queries.data());
+
+    glDisableVertexAttribArray(1);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glUseProgram(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &targetTexture);
+    glDeleteTextures(1, &sourceTexture);
+    if (warpTexture){
+        glDeleteTextures(1, &warpTexture);
+    }
+
+    GLenum error = glGetError();
+    if (!complete || error != GL_NO_ERROR){
+        cerr << "ERROR! Distortion pass failed at [" << a_width << "x" << a_height << "] (0x" << hex << error << dec << ")" << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef GL_BENCH_H
+#define GL_BENCH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "camera_params.h"
+
+// Times the distortion pass of example/shaders/camera_distortion.* on an offscreen
+// EGL context (no window system needed, works with Mesa llvmpipe) using
+// GL_TIME_ELAPSED queries.
+class GLBench {
+public:
+    GLBench();
+    ~GLBench();
+
+    bool init(const std::string &a_vertexShader, const std::string &a_fragmentShader);
+    void shutdown();
+
+    // Renderer string of the context, for the report
+    std::string getRenderer() const { return m_renderer; }
+
+    // Time a_iterations distortion passes from a width x height source into a
+    // width x height target. a_gpuMs is the timer query result, a_wallMs the CPU time
+    // of the draw including glFinish (software renderers like llvmpipe rasterize
+    // after the query has ended). a_useWarpMap selects the precomputed lookup
+    // instead of the analytic model. a_defines selects a specialized program
+    // variant (see camdistort::getShaderDefines()), empty for the generic one.
+    bool timePass(const CameraParams &a_params, int a_width, int a_height, bool a_useWarpMap, int a_iterations,
+                  std::vector<double> &a_gpuMs, std::vector<double> &a_wallMs, const std::string &a_defines = "");
+
+protected:
+    // Program of the shader sources with a_defines, compiled on first use
+    unsigned getProgram(const std::string &a_defines);
+
+    void* m_display;
+    void* m_context;
+    std::string m_vertexSource, m_fragmentSource;
+    std::map<std::string, unsigned> m_programs;
+    std::string m_renderer;
+};
+
+#endif
@@ -1,3 +1,47 @@
+// Variant defines, injected by the plugin after the version line (see
+// afCameraDistortionPlugin::getShaderDefines()). Without them this is the generic
+// program that selects everything at runtime through the uniforms.
+// DISTORTION_MODEL: DistortionType of the analytic path, -1 reads the uniform
+#ifndef DISTORTION_MODEL
+#define DISTORTION_MODEL -1
+#endif
+// CHROMATIC: 0 samples all channels at the green coordinate with a single fetch
+#ifndef CHROMATIC
+#define CHROMATIC 1
+#endif
+// BLACKOUT: 0 or 1, -1 reads the uniform
+#ifndef BLACKOUT
+#define BLACKOUT -1
+#endif
+// Pinhole terms, 0 drops terms whose coefficients are all zero
+#ifndef PINHOLE_TANGENTIAL
+#define PINHOLE_TANGENTIAL 1
+#endif
+#ifndef PINHOLE_RATIONAL
+#define PINHOLE_RATIONAL 1
+#endif
+#ifndef PINHOLE_THIN_PRISM
+#define PINHOLE_THIN_PRISM 1
+#endif
+#ifndef PINHOLE_TILT
+#define PINHOLE_TILT 1
+#endif
+// ROLLING_SHUTTER: 0 or 1, -1 reads the uniform
+#ifndef ROLLING_SHUTTER
+#define ROLLING_SHUTTER -1
+#endif
+// FILTERED_SAMPLING: 0 samples the scene without its mip pyramid
+#ifndef FILTERED_SAMPLING
+#define FILTERED_SAMPLING 1
+#endif
+
+#if FILTERED_SAMPLING && defined(GL_ARB_shader_texture_lod)
+#extension GL_ARB_shader_texture_lod : enable
+#define SCENE_GRADIENTS 1
+#else
+#define SCENE_GRADIENTS 0
+#endif
+
 //per eye texture to warp for lens distortion
 uniform sampler2D WarpTexture;
 
@@ -14,11 +58,14 @@ uniform vec2 Center;
 uniform vec2 FocalLength;
 
 // Distortion Type
-uniform int DistortionType;       // 0 = Pinhole, 1 = Fisheye, 2 = PanoTool
+uniform int DistortionType;       // 0 = Pinhole, 1 = Fisheye, 2 = PanoTool, 3 = Remap, 4 = Double sphere
 
 //Distoriton coefficients 
-uniform vec4 RadialDistortion;   // k1, k2, k3, k4 (if fisheye, only k1-k4 matter)
+uniform vec4 RadialDistortion;   // k1, k2, k3, k4 (if fisheye, only k1-k4 matter, double sphere: xi, alpha)
 uniform vec2 TangentialDistortion; // p1, p2
+uniform vec3 RationalDistortion; // k4, k5, k6 of the pinhole denominator
+uniform vec4 ThinPrism;          // s1, s2, s3, s4
+uniform vec3 TiltMatrix[3];      // rows of the tilted sensor projection
 
 //chromatic distortion post scaling
 uniform vec3 ChromaticAberr;
@@ -26,10 +73,392 @@ uniform vec3 ChromaticAberr;
 // Whether to overlay blackout for circular viewing region
 uniform bool Blackout;
 
-void main()
-{   
-    // Normalized texture coordinate [0,1]
-    vec2 output_loc = gl_TexCoord[0].xy;
+#if BLACKOUT < 0
+#define BLACKOUT_ENABLED Blackout
+#elif BLACKOUT == 0
+#define BLACKOUT_ENABLED false
+#else
+#define BLACKOUT_ENABLED true
+#endif
+
+// Precomputed lookup (u_g, v_g, d_u, d_v) built by the plugin, see afWarpMap
+uniform sampler2D WarpMap;
+uniform bool UseWarpMap;
+
+// type: remap, WarpMap holds the source pixel (x, y) of every pixel of the map file,
+// or its offset from the pixel at the same relative position, see camdistort::RemapFile
+uniform bool UseRemap;
+uniform bool RemapOffsets;
+uniform vec2 RemapSourceSize;
+
+// Scene depth, warped and linearized into the second render target when the plugin
+// captures depth. Sampled at texel centers (the plugin sets nearest filtering), so
+// depths are never blended across object edges.
+uniform sampler2D DepthTexture;
+uniform bool WriteDepth;
+// Near and far clipping planes of the scene pass
+uniform vec2 DepthRange;
+// Closest of the 2x2 texels around the sample instead of the nearest one
+uniform bool DepthFilterMin;
+// Size of the scene textures in texels
+uniform vec2 DepthTextureSize;
+
+// Rolling shutter and motion blur, see afRollingShutter. Rows are read out top to
+// bottom over ReadoutTime and each integrates ExposureTime, around the scene pass at
+// the middle of the readout.
+uniform bool RollingShutter;
+uniform float ReadoutTime;
+uniform float ExposureTime;
+// Poses averaged over the exposure, at most MAX_SHUTTER_SAMPLES
+uniform int ShutterSamples;
+// Camera motion per second in its own frame (x right, y down, z along the view)
+uniform vec3 CameraVelocity;
+uniform vec3 CameraAngularVelocity;
+
+// Region of the full camera image the scene textures cover: (u0, v0, 1 / width, 1 / height)
+uniform vec4 SourceRect;
+
+// Full frame texture coordinate to scene texture coordinate
+vec2 toSource(vec2 tc)
+{
+    return (tc - SourceRect.xy) * SourceRect.zw;
+}
+
+// Cube source for lenses past 120 degrees: WarpMap holds the ray (x, y, z, valid) of every
+// output pixel and the scene is rendered into the cropped faces, see afCubeSource
+uniform bool UseCubeMap;
+uniform sampler2D CubeFace0;
+uniform sampler2D CubeFace1;
+uniform sampler2D CubeFace2;
+uniform sampler2D CubeFace3;
+uniform sampler2D CubeFace4;
+uniform sampler2D CubeFace5;
+// Region of every face its texture covers, as SourceRect
+uniform vec4 CubeRect[6];
+
+// Scale the angle to the optical axis, chromatic aberration of the direction map
+vec3 aberrate(vec3 d, float s)
+{
+    float lateral = length(d.xy);
+    if (lateral <= 0.0 || s == 1.0){
+        return d;
+    }
+    float theta = acos(clamp(d.z, -1.0, 1.0)) * s;
+    return vec3(d.xy * (sin(theta) / lateral), cos(theta));
+}
+
+// Face order and bases match camdistort::getCubeFaceBasis(), ties go to z then x
+vec4 sampleCube(vec3 d)
+{
+    vec3 a = abs(d);
+    vec3 look;
+    vec3 right;
+    vec3 up;
+    int face;
+    if (a.z >= a.x && a.z >= a.y){
+        face = (d.z >= 0.0) ? 0 : 5;
+        look = vec3(0.0, 0.0, (d.z >= 0.0) ? 1.0 : -1.0);
+        right = vec3(look.z, 0.0, 0.0);
+        up = vec3(0.0, -1.0, 0.0);
+    }
+    else if (a.x >= a.y){
+        face = (d.x >= 0.0) ? 1 : 2;
+        look = vec3((d.x >= 0.0) ? 1.0 : -1.0, 0.0, 0.0);
+        right = vec3(0.0, 0.0, -look.x);
+        up = vec3(0.0, -1.0, 0.0);
+    }
+    else{
+        face = (d.y >= 0.0) ? 4 : 3;
+        look = vec3(0.0, (d.y >= 0.0) ? 1.0 : -1.0, 0.0);
+        right = vec3(1.0, 0.0, 0.0);
+        up = vec3(0.0, 0.0, look.y);
+    }
+    vec2 uv = 0.5 + 0.5 * vec2(dot(d, right), dot(d, up)) / dot(d, look);
+
+    // samplers can not be indexed dynamically in GLSL 1.20
+    if (face == 0) return texture2D(CubeFace0, (uv - CubeRect[0].xy) * CubeRect[0].zw);
+    if (face == 1) return texture2D(CubeFace1, (uv - CubeRect[1].xy) * CubeRect[1].zw);
+    if (face == 2) return texture2D(CubeFace2, (uv - CubeRect[2].xy) * CubeRect[2].zw);
+    if (face == 3) return texture2D(CubeFace3, (uv - CubeRect[3].xy) * CubeRect[3].zw);
+    if (face == 4) return texture2D(CubeFace4, (uv - CubeRect[4].xy) * CubeRect[4].zw);
+    return texture2D(CubeFace5, (uv - CubeRect[5].xy) * CubeRect[5].zw);
+}
+
+#if SCENE_GRADIENTS
+// Footprint of the pixel on the scene texture, see setFootprint()
+vec2 SceneDx = vec2(0.0);
+vec2 SceneDy = vec2(0.0);
+#endif
+
+// Record the footprint of the pixel on the scene: the screen-space derivatives of its
+// coordinate are the Jacobian of the active lens model (or of the map) over one pixel.
+// They drive the mip level and the anisotropic filter of the scene texture when the
+// plugin generates its mipmaps. Taken here, in uniform control flow, rather than
+// implicitly inside the branches. Quads straddling invalid map texels keep the base level.
+void setFootprint(vec2 tc, bool valid)
+{
+#if SCENE_GRADIENTS
+    vec2 dx = dFdx(tc) * SourceRect.zw;
+    vec2 dy = dFdy(tc) * SourceRect.zw;
+    bool mixed = fwidth(valid ? 1.0 : 0.0) > 0.0;
+    SceneDx = mixed ? vec2(0.0) : dx;
+    SceneDy = mixed ? vec2(0.0) : dy;
+#endif
+}
+
+vec4 fetchScene(vec2 tc)
+{
+#if SCENE_GRADIENTS
+    return texture2DGradARB(WarpTexture, toSource(tc), SceneDx, SceneDy);
+#else
+    return texture2D(WarpTexture, toSource(tc));
+#endif
+}
+
+// Scene color at the per-channel coordinates (already in full frame texture space)
+vec4 sampleScene(vec2 tc_r, vec2 tc_g, vec2 tc_b)
+{
+#if CHROMATIC
+    return vec4(fetchScene(tc_r).r, fetchScene(tc_g).g, fetchScene(tc_b).b, 1.0);
+#else
+    return vec4(fetchScene(tc_g).rgb, 1.0);
+#endif
+}
+
+// Lens models on normalized camera coordinates, only the selected one is compiled into a variant
+#if DISTORTION_MODEL < 0 || DISTORTION_MODEL == 0
+vec2 distortPinhole(vec2 r)
+{
+    float r2 = dot(r, r);
+    float r4 = r2 * r2;
+    float r6 = r4 * r2;
+
+    float radial_factor = 1.0 + RadialDistortion.x * r2 +
+                                RadialDistortion.y * r4 +
+                                RadialDistortion.z * r6;
+#if PINHOLE_RATIONAL
+    radial_factor /= 1.0 + RationalDistortion.x * r2 + RationalDistortion.y * r4 + RationalDistortion.z * r6;
+#endif
+    vec2 r_displaced = r * radial_factor;
+
+#if PINHOLE_TANGENTIAL
+    // Tangential distortion
+    r_displaced.x += 2.0 * TangentialDistortion.x * r.x * r.y + TangentialDistortion.y * (r2 + 2.0 * r.x * r.x);
+    r_displaced.y += TangentialDistortion.x * (r2 + 2.0 * r.y * r.y) + 2.0 * TangentialDistortion.y * r.x * r.y;
+#endif
+#if PINHOLE_THIN_PRISM
+    r_displaced += vec2(ThinPrism.x * r2 + ThinPrism.y * r4, ThinPrism.z * r2 + ThinPrism.w * r4);
+#endif
+#if PINHOLE_TILT
+    vec3 tilted = vec3(r_displaced, 1.0);
+    tilted = vec3(dot(TiltMatrix[0], tilted), dot(TiltMatrix[1], tilted), dot(TiltMatrix[2], tilted));
+    r_displaced = tilted.xy / tilted.z;
+#endif
+    return r_displaced;
+}
+#endif
+
+#if DISTORTION_MODEL < 0 || DISTORTION_MODEL == 1
+vec2 distortFisheye(vec2 r)
+{
+    float r_mag = length(r);
+    float theta = atan(r_mag);
+    float theta2 = theta * theta;
+    float theta4 = theta2 * theta2;
+    float theta6 = theta4 * theta2;
+    float theta8 = theta4 * theta4;
+
+    float theta_d = theta * (1.0 + RadialDistortion.x * theta2 +
+                                   RadialDistortion.y * theta4 +
+                                   RadialDistortion.z * theta6 +
+                                   RadialDistortion.w * theta8);
+
+    return (r_mag > 0.0) ? (r / r_mag) * tan(theta_d) : r;
+}
+#endif
+
+#if DISTORTION_MODEL < 0 || DISTORTION_MODEL == 2
+vec2 distortPanotool(vec2 r)
+{
+    float r_mag = length(r);
+    return r * (RadialDistortion.w + RadialDistortion.z * r_mag +
+        RadialDistortion.y * r_mag * r_mag +
+        RadialDistortion.x * r_mag * r_mag * r_mag);
+}
+#endif
+
+#if DISTORTION_MODEL < 0 || DISTORTION_MODEL == 4
+// Double sphere projection of the ray (r, 1), xi and alpha in RadialDistortion.xy
+vec2 distortDoubleSphere(vec2 r)
+{
+    float r2 = dot(r, r);
+    float w = RadialDistortion.x * sqrt(r2 + 1.0) + 1.0;
+    return r / (RadialDistortion.y * sqrt(r2 + w * w) + (1.0 - RadialDistortion.y) * w);
+}
+#endif
+
+vec2 distort(vec2 r)
+{
+#if DISTORTION_MODEL == 0
+    return distortPinhole(r);
+#elif DISTORTION_MODEL == 1
+    return distortFisheye(r);
+#elif DISTORTION_MODEL == 2
+    return distortPanotool(r);
+#elif DISTORTION_MODEL == 4
+    return distortDoubleSphere(r);
+#elif DISTORTION_MODEL >= 0
+    // type: remap is only sampled through its map
+    return r;
+#else
+    if (DistortionType == 0) return distortPinhole(r);
+    if (DistortionType == 1) return distortFisheye(r);
+    if (DistortionType == 2) return distortPanotool(r);
+    if (DistortionType == 4) return distortDoubleSphere(r);
+    return r;
+#endif
+}
+
+// Distance along the optical axis in world units, 0 where nothing was rendered
+float linearDepth(float d)
+{
+    return (d >= 1.0) ? 0.0 : DepthRange.x * DepthRange.y / (DepthRange.y - d * (DepthRange.y - DepthRange.x));
+}
+
+#if ROLLING_SHUTTER != 0
+#define MAX_SHUTTER_SAMPLES 16
+
+// Rotate v by the rotation vector w
+vec3 rotate(vec3 v, vec3 w)
+{
+    float theta = length(w);
+    if (theta < 1e-6){
+        return v + cross(w, v);
+    }
+    vec3 k = w / theta;
+    return v * cos(theta) + cross(k, v) * sin(theta) + k * dot(k, v) * (1.0 - cos(theta));
+}
+
+// Scene color of the pixel as the sensor reads it: the camera ray through tc_g, at the
+// depth the scene pass found along it, is moved to the pose of every exposure sample
+// and projected back into the scene pass. Nothing hit only rotates with the camera.
+vec4 sampleSensor(vec2 tc_r, vec2 tc_g, vec2 tc_b)
+{
+#if ROLLING_SHUTTER < 0
+    if (!RollingShutter){
+        return sampleScene(tc_r, tc_g, tc_b);
+    }
+#endif
+    vec2 SubWindowSize = vec2(WindowSize.y * (ImageSize.x / ImageSize.y), WindowSize.y);
+    vec2 SubWindowOffset = vec2((WindowSize.x - SubWindowSize.x) / 2.0, 0.0);
+    vec2 LensCenter = Center * SubWindowSize / ImageSize / WindowSize + SubWindowOffset / WindowSize;
+    // Normalized camera coordinates to full frame texture coordinates, y down
+    vec2 scale = FocalLength * SubWindowSize / ImageSize / WindowSize;
+
+    vec3 ray = vec3((vec2(tc_g.x, 1.0 - tc_g.y) - LensCenter) / scale, 1.0);
+    float depth = linearDepth(texture2D(DepthTexture, toSource(tc_g)).r);
+    // Seconds from the scene pass to the middle of the exposure of this row
+    float rowTime = (0.5 - gl_TexCoord[0].y) * ReadoutTime;
+
+    vec4 color = vec4(0.0);
+    for (int i = 0 ; i < MAX_SHUTTER_SAMPLES ; i++){
+        if (i >= ShutterSamples){
+            break;
+        }
+        float t = rowTime + ExposureTime * ((float(i) + 0.5) / float(ShutterSamples) - 0.5);
+        vec3 p = rotate(ray, CameraAngularVelocity * t);
+        if (depth > 0.0){
+            p = p * depth + CameraVelocity * t;
+        }
+        vec2 shift = vec2(0.0);
+        if (p.z > 0.0){
+            vec2 tc = LensCenter + p.xy / p.z * scale;
+            shift = vec2(tc.x, 1.0 - tc.y) - tc_g;
+        }
+        color += sampleScene(tc_r + shift, tc_g + shift, tc_b + shift);
+    }
+    return color / float(ShutterSamples);
+}
+#else
+#define sampleSensor sampleScene
+#endif
+
+void writeDepth(vec2 tc, bool valid)
+{
+    if (!WriteDepth || !valid){
+        gl_FragData[1] = vec4(0.0);
+        return;
+    }
+    vec2 st = toSource(tc);
+    float depth;
+    if (DepthFilterMin){
+        // Centers of the bilinear footprint, the nearest surface wins
+        vec2 texel = 1.0 / DepthTextureSize;
+        vec2 base = (floor(st * DepthTextureSize - 0.5) + 0.5) * texel;
+        depth = min(min(texture2D(DepthTexture, base).r, texture2D(DepthTexture, base + vec2(texel.x, 0.0)).r),
+                    min(texture2D(DepthTexture, base + vec2(0.0, texel.y)).r, texture2D(DepthTexture, base + texel).r));
+    }
+    else{
+        depth = texture2D(DepthTexture, st).r;
+    }
+    gl_FragData[1] = vec4(linearDepth(depth), 0.0, 0.0, 0.0);
+}
+
+// Scene color of the cube mode along ray (valid in w), every channel picks its own face
+vec4 cubeRayColor(vec4 ray)
+{
+#if CHROMATIC
+    return (ray.w < 0.5) ? vec4(0.0, 0.0, 0.0, 1.0) :
+        vec4(sampleCube(aberrate(ray.xyz, ChromaticAberr.r)).r, sampleCube(aberrate(ray.xyz, ChromaticAberr.g)).g,
+             sampleCube(aberrate(ray.xyz, ChromaticAberr.b)).b, 1.0);
+#else
+    return (ray.w < 0.5) ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(sampleCube(aberrate(ray.xyz, ChromaticAberr.g)).rgb, 1.0);
+#endif
+}
+
+// Scene coordinates of every channel at output location loc (normalized, y up). Returns
+// false where the pixel is black. continuous is false where tc_g itself is undefined.
+bool lookupSource(vec2 output_loc, out vec2 tc_r, out vec2 tc_g, out vec2 tc_b, out bool continuous)
+{
+    // Remap mode: the map file is interpolated to the output, the rest is the lookup mode
+    if (UseRemap){
+        vec2 loc = vec2(output_loc.x, 1.0 - output_loc.y);
+        vec2 SubWindowSize = vec2(WindowSize.y * (ImageSize.x / ImageSize.y), WindowSize.y);
+        vec2 SubWindowOffset = vec2((WindowSize.x - SubWindowSize.x) / 2.0, 0.0);
+        vec2 image = (loc * WindowSize - SubWindowOffset) * ImageSize / SubWindowSize;
+        // The map spans the image, its rows are stored top-down
+        vec2 map_loc = image / ImageSize;
+        vec2 source = texture2D(WarpMap, map_loc).xy;
+        if (RemapOffsets){
+            source += map_loc * RemapSourceSize - 0.5;
+        }
+        vec2 LensCenter = Center * SubWindowSize / ImageSize / WindowSize + SubWindowOffset / WindowSize;
+        vec2 d = ((source + 0.5) / RemapSourceSize * SubWindowSize / WindowSize + SubWindowOffset / WindowSize - LensCenter) / ChromaticAberr.g;
+        tc_r = LensCenter + ChromaticAberr.r * d;
+        tc_g = LensCenter + ChromaticAberr.g * d;
+        tc_b = LensCenter + ChromaticAberr.b * d;
+        vec2 r = (image - Center) / FocalLength;
+        bool outside = any(lessThan(map_loc, vec2(0.0))) || any(greaterThan(map_loc, vec2(1.0)))
+            || any(lessThan(min(min(tc_r, tc_g), tc_b), vec2(0.0))) || any(greaterThan(max(max(tc_r, tc_g), tc_b), vec2(1.0)))
+            || (BLACKOUT_ENABLED && length(r) > min(ImageSize[0] / FocalLength[0], ImageSize[1] / FocalLength[1]) / 2.0);
+        tc_r.y = 1.0 - tc_r.y;
+        tc_g.y = 1.0 - tc_g.y;
+        tc_b.y = 1.0 - tc_b.y;
+        continuous = !outside;
+        return !outside;
+    }
+
+    // Lookup mode: one map fetch replaces the whole lens model
+    if (UseWarpMap){
+        vec4 warp = texture2D(WarpMap, output_loc);
+        tc_g = warp.xy;
+        tc_r = tc_g + (ChromaticAberr.r - ChromaticAberr.g) * warp.zw;
+        tc_b = tc_g + (ChromaticAberr.b - ChromaticAberr.g) * warp.zw;
+
+        // Invalid texels are flagged with negative coordinates
+        continuous = tc_g.x >= 0.0;
+        return tc_g.x >= 0.0;
+    }
 
     // flip the y axis because OpenGL textures have y axis pointing up but
     // Center expect y axis to point down
@@ -47,53 +476,7 @@ void main()
     //|r|
     float r_mag = length(r);
 
-    vec2 r_displaced;
-
-    // Pinhole distortion
-    if (DistortionType == 0){
-        float r2 = r_mag * r_mag;
-        float r4 = r2 * r2;
-        float r6 = r4 * r2;
-
-        float radial_factor = 1.0 + RadialDistortion.x * r2 +
-                                    RadialDistortion.y * r4 +
-                                    RadialDistortion.z * r6;
-
-        // Tangential distortion
-        vec2 tangential;
-        tangential.x = 2.0 * TangentialDistortion.x * r.x * r.y + TangentialDistortion.y * (r2 + 2.0 * r.x * r.x);
-        tangential.y = TangentialDistortion.x * (r2 + 2.0 * r.y * r.y) + 2.0 * TangentialDistortion.y * r.x * r.y;
-
-        // Apply distortion
-        r_displaced = r * radial_factor + tangential;
-    }
-    
-    // Fisheye
-    else if (DistortionType == 1){
-        float theta = atan(r_mag);
-        float theta2 = theta * theta;
-        float theta4 = theta2 * theta2;
-        float theta6 = theta4 * theta2;
-        float theta8 = theta4 * theta4;
-
-        float theta_d = theta * (1.0 + RadialDistortion.x * theta2 +
-                                       RadialDistortion.y * theta4 +
-                                       RadialDistortion.z * theta6 +
-                                       RadialDistortion.w * theta8);
-
-        if (r_mag > 0.0) {
-            r_displaced = (r / r_mag) * tan(theta_d);
-        } else {
-            r_displaced = r;
-        }
-    }
-    
-    //PANOTOOl
-    else if (DistortionType == 2){
-        r_displaced = r * (RadialDistortion.w + RadialDistortion.z * r_mag +
-        RadialDistortion.y * r_mag * r_mag +
-        RadialDistortion.x * r_mag * r_mag * r_mag);
-    }
+    vec2 r_displaced = distort(r);
 
     // Convert back to normalized coordinate
     // wait to recenter after chromatic aberration
@@ -102,24 +485,233 @@ void main()
     vec2 LensCenter = Center * SubWindowSize / ImageSize / WindowSize + SubWindowOffset / WindowSize;
 
     // back to viewport co-ord
-    vec2 tc_r = (LensCenter + ChromaticAberr.r * r_displaced_normed);
-    vec2 tc_g = (LensCenter + ChromaticAberr.g * r_displaced_normed);
-    vec2 tc_b = (LensCenter + ChromaticAberr.b * r_displaced_normed);
+    tc_r = (LensCenter + ChromaticAberr.r * r_displaced_normed);
+    tc_g = (LensCenter + ChromaticAberr.g * r_displaced_normed);
+    tc_b = (LensCenter + ChromaticAberr.b * r_displaced_normed);
 
     // flip y axis back
     tc_r.y = 1.0 - tc_r.y;
     tc_g.y = 1.0 - tc_g.y;
     tc_b.y = 1.0 - tc_b.y;
 
-    float red = texture2D(WarpTexture, tc_r).r;
-    float green = texture2D(WarpTexture, tc_g).g;
-    float blue = texture2D(WarpTexture, tc_b).b;
+    // The model is continuous past the border and the blackout circle
+    continuous = true;
 
     // Black edges off the texture
-    gl_FragColor = (
+    return !(
+#if CHROMATIC
             (tc_r.x < 0.0) || (tc_r.x > 1.0) || (tc_r.y < 0.0) || (tc_r.y > 1.0) 
-            || (tc_g.x < 0.0) || (tc_g.x > 1.0) || (tc_g.y < 0.0) || (tc_g.y > 1.0) 
-            || (tc_b.x < 0.0) || (tc_b.x > 1.0) || (tc_b.y < 0.0) || (tc_b.y > 1.0) 
-        || (Blackout && r_mag > min(ImageSize[0] / FocalLength[0], ImageSize[1] / FocalLength[1]) / 2.0)
-        ) ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(red, green, blue, 1.0);        
-};
+            || (tc_b.x < 0.0) || (tc_b.x > 1.0) || (tc_b.y < 0.0) || (tc_b.y > 1.0) ||
+#endif
+            (tc_g.x < 0.0) || (tc_g.x > 1.0) || (tc_g.y < 0.0) || (tc_g.y > 1.0) 
+        || (BLACKOUT_ENABLED && r_mag > min(ImageSize[0] / FocalLength[0], ImageSize[1] / FocalLength[1]) / 2.0)
+        );
+}
+
+#ifndef SENSOR_CHAIN
+#define SENSOR_CHAIN 0
+#endif
+
+#if SENSOR_CHAIN
+// Sensor stages fused into the distortion pass, SENSOR_RAW and SENSOR_POST are
+// generated from the config by camdistort::getSensorChainDefines(). Stages before
+// the mosaic run on every raw sample, the demosaic evaluates them at the neighbors.
+
+// Image coordinate of the center of pixel px (rows top-down), through the same
+// letterbox as lookupSource()
+vec2 sensorImage(vec2 px)
+{
+    vec2 SubWindowSize = vec2(WindowSize.y * (ImageSize.x / ImageSize.y), WindowSize.y);
+    vec2 SubWindowOffset = vec2((WindowSize.x - SubWindowSize.x) / 2.0, 0.0);
+    return (px + 0.5 - SubWindowOffset) * ImageSize / SubWindowSize;
+}
+
+// Key of the noise of this frame, see camdistort::getSensorFrameSeed()
+uniform vec2 SensorSeed;
+
+// Counter-based generator: hash of the pixel, the frame key and a stream, in [0, 1)
+float sensorRandom(vec2 px, float stream)
+{
+    vec3 p = fract(vec3(px, stream) * vec3(0.1031, 0.1030, 0.0973) + vec3(SensorSeed, SensorSeed.x + SensorSeed.y));
+    p += dot(p, p.yzx + 33.33);
+    return fract((p.x + p.y) * p.z);
+}
+
+vec3 vignette(vec3 c, vec2 px, float strength, float exponent)
+{
+    // Angle to the optical axis of the pixel center in the image
+    vec2 image = sensorImage(px);
+    float tan2 = dot((image - Center) / FocalLength, (image - Center) / FocalLength);
+    return c * mix(1.0, pow(inversesqrt(1.0 + tan2), exponent), strength);
+}
+
+vec3 sensorNoise(vec3 c, vec2 px, float shot, float read, float stream)
+{
+    vec3 sigma = sqrt(shot * max(c, vec3(0.0)) + read * read);
+    // Box-Muller, one normal sample per channel
+    vec3 gauss;
+    for (int i = 0 ; i < 3 ; i++){
+        float u1 = max(sensorRandom(px, 6.0 * stream + 2.0 * float(i)), 1e-7);
+        float u2 = sensorRandom(px, 6.0 * stream + 2.0 * float(i) + 1.0);
+        gauss[i] = sqrt(-2.0 * log(u1)) * cos(6.28318531 * u2);
+    }
+    return c + sigma * gauss;
+}
+
+vec3 toneCurve(vec3 c, float exposure, float white)
+{
+    vec3 v = max(c, vec3(0.0)) * exposure;
+    return v * (1.0 + v / (white * white)) / (1.0 + v);
+}
+
+vec3 rawStages(vec3 c, vec2 px)
+{
+    SENSOR_RAW(c, px)
+    return c;
+}
+
+vec3 postStages(vec3 c, vec2 px)
+{
+    SENSOR_POST(c, px)
+    return c;
+}
+
+#if SENSOR_BAYER >= 0
+// Where the pixel samples the scene, set by setMosaicSource(): the coordinate of every
+// channel, or the ray in cube mode, and its change over one pixel right and down. The
+// lens is smooth over a pixel, so the neighbors of the demosaic are reached by these
+// offsets instead of running the lookup again for each of them.
+vec4 MosaicSource[3];
+vec4 MosaicDx[3];
+vec4 MosaicDy[3];
+bool MosaicVisible = false;
+
+// Called from main() in uniform control flow. Quads straddling invalid texels or the
+// border get no offsets, their neighbors fall back to the center lookup.
+void setMosaicSource(vec4 r, vec4 g, vec4 b, bool visible, bool continuous)
+{
+    bool mixed = fwidth(continuous ? 1.0 : 0.0) > 0.0;
+    MosaicSource[0] = r;
+    MosaicSource[1] = g;
+    MosaicSource[2] = b;
+    // Image rows are top-down, window rows bottom-up
+    MosaicDx[0] = mixed ? vec4(0.0) : dFdx(r);
+    MosaicDx[1] = mixed ? vec4(0.0) : dFdx(g);
+    MosaicDx[2] = mixed ? vec4(0.0) : dFdx(b);
+    MosaicDy[0] = mixed ? vec4(0.0) : -dFdy(r);
+    MosaicDy[1] = mixed ? vec4(0.0) : -dFdy(g);
+    MosaicDy[2] = mixed ? vec4(0.0) : -dFdy(b);
+    MosaicVisible = visible;
+}
+
+// Distorted color of the neighbor offset pixels away
+vec3 mosaicColor(vec2 offset)
+{
+    if (!MosaicVisible){
+        return vec3(0.0);
+    }
+    vec4 r = MosaicSource[0] + offset.x * MosaicDx[0] + offset.y * MosaicDy[0];
+    vec4 g = MosaicSource[1] + offset.x * MosaicDx[1] + offset.y * MosaicDy[1];
+    vec4 b = MosaicSource[2] + offset.x * MosaicDx[2] + offset.y * MosaicDy[2];
+    if (UseCubeMap){
+        return cubeRayColor(vec4(g.xyz, 1.0)).rgb;
+    }
+    // Black edges off the texture
+    vec2 low = min(min(r.xy, g.xy), b.xy);
+    vec2 high = max(max(r.xy, g.xy), b.xy);
+    if (any(lessThan(low, vec2(0.0))) || any(greaterThan(high, vec2(1.0)))){
+        return vec3(0.0);
+    }
+    return sampleSensor(r.xy, g.xy, b.xy).rgb;
+}
+
+// Filter of pixel px (image rows top-down): 0 red, 1 green, 2 blue
+int bayerChannel(vec2 px)
+{
+    // Pattern RGGB, GRBG, GBRG, BGGR: the parities of the red pixel
+    vec2 red = vec2(SENSOR_BAYER == 1 || SENSOR_BAYER == 3 ? 1.0 : 0.0, SENSOR_BAYER >= 2 ? 1.0 : 0.0);
+    vec2 parity = mod(px, 2.0);
+    if (parity == red){
+        return 0;
+    }
+    if (parity == vec2(1.0) - red){
+        return 2;
+    }
+    return 1;
+}
+
+// Raw mosaic sample of the neighbor offset pixels away from px: its filtered channel
+// after the raw stages
+float rawSample(vec2 px, vec2 offset)
+{
+    vec3 c = rawStages(mosaicColor(offset), px + offset);
+    int channel = bayerChannel(px + offset);
+    return (channel == 0) ? c.r : ((channel == 1) ? c.g : c.b);
+}
+
+// Bilinear demosaic of the mosaic around px, the center sample is already known
+vec3 demosaic(vec2 px, float center)
+{
+    float up = rawSample(px, vec2(0.0, -1.0));
+    float down = rawSample(px, vec2(0.0, 1.0));
+    float left = rawSample(px, vec2(-1.0, 0.0));
+    float right = rawSample(px, vec2(1.0, 0.0));
+    int channel = bayerChannel(px);
+    if (channel == 1){
+        // Green: the row holds red or blue, the column the other one
+        float row = (left + right) * 0.5;
+        float column = (up + down) * 0.5;
+        return (bayerChannel(px + vec2(1.0, 0.0)) == 0) ? vec3(row, center, column) : vec3(column, center, row);
+    }
+    float cross = (up + down + left + right) * 0.25;
+    float diagonal = (rawSample(px, vec2(-1.0, -1.0)) + rawSample(px, vec2(1.0, -1.0)) +
+                      rawSample(px, vec2(-1.0, 1.0)) + rawSample(px, vec2(1.0, 1.0))) * 0.25;
+    return (channel == 0) ? vec3(center, cross, diagonal) : vec3(diagonal, cross, center);
+}
+#else
+#define setMosaicSource(r, g, b, visible, continuous)
+#endif
+
+// Output of the sensor for the distorted color of the pixel at loc
+vec4 sensorColor(vec4 color, vec2 loc)
+{
+    // Pixel of the output, image rows top-down
+    vec2 px = floor(vec2(loc.x, 1.0 - loc.y) * WindowSize);
+    vec3 c = rawStages(color.rgb, px);
+#if SENSOR_BAYER >= 0
+    int channel = bayerChannel(px);
+    c = demosaic(px, (channel == 0) ? c.r : ((channel == 1) ? c.g : c.b));
+#endif
+    return vec4(clamp(postStages(c, px), 0.0, 1.0), color.a);
+}
+#else
+#define setMosaicSource(r, g, b, visible, continuous)
+#endif
+
+void main()
+{   
+    // Normalized texture coordinate [0,1]
+    vec2 output_loc = gl_TexCoord[0].xy;
+
+    vec4 color;
+    if (UseCubeMap){
+        vec4 ray = texture2D(WarpMap, output_loc);
+        color = cubeRayColor(ray);
+        setMosaicSource(vec4(0.0), vec4(ray.xyz, 0.0), vec4(0.0), ray.w >= 0.5, ray.w >= 0.5);
+        // The cube faces keep no depth
+        gl_FragData[1] = vec4(0.0);
+    }
+    else{
+        vec2 tc_r, tc_g, tc_b;
+        bool continuous;
+        bool visible = lookupSource(output_loc, tc_r, tc_g, tc_b, continuous);
+        setFootprint(tc_g, continuous);
+        setMosaicSource(vec4(tc_r, 0.0, 0.0), vec4(tc_g, 0.0, 0.0), vec4(tc_b, 0.0, 0.0), visible, continuous);
+        color = visible ? sampleSensor(tc_r, tc_g, tc_b) : vec4(0.0, 0.0, 0.0, 1.0);
+        writeDepth(tc_g, visible);
+    }
+#if SENSOR_CHAIN
+    color = sensorColor(color, output_loc);
+#endif
+    gl_FragData[0] = color;
+}
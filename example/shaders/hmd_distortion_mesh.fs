@@ -0,0 +1,19 @@
+#version 120
+
+//per eye texture to warp for lens distortion
+uniform sampler2D warpTexture;
+
+varying vec3 vTexCoordG;
+varying vec3 vTexCoordR;
+varying vec2 vTexCoordB;
+
+void main()
+{
+    // The warp is interpolated from the mesh vertices, only the boundary is clipped here
+    float offset = vTexCoordR.z;
+    vec2 tc_g = vTexCoordG.xy;
+    bool outside = (tc_g.x - offset < 0.0) || (tc_g.x - offset > 0.5) || (tc_g.y < 0.0) || (tc_g.y > 1.0) || (vTexCoordG.z > 1.0);
+
+    gl_FragColor = outside ? vec4(0.0, 0.0, 0.0, 1.0) :
+        vec4(texture2D(warpTexture, vTexCoordR.xy).r, texture2D(warpTexture, tc_g).g, texture2D(warpTexture, vTexCoordB).b, 1.0);
+};
@@ -0,0 +1,22 @@
+#version 120
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+attribute vec3 aTexCoord;
+attribute vec4 aColor;
+attribute vec3 aTangent;
+attribute vec3 aBitangent;
+
+// Per-vertex warp computed by the plugin, see afCreateHMDDistortionMesh()
+// green texture coordinate, lens radius / lens_radius
+varying vec3 vTexCoordG;
+// red texture coordinate, eye offset
+varying vec3 vTexCoordR;
+// blue texture coordinate
+varying vec2 vTexCoordB;
+void main(void)
+{
+    vTexCoordG = aTexCoord;
+    vTexCoordR = aTangent;
+    vTexCoordB = aBitangent.xy;
+    gl_Position = gl_Vertex;
+};
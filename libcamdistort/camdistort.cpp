@@ -0,0 +1,519 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "camdistort.h"
+#include "kernels.h"
+#include "remap_file.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+namespace camdistort {
+
+Isa getBestIsa()
+{
+#if defined(CAMDISTORT_HAVE_X86) && (defined(__GNUC__) || defined(__clang__))
+    static const Isa isa = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? Isa::AVX2 :
+                           (__builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::SCALAR);
+    return isa;
+#else
+    return Isa::SCALAR;
+#endif
+}
+
+const char* getIsaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+// An unsupported request falls back to the best available instruction set
+static Isa resolveIsa(Isa requested)
+{
+    Isa best = getBestIsa();
+    return static_cast<int>(requested) > static_cast<int>(best) ? best : requested;
+}
+
+WarpGeometry computeWarpGeometry(const CameraParams &params, int width, int height)
+{
+    WarpGeometry g;
+    g.type = params.distortion_type;
+    g.window[0] = static_cast<float>(width);
+    g.window[1] = static_cast<float>(height);
+    g.image[0] = params.width;
+    g.image[1] = params.height;
+    g.center[0] = params.cx;
+    g.center[1] = params.cy;
+    g.focal[0] = params.fx;
+    g.focal[1] = params.fy;
+
+    // the segment of the window with an aspect ratio matching the image
+    g.subWindowSize[0] = g.window[1] * (g.image[0] / g.image[1]);
+    g.subWindowSize[1] = g.window[1];
+    // offset so the subwindow is centered in the window
+    g.subWindowOffset[0] = (g.window[0] - g.subWindowSize[0]) / 2.0f;
+    g.subWindowOffset[1] = 0.0f;
+
+    for (int i = 0 ; i < 2 ; i++){
+        g.lensCenter[i] = g.center[i] * g.subWindowSize[i] / g.image[i] / g.window[i] + g.subWindowOffset[i] / g.window[i];
+        g.toNormed[i] = g.focal[i] * g.subWindowSize[i] / g.image[i] / g.window[i];
+        g.p[i] = params.tangential_distortion_coeffs[i];
+    }
+    for (int i = 0 ; i < 4 ; i++){
+        g.k[i] = params.radial_distortion_coeffs[i];
+        g.prism[i] = params.thin_prism_coeffs[i];
+    }
+    for (int i = 0 ; i < 3 ; i++){
+        g.aberr[i] = params.aberr_scale[i];
+        g.rational[i] = params.rational_distortion_coeffs[i];
+    }
+    g.extended = params.distortion_type == DistortionType::PINHOLE && hasExtendedPinholeTerms(params);
+    double tilt[9];
+    computeTiltMatrix(params.tilt[0], params.tilt[1], tilt);
+    for (int i = 0 ; i < 9 ; i++){
+        g.tilt[i] = static_cast<float>(tilt[i]);
+    }
+    g.blackout = params.blackout;
+    g.blackoutRadius = std::min(g.image[0] / g.focal[0], g.image[1] / g.focal[1]) / 2.0f;
+    return g;
+}
+
+void computeTiltMatrix(double tauX, double tauY, double tilt[9])
+{
+    double cx = std::cos(tauX), sx = std::sin(tauX);
+    double cy = std::cos(tauY), sy = std::sin(tauY);
+    // RotY(tau_y) * RotX(tau_x)
+    const double rot[9] = {cy, sy * sx, -sy * cx,
+                           0.0, cx, sx,
+                           sy, -cy * sx, cy * cx};
+    // projection back onto the tilted sensor plane
+    const double proj[9] = {rot[8], 0.0, -rot[2],
+                            0.0, rot[8], -rot[5],
+                            0.0, 0.0, 1.0};
+    for (int r = 0 ; r < 3 ; r++){
+        for (int c = 0 ; c < 3 ; c++){
+            tilt[3 * r + c] = proj[3 * r] * rot[c] + proj[3 * r + 1] * rot[3 + c] + proj[3 * r + 2] * rot[6 + c];
+        }
+    }
+}
+
+std::string getShaderDefines(const CameraParams &params)
+{
+    const float* aberr = params.aberr_scale;
+    const float* p = params.tangential_distortion_coeffs;
+    const float* rational = params.rational_distortion_coeffs;
+    const float* prism = params.thin_prism_coeffs;
+    bool pinhole = params.distortion_type == DistortionType::PINHOLE;
+    std::stringstream defines;
+    defines << "#define DISTORTION_MODEL " << static_cast<int>(params.distortion_type) << "\n";
+    defines << "#define CHROMATIC " << (aberr[0] != aberr[1] || aberr[2] != aberr[1]) << "\n";
+    defines << "#define BLACKOUT " << params.blackout << "\n";
+    defines << "#define PINHOLE_TANGENTIAL " << (pinhole && (p[0] != 0.0f || p[1] != 0.0f)) << "\n";
+    defines << "#define PINHOLE_RATIONAL " << (pinhole && (rational[0] != 0.0f || rational[1] != 0.0f || rational[2] != 0.0f)) << "\n";
+    defines << "#define PINHOLE_THIN_PRISM " << (pinhole && (prism[0] != 0.0f || prism[1] != 0.0f || prism[2] != 0.0f || prism[3] != 0.0f)) << "\n";
+    defines << "#define PINHOLE_TILT " << (pinhole && (params.tilt[0] != 0.0f || params.tilt[1] != 0.0f)) << "\n";
+    return defines.str();
+}
+
+bool unprojectDoubleSphere(double xi, double alpha, double mx, double my, double dir[3])
+{
+    double r2 = mx * mx + my * my;
+    double radicand = 1.0 - (2.0 * alpha - 1.0) * r2;
+    if (radicand < 0.0){
+        return false;
+    }
+    double mz = (1.0 - alpha * alpha * r2) / (alpha * std::sqrt(radicand) + 1.0 - alpha);
+    double factor = (mz * xi + std::sqrt(mz * mz + (1.0 - xi * xi) * r2)) / (mz * mz + r2);
+    dir[0] = factor * mx;
+    dir[1] = factor * my;
+    dir[2] = factor * mz - xi;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Reference
+//------------------------------------------------------------------------------
+void distortPoint(const CameraParams &params, double x, double y, double &xd, double &yd)
+{
+    const float* k = params.radial_distortion_coeffs;
+    const float* p = params.tangential_distortion_coeffs;
+    double r2 = x * x + y * y;
+    double r_mag = std::sqrt(r2);
+
+    switch (params.distortion_type) {
+    case DistortionType::PINHOLE:{
+        // OpenCV's projectPoints, which reduces to Brown-Conrady without the extended terms
+        const float* kr = params.rational_distortion_coeffs;
+        const float* s = params.thin_prism_coeffs;
+        double r4 = r2 * r2, r6 = r4 * r2;
+        double radial = (1.0 + k[0] * r2 + k[1] * r4 + k[2] * r6) / (1.0 + kr[0] * r2 + kr[1] * r4 + kr[2] * r6);
+        xd = x * radial + 2.0 * p[0] * x * y + p[1] * (r2 + 2.0 * x * x) + s[0] * r2 + s[1] * r4;
+        yd = y * radial + p[0] * (r2 + 2.0 * y * y) + 2.0 * p[1] * x * y + s[2] * r2 + s[3] * r4;
+        if (params.tilt[0] != 0.0f || params.tilt[1] != 0.0f){
+            double tilt[9];
+            computeTiltMatrix(params.tilt[0], params.tilt[1], tilt);
+            double tx = tilt[0] * xd + tilt[1] * yd + tilt[2];
+            double ty = tilt[3] * xd + tilt[4] * yd + tilt[5];
+            double tz = tilt[6] * xd + tilt[7] * yd + tilt[8];
+            double invProj = tz != 0.0 ? 1.0 / tz : 1.0;
+            xd = tx * invProj;
+            yd = ty * invProj;
+        }
+        return;
+    }
+    case DistortionType::DOUBLE_SPHERE:{
+        double xi = k[0], alpha = k[1];
+        double d1 = std::sqrt(r2 + 1.0);
+        double w = xi * d1 + 1.0;
+        double d2 = std::sqrt(r2 + w * w);
+        double denom = alpha * d2 + (1.0 - alpha) * w;
+        xd = x / denom;
+        yd = y / denom;
+        return;
+    }
+    case DistortionType::FISHEYE:{
+        double theta = std::atan(r_mag);
+        double t2 = theta * theta;
+        double theta_d = theta * (1.0 + k[0] * t2 + k[1] * t2 * t2 + k[2] * t2 * t2 * t2 + k[3] * t2 * t2 * t2 * t2);
+        double s = r_mag > 0.0 ? std::tan(theta_d) / r_mag : 1.0;
+        xd = x * s;
+        yd = y * s;
+        return;
+    }
+    default:{
+        double s = k[3] + k[2] * r_mag + k[1] * r_mag * r_mag + k[0] * r_mag * r_mag * r_mag;
+        xd = x * s;
+        yd = y * s;
+        return;
+    }
+    }
+}
+
+bool undistortPoint(const CameraParams &params, double xd, double yd, double &x, double &y, int maxIterations, double tolerance)
+{
+    if (params.distortion_type == DistortionType::DOUBLE_SPHERE){
+        double dir[3];
+        if (!unprojectDoubleSphere(params.radial_distortion_coeffs[0], params.radial_distortion_coeffs[1], xd, yd, dir) || !(dir[2] > 0.0)){
+            return false;
+        }
+        x = dir[0] / dir[2];
+        y = dir[1] / dir[2];
+        return true;
+    }
+    // Newton iterations with a central difference Jacobian, independent of the
+    // analytic derivatives used by the vector kernels
+    const double h = 1e-7;
+    x = xd;
+    y = yd;
+    for (int i = 0 ; i < maxIterations ; i++){
+        double fx, fy;
+        distortPoint(params, x, y, fx, fy);
+        double ex = fx - xd;
+        double ey = fy - yd;
+        if (std::sqrt(ex * ex + ey * ey) < tolerance){
+            return true;
+        }
+        double ax, ay, bx, by;
+        distortPoint(params, x + h, y, ax, ay);
+        distortPoint(params, x - h, y, bx, by);
+        double jxx = (ax - bx) / (2.0 * h), jyx = (ay - by) / (2.0 * h);
+        distortPoint(params, x, y + h, ax, ay);
+        distortPoint(params, x, y - h, bx, by);
+        double jxy = (ax - bx) / (2.0 * h), jyy = (ay - by) / (2.0 * h);
+        double det = jxx * jyy - jxy * jyx;
+        if (std::fabs(det) < 1e-15){
+            return false;
+        }
+        x -= (jyy * ex - jxy * ey) / det;
+        y -= (jxx * ey - jyx * ex) / det;
+    }
+    return false;
+}
+
+void buildWarpMapReference(const CameraParams &params, int width, int height, float* rgba, WarpDirection direction)
+{
+    if (params.distortion_type == DistortionType::REMAP){
+        RemapFile file;
+        file.open(params.remap_file);
+        buildRemapWarpMap(file, params, width, height, rgba);
+        return;
+    }
+    WarpGeometry g = computeWarpGeometry(params, width, height);
+    for (int yi = 0 ; yi < height ; yi++){
+        for (int xi = 0 ; xi < width ; xi++){
+            double loc[2] = {(xi + 0.5) / g.window[0], 1.0 - (yi + 0.5) / g.window[1]};
+            double r[2];
+            for (int i = 0 ; i < 2 ; i++){
+                r[i] = ((loc[i] * g.window[i] - g.subWindowOffset[i]) * g.image[i] / g.subWindowSize[i] - g.center[i]) / g.focal[i];
+            }
+            double m[2];
+            bool solved = true;
+            if (direction == WarpDirection::FORWARD){
+                distortPoint(params, r[0], r[1], m[0], m[1]);
+            }
+            else{
+                solved = undistortPoint(params, r[0], r[1], m[0], m[1]);
+            }
+            double d[2] = {m[0] * g.toNormed[0], m[1] * g.toNormed[1]};
+
+            bool valid = solved && !(g.blackout && std::sqrt(r[0] * r[0] + r[1] * r[1]) > g.blackoutRadius);
+            for (int c = 0 ; c < 3 ; c++){
+                for (int i = 0 ; i < 2 ; i++){
+                    double tc = g.lensCenter[i] + g.aberr[c] * d[i];
+                    if (tc < 0.0 || tc > 1.0){
+                        valid = false;
+                    }
+                }
+            }
+
+            float* texel = rgba + 4 * ((size_t)yi * width + xi);
+            texel[0] = valid ? static_cast<float>(g.lensCenter[0] + g.aberr[1] * d[0]) : -1.0f;
+            texel[1] = valid ? static_cast<float>(1.0 - (g.lensCenter[1] + g.aberr[1] * d[1])) : -1.0f;
+            texel[2] = valid ? static_cast<float>(d[0]) : 0.0f;
+            texel[3] = valid ? static_cast<float>(-d[1]) : 0.0f;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------------------
+static void forEachTile(ThreadPool* pool, int height, int tileRows, const std::function<void(int, int)> &fn)
+{
+    if (tileRows <= 0){
+        tileRows = 16;
+    }
+    int tiles = (height + tileRows - 1) / tileRows;
+    ThreadPool& p = pool ? *pool : ThreadPool::getDefault();
+    p.parallelFor(tiles, [&](int t){
+        int y0 = t * tileRows;
+        fn(y0, std::min(height, y0 + tileRows));
+    });
+}
+
+void buildWarpMap(const CameraParams &params, int width, int height, float* rgba, const WarpMapOptions &options,
+                  WarpMapReport* report)
+{
+    if (report){
+        *report = WarpMapReport();
+    }
+    if (width <= 0 || height <= 0){
+        return;
+    }
+    // The map is the model, there is nothing to solve in either direction
+    if (params.distortion_type == DistortionType::REMAP){
+        RemapFile file;
+        file.open(params.remap_file);
+        buildRemapWarpMap(file, params, width, height, rgba, options.pool);
+        return;
+    }
+    const WarpGeometry g = computeWarpGeometry(params, width, height);
+    const Isa isa = resolveIsa(options.isa);
+    // Tiles accumulate locally and merge once, the map itself needs no locking
+    std::mutex reportMutex;
+    forEachTile(options.pool, height, options.tileRows, [&](int y0, int y1){
+        WarpMapReport tile;
+        switch (isa) {
+#if defined(CAMDISTORT_HAVE_X86)
+        case Isa::AVX2:
+            kernels::warpRowsAvx2(g, options, y0, y1, rgba, tile);
+            break;
+        case Isa::SSE2:
+            kernels::warpRowsSse2(g, options, y0, y1, rgba, tile);
+            break;
+#endif
+        default:
+            kernels::warpRowsScalar(g, options, y0, y1, rgba, tile);
+            break;
+        }
+        if (report){
+            std::lock_guard<std::mutex> lock(reportMutex);
+            report->maxResidual = std::max(report->maxResidual, tile.maxResidual);
+            report->solvedPixels += tile.solvedPixels;
+            report->nonConverged += tile.nonConverged;
+        }
+    });
+}
+
+SourceFootprint analyzeWarpMap(const float* rgba, int width, int height, const float aberr[3], ThreadPool* pool)
+{
+    SourceFootprint footprint;
+    if (width <= 0 || height <= 0){
+        return footprint;
+    }
+    bool first = true;
+    std::mutex footprintMutex;
+    forEachTile(pool, height, 16, [&](int y0, int y1){
+        SourceFootprint tile;
+        float minScale = std::numeric_limits<float>::max();
+        for (int y = y0 ; y < y1 ; y++){
+            for (int x = 0 ; x < width ; x++){
+                const float* texel = rgba + 4 * ((size_t)y * width + x);
+                if (texel[0] < 0.0f){
+                    continue;
+                }
+                tile.validPixels++;
+                for (int c = 0 ; c < 3 ; c++){
+                    float s = aberr[c] - aberr[1];
+                    for (int i = 0 ; i < 2 ; i++){
+                        float tc = texel[i] + s * texel[2 + i];
+                        tile.uvMin[i] = std::min(tile.uvMin[i], tc);
+                        tile.uvMax[i] = std::max(tile.uvMax[i], tc);
+                    }
+                }
+
+                // Finite differences towards valid neighbours, backwards at the edges
+                float j[2][2];
+                bool ok = true;
+                for (int axis = 0 ; axis < 2 && ok ; axis++){
+                    int nx = x + (axis == 0), ny = y + (axis == 1);
+                    float sign = 1.0f;
+                    if (nx >= width || ny >= height || rgba[4 * ((size_t)ny * width + nx)] < 0.0f){
+                        nx = x - (axis == 0);
+                        ny = y - (axis == 1);
+                        sign = -1.0f;
+                    }
+                    if (nx < 0 || ny < 0 || rgba[4 * ((size_t)ny * width + nx)] < 0.0f){
+                        ok = false;
+                        break;
+                    }
+                    const float* neighbour = rgba + 4 * ((size_t)ny * width + nx);
+                    j[0][axis] = sign * (neighbour[0] - texel[0]) * width;
+                    j[1][axis] = sign * (neighbour[1] - texel[1]) * height;
+                }
+                if (ok){
+                    minScale = std::min(minScale, kernels::minSingularValue(j[0][0], j[0][1], j[1][0], j[1][1]));
+                }
+            }
+        }
+        tile.minScale = minScale;
+        std::lock_guard<std::mutex> lock(footprintMutex);
+        if (tile.validPixels == 0){
+            return;
+        }
+        for (int i = 0 ; i < 2 ; i++){
+            footprint.uvMin[i] = std::min(footprint.uvMin[i], tile.uvMin[i]);
+            footprint.uvMax[i] = std::max(footprint.uvMax[i], tile.uvMax[i]);
+        }
+        footprint.minScale = first ? tile.minScale : std::min(footprint.minScale, tile.minScale);
+        footprint.validPixels += tile.validPixels;
+        first = false;
+    });
+    if (footprint.validPixels > 0 && footprint.minScale == std::numeric_limits<float>::max()){
+        // isolated texels only, no derivative available
+        footprint.minScale = 0.0f;
+    }
+    return footprint;
+}
+
+void remapRGBA8(const uint8_t* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                const float aberr[3], uint8_t* dst, const RemapOptions &options)
+{
+    if (width <= 0 || height <= 0 || srcWidth <= 0 || srcHeight <= 0){
+        return;
+    }
+    const Isa isa = resolveIsa(options.isa);
+    forEachTile(options.pool, height, options.tileRows, [&](int y0, int y1){
+        switch (isa) {
+#if defined(CAMDISTORT_HAVE_X86)
+        case Isa::AVX2:
+            kernels::remapRGBA8RowsAvx2(src, srcWidth, srcHeight, warpMap, width, y0, y1, aberr, dst);
+            break;
+        case Isa::SSE2:
+            kernels::remapRGBA8RowsSse2(src, srcWidth, srcHeight, warpMap, width, y0, y1, aberr, dst);
+            break;
+#endif
+        default:
+            kernels::remapRGBA8RowsScalar(src, srcWidth, srcHeight, warpMap, width, y0, y1, aberr, dst);
+            break;
+        }
+    });
+}
+
+void remapDepth(const float* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                float* dst, const RemapOptions &options)
+{
+    if (width <= 0 || height <= 0 || srcWidth <= 0 || srcHeight <= 0){
+        return;
+    }
+    const Isa isa = resolveIsa(options.isa);
+    forEachTile(options.pool, height, options.tileRows, [&](int y0, int y1){
+        switch (isa) {
+#if defined(CAMDISTORT_HAVE_X86)
+        case Isa::AVX2:
+            kernels::remapDepthRowsAvx2(src, srcWidth, srcHeight, warpMap, width, y0, y1, options.filter, dst);
+            break;
+        case Isa::SSE2:
+            kernels::remapDepthRowsSse2(src, srcWidth, srcHeight, warpMap, width, y0, y1, options.filter, dst);
+            break;
+#endif
+        default:
+            kernels::remapDepthRowsScalar(src, srcWidth, srcHeight, warpMap, width, y0, y1, options.filter, dst);
+            break;
+        }
+    });
+}
+
+void remapRGBA8Reference(const uint8_t* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                         const float aberr[3], uint8_t* dst)
+{
+    kernels::remapRGBA8RowsScalar(src, srcWidth, srcHeight, warpMap, width, 0, height, aberr, dst);
+}
+
+void remapDepthReference(const float* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                         float* dst, RemapFilter filter)
+{
+    kernels::remapDepthRowsScalar(src, srcWidth, srcHeight, warpMap, width, 0, height, filter, dst);
+}
+
+}
@@ -0,0 +1,215 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_H
+#define CAMDISTORT_H
+
+// Host side implementation of the lens models of example/shaders/camera_distortion.fs.
+// Coordinates follow the shader: an output image of width x height pixels is mapped
+// onto the calibrated image_size with the same centered sub-window, texture
+// coordinates are in [0, 1] with v = 0 at the first row (OpenGL row order, as
+// returned by glReadPixels). Like in the shader, the calibration (cx, cy) is
+// top-down, so map rows are flipped before the model is evaluated.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "camera_params.h"
+#include "thread_pool.h"
+
+namespace camdistort {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// FORWARD matches the shader: the output pixel is treated as an undistorted ray and
+// the source is sampled at its distorted location. INVERSE samples the source at
+// the undistorted location of the output pixel.
+enum class WarpDirection {
+    FORWARD,
+    INVERSE,
+};
+
+// How the INVERSE direction is solved per pixel. NEWTON uses the analytic Jacobian
+// of the model and converges quadratically; FIXED_POINT is the cheaper iteration
+// x <- (target - tangential(x)) / radial(x) that only converges for mild distortion.
+enum class WarpSolver {
+    NEWTON,
+    FIXED_POINT,
+};
+
+enum class RemapFilter {
+    BILINEAR,
+    NEAREST,
+};
+
+// Best instruction set supported by the compiler and the running CPU
+Isa getBestIsa();
+const char* getIsaName(Isa isa);
+
+// Sub-window mapping and model parameters, precomputed once per (params, size)
+struct WarpGeometry {
+    DistortionType type;
+    float window[2];
+    float image[2];
+    float center[2];
+    float focal[2];
+    float subWindowSize[2];
+    float subWindowOffset[2];
+    float lensCenter[2];
+    float toNormed[2];
+    float k[4];
+    float p[2];
+    // PINHOLE with any rational, thin prism or tilt term, evaluated by the full OpenCV model
+    bool extended;
+    float rational[3];
+    float prism[4];
+    // Row-major tilt projection of OpenCV's computeTiltProjectionMatrix(tau_x, tau_y)
+    float tilt[9];
+    float aberr[3];
+    bool blackout;
+    float blackoutRadius;
+};
+
+WarpGeometry computeWarpGeometry(const CameraParams &params, int width, int height);
+
+struct WarpMapOptions {
+    WarpDirection direction = WarpDirection::FORWARD;
+    Isa isa = getBestIsa();
+    // Solver, iterations and convergence tolerance of the INVERSE direction. The
+    // tolerance is on |forward(solution) - target| in calibrated image pixels.
+    WarpSolver solver = WarpSolver::NEWTON;
+    int iterations = 20;
+    float tolerance = 0.01f;
+    // Rows per parallel tile
+    int tileRows = 16;
+    // nullptr uses ThreadPool::getDefault()
+    ThreadPool* pool = nullptr;
+};
+
+// Convergence of an INVERSE warp map, left at zero for FORWARD
+struct WarpMapReport {
+    // Largest residual of the solved pixels in calibrated image pixels, including
+    // the non-converged ones (NaN residuals are only counted below)
+    float maxResidual = 0.0f;
+    // Pixels that were solved (not blacked out) and those whose residual stayed above
+    // the tolerance. The latter have no valid inverse and are written as invalid.
+    uint64_t solvedPixels = 0;
+    uint64_t nonConverged = 0;
+};
+
+// Region of the source image a warp map samples and how densely it samples it
+struct SourceFootprint {
+    // Bounding box of the sampled texture coordinates over the three color
+    // channels. Empty (min > max) if no texel is valid.
+    float uvMin[2] = {1.0f, 1.0f};
+    float uvMax[2] = {0.0f, 0.0f};
+    // Smallest singular value over the map of d(source texel) / d(output pixel), for a
+    // source at the output resolution. 1 / minScale is the largest number of output
+    // pixels that one source texel is stretched over.
+    float minScale = 0.0f;
+    uint64_t validPixels = 0;
+};
+
+struct RemapOptions {
+    RemapFilter filter = RemapFilter::BILINEAR;
+    Isa isa = getBestIsa();
+    int tileRows = 16;
+    ThreadPool* pool = nullptr;
+};
+
+// Scalar double precision reference of the models on normalized camera coordinates
+void distortPoint(const CameraParams &params, double x, double y, double &xd, double &yd);
+bool undistortPoint(const CameraParams &params, double xd, double yd, double &x, double &y, int maxIterations = 100, double tolerance = 1e-12);
+
+// Closed form unprojection of the double sphere model, dir is not normalized. False
+// outside of the valid image region of the model (alpha > 0.5).
+bool unprojectDoubleSphere(double xi, double alpha, double mx, double my, double dir[3]);
+
+// Row-major 3x3 tilt projection of the OpenCV model for the sensor tilt tau_x, tau_y
+void computeTiltMatrix(double tauX, double tauY, double tilt[9]);
+
+// #define lines that specialize camera_distortion.fs for params: the lens model,
+// single fetch without chromatic aberration, the blackout and the pinhole terms
+// that have nonzero coefficients
+std::string getShaderDefines(const CameraParams &params);
+
+// Fill rgba (4 * width * height floats) with the per-pixel lookup used by the plugin:
+// (u_g, v_g, d_u, d_v) where u_g, v_g is the green-channel source texture coordinate
+// and d the normalized displacement, so that channel c samples at
+// tc_g + (aberr_c - aberr_g) * d. Invalid pixels are (-1, -1, 0, 0). If report is
+// not null it receives the convergence of the INVERSE solve.
+void buildWarpMap(const CameraParams &params, int width, int height, float* rgba, const WarpMapOptions &options = WarpMapOptions(),
+                  WarpMapReport* report = nullptr);
+
+// Bounds and sampling density of a width x height warp map built by buildWarpMap(),
+// with the chromatic aberration scales it is used with
+SourceFootprint analyzeWarpMap(const float* rgba, int width, int height, const float aberr[3], ThreadPool* pool = nullptr);
+
+// Straightforward scalar implementation, used as ground truth for the vector kernels
+void buildWarpMapReference(const CameraParams &params, int width, int height, float* rgba, WarpDirection direction = WarpDirection::FORWARD);
+
+// Resample an RGBA8 source image through a warp map of width x height. The
+// chromatic aberration scales select the per-channel coordinates; invalid pixels
+// are written as opaque black.
+void remapRGBA8(const uint8_t* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                const float aberr[3], uint8_t* dst, const RemapOptions &options = RemapOptions());
+
+// Resample a single channel float image (e.g. depth) through the green-channel
+// coordinates of a warp map. Invalid pixels are written as 0.
+void remapDepth(const float* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                float* dst, const RemapOptions &options = RemapOptions());
+
+void remapRGBA8Reference(const uint8_t* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                         const float aberr[3], uint8_t* dst);
+void remapDepthReference(const float* src, int srcWidth, int srcHeight, const float* warpMap, int width, int height,
+                         float* dst, RemapFilter filter = RemapFilter::BILINEAR);
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMERA_PARAMS_H
+#define CAMERA_PARAMS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Define an enum for camera types
+enum class DistortionType {
+    PINHOLE,
+    FISHEYE,
+    PANOTOOL,
+    // Dense per-pixel map read from remap_file, see camdistort::RemapFile
+    REMAP,
+    // Usenko et al. double sphere, xi and alpha are stored in radial_distortion_coeffs[0..1]
+    DOUBLE_SPHERE,
+};
+
+// Struct to store camera parameters
+struct CameraParams {
+    DistortionType distortion_type;
+    float width, height;
+    float fx, fy, cx, cy;
+    float radial_distortion_coeffs[4];
+    float tangential_distortion_coeffs[2];
+    // OpenCV extended pinhole terms: k4..k6 of the rational denominator, s1..s4 of the
+    // thin prism and the tau_x, tau_y sensor tilt in radians. All zero for a plain pinhole
+    float rational_distortion_coeffs[3];
+    float thin_prism_coeffs[4];
+    float tilt[2];
+    float aberr_scale[3];
+    float lens_center[2];
+    bool blackout;
+    // Render the exact inverse of the model (a simulated distorted camera) through a
+    // precomputed warp map, solved with up to inverse_iterations Newton steps to a
+    // residual of inverse_tolerance image pixels
+    bool inverse;
+    int inverse_iterations;
+    float inverse_tolerance;
+    // type: remap, remap_stamp changes whenever the file is rewritten
+    std::string remap_file;
+    uint64_t remap_stamp;
+};
+
+// Field-wise comparison, used to detect when derived data (e.g. warp maps) has to be rebuilt
+inline bool operator==(const CameraParams &a, const CameraParams &b){
+    if (a.distortion_type != b.distortion_type || a.blackout != b.blackout ||
+        a.inverse != b.inverse || a.inverse_iterations != b.inverse_iterations || a.inverse_tolerance != b.inverse_tolerance ||
+        a.width != b.width || a.height != b.height ||
+        a.fx != b.fx || a.fy != b.fy || a.cx != b.cx || a.cy != b.cy ||
+        a.remap_file != b.remap_file || a.remap_stamp != b.remap_stamp){
+        return false;
+    }
+    for (int i = 0 ; i < 4 ; i++){
+        if (a.radial_distortion_coeffs[i] != b.radial_distortion_coeffs[i]) return false;
+    }
+    for (int i = 0 ; i < 2 ; i++){
+        if (a.tangential_distortion_coeffs[i] != b.tangential_distortion_coeffs[i]) return false;
+        if (a.lens_center[i] != b.lens_center[i]) return false;
+        if (a.tilt[i] != b.tilt[i]) return false;
+    }
+    for (int i = 0 ; i < 3 ; i++){
+        if (a.aberr_scale[i] != b.aberr_scale[i]) return false;
+        if (a.rational_distortion_coeffs[i] != b.rational_distortion_coeffs[i]) return false;
+    }
+    for (int i = 0 ; i < 4 ; i++){
+        if (a.thin_prism_coeffs[i] != b.thin_prism_coeffs[i]) return false;
+    }
+    return true;
+}
+
+inline bool operator!=(const CameraParams &a, const CameraParams &b){
+    return !(a == b);
+}
+
+// FNV-1a over the fields, tags published frames with the lens model they were rendered with
+inline uint64_t cameraParamsHash(const CameraParams &params){
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t size){
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0 ; i < size ; i++){
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    int type = static_cast<int>(params.distortion_type);
+    unsigned char blackout = params.blackout ? 1 : 0;
+    mix(&type, sizeof(type));
+    const float intrinsics[6] = {params.width, params.height, params.fx, params.fy, params.cx, params.cy};
+    mix(intrinsics, sizeof(intrinsics));
+    mix(params.radial_distortion_coeffs, sizeof(params.radial_distortion_coeffs));
+    mix(params.tangential_distortion_coeffs, sizeof(params.tangential_distortion_coeffs));
+    mix(params.rational_distortion_coeffs, sizeof(params.rational_distortion_coeffs));
+    mix(params.thin_prism_coeffs, sizeof(params.thin_prism_coeffs));
+    mix(params.tilt, sizeof(params.tilt));
+    mix(params.aberr_scale, sizeof(params.aberr_scale));
+    mix(params.lens_center, sizeof(params.lens_center));
+    mix(&blackout, 1);
+    unsigned char inverse = params.inverse ? 1 : 0;
+    mix(&inverse, 1);
+    mix(&params.inverse_iterations, sizeof(params.inverse_iterations));
+    mix(&params.inverse_tolerance, sizeof(params.inverse_tolerance));
+    mix(params.remap_file.data(), params.remap_file.size());
+    mix(&params.remap_stamp, sizeof(params.remap_stamp));
+    return hash;
+}
+
+// True when a PINHOLE camera uses any of the OpenCV rational, thin prism or tilt terms
+inline bool hasExtendedPinholeTerms(const CameraParams &params){
+    for (int i = 0 ; i < 3 ; i++){
+        if (params.rational_distortion_coeffs[i] != 0.0f) return true;
+    }
+    for (int i = 0 ; i < 4 ; i++){
+        if (params.thin_prism_coeffs[i] != 0.0f) return true;
+    }
+    return params.tilt[0] != 0.0f || params.tilt[1] != 0.0f;
+}
+
+#endif
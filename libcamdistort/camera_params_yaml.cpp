@@ -0,0 +1,568 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "camera_params_yaml.h"
+#include "remap_file.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using namespace std;
+
+// Optional list of up to count coefficients, missing entries are zero
+static void readOptionalCoeffs(const YAML::Node &config, const char* key, float* values, size_t count) {
+    for (size_t i = 0 ; i < count ; i++) {
+        values[i] = 0.0f;
+    }
+    if (config[key]) {
+        vector<float> list = config[key].as<vector<float>>();
+        for (size_t i = 0 ; i < count && i < list.size() ; i++) {
+            values[i] = list[i];
+        }
+    }
+}
+
+// OpenCV's (k1, k2, p1, p2[, k3[, k4, k5, k6[, s1, s2, s3, s4[, tau_x, tau_y]]]]) in one list
+static int readOpenCVCoeffs(const YAML::Node &node, CameraParams &params) {
+    vector<float> list = node.as<vector<float>>();
+    if (list.size() != 4 && list.size() != 5 && list.size() != 8 && list.size() != 12 && list.size() != 14) {
+        cerr << "Error: 'opencv_distortion_coeffs' needs 4, 5, 8, 12 or 14 values." << endl;
+        return 0;
+    }
+    list.resize(14, 0.0f);
+    params.radial_distortion_coeffs[0] = list[0];
+    params.radial_distortion_coeffs[1] = list[1];
+    params.radial_distortion_coeffs[2] = list[4];
+    params.radial_distortion_coeffs[3] = 0.0f;
+    params.tangential_distortion_coeffs[0] = list[2];
+    params.tangential_distortion_coeffs[1] = list[3];
+    for (int i = 0 ; i < 3 ; i++) {
+        params.rational_distortion_coeffs[i] = list[5 + i];
+    }
+    for (int i = 0 ; i < 4 ; i++) {
+        params.thin_prism_coeffs[i] = list[8 + i];
+    }
+    params.tilt[0] = list[12];
+    params.tilt[1] = list[13];
+    return 1;
+}
+
+// Function to read YAML file and extract camera parameters
+int readCameraParams(const string &filename, CameraParams &params) {
+    try {
+        YAML::Node config = YAML::LoadFile(filename);
+
+        // Read camera type
+        if (!config["type"] || !config["type"].IsScalar()) {
+            cerr << "Error: Missing or invalid 'type' field." << endl;
+            return 0;
+        }
+        if (config["type"].as<string>() == "pinhole"){
+            params.distortion_type = DistortionType::PINHOLE;
+            cout << "distortion_type: PINHOLE " << static_cast<int>(DistortionType::PINHOLE)<< endl;
+        }
+        else if (config["type"].as<string>() == "fisheye"){
+            params.distortion_type = DistortionType::FISHEYE;
+            cout << "distortion_type: FISHEYE " << static_cast<int>(DistortionType::FISHEYE)<< endl;
+        }
+        else if (config["type"].as<string>() == "panotool"){
+            params.distortion_type = DistortionType::PANOTOOL;
+            cout << "distortion_type: PANOTOOL " << static_cast<int>(DistortionType::PANOTOOL)<< endl;
+        }
+        else if (config["type"].as<string>() == "remap"){
+            params.distortion_type = DistortionType::REMAP;
+            cout << "distortion_type: REMAP " << static_cast<int>(DistortionType::REMAP)<< endl;
+        }
+        else if (config["type"].as<string>() == "double_sphere"){
+            params.distortion_type = DistortionType::DOUBLE_SPHERE;
+            cout << "distortion_type: DOUBLE_SPHERE " << static_cast<int>(DistortionType::DOUBLE_SPHERE)<< endl;
+        }
+        else {
+            // Falling through would silently turn a misspelled type into the previous model
+            cerr << "Error: unknown 'type' " << config["type"].as<string>()
+                 << ", expected pinhole, fisheye, panotool, remap or double_sphere." << endl;
+            return 0;
+        }
+
+        // Dense map of type: remap, relative paths are relative to the calibration file
+        params.remap_file.clear();
+        params.remap_stamp = 0;
+        if (params.distortion_type == DistortionType::REMAP) {
+            if (!config["remap_file"]) {
+                cerr << "Error: 'type: remap' needs a 'remap_file'." << endl;
+                return 0;
+            }
+            params.remap_file = config["remap_file"].as<string>();
+            size_t slash = filename.find_last_of('/');
+            if (params.remap_file[0] != '/' && slash != string::npos) {
+                params.remap_file = filename.substr(0, slash + 1) + params.remap_file;
+            }
+            camdistort::RemapFile file;
+            if (!file.open(params.remap_file)) {
+                return 0;
+            }
+            params.remap_stamp = camdistort::getRemapFileStamp(params.remap_file);
+
+            // image_size and the intrinsics default to the image the map points into,
+            // the principal point to its center. Any fx = fy puts the blackout circle
+            // inscribed in the image.
+            double sourceWidth = file.getSourceWidth();
+            double sourceHeight = file.getSourceHeight();
+            if (!config["image_size"]) {
+                config["image_size"].push_back(sourceWidth);
+                config["image_size"].push_back(sourceHeight);
+            }
+            if (!config["intrinsic"]) {
+                config["intrinsic"]["fx"] = max(sourceWidth, sourceHeight);
+                config["intrinsic"]["fy"] = max(sourceWidth, sourceHeight);
+                config["intrinsic"]["cx"] = sourceWidth / 2.0;
+                config["intrinsic"]["cy"] = sourceHeight / 2.0;
+            }
+            cout << "remap_file: " << params.remap_file << " [" << file.getWidth() << "x" << file.getHeight() << "] into ["
+                 << file.getSourceWidth() << "x" << file.getSourceHeight() << "]"
+                 << (file.getFormat() == camdistort::RemapFormat::FLOAT16_OFFSET ? " (half offsets)" : "") << endl;
+        }
+
+        // Read intrinsic parameters
+        if (!config["intrinsic"] || !config["intrinsic"].IsMap()) {
+            cerr << "Error: Missing or invalid 'intrinsic' field." << endl;
+            return 0;
+        }
+
+        try {
+            params.fx = config["intrinsic"]["fx"].as<double>();
+            params.fy = config["intrinsic"]["fy"].as<double>();
+            params.cx = config["intrinsic"]["cx"].as<double>();
+            params.cy = config["intrinsic"]["cy"].as<double>();
+
+
+            if (config["image_size"]){
+                params.width = config["image_size"].as<vector<double>>()[0];
+                params.height = config["image_size"].as<vector<double>>()[1];
+                params.lens_center[0] = params.cx/params.width;
+                params.lens_center[1] = params.cy/params.height;
+
+                cout << "image_size: [" << params.width << "," << params.height << ']' << endl;
+                cout << "len center: [" << params.lens_center[0]  << "," << params.lens_center[1] << ']' << endl;
+            }  
+
+            else{
+                params.lens_center[0] = 0.5;
+                params.lens_center[1] = 0.5;
+            }
+
+
+        } catch (const YAML::Exception &e) {
+            cerr << "Error reading intrinsic parameters: " << e.what() << endl;
+            return 0;
+        }
+
+        // Read radial distortion coefficients
+        if (!config["radial_distortion_coeffs"] || !config["radial_distortion_coeffs"].IsSequence()) {
+            cerr << "[CAUTION!] Missing or invalid 'radial distortion_coeffs' field." << endl;
+            for (size_t i = 0 ; i < 4; i++){
+                params.radial_distortion_coeffs[i] = 0.0;
+            }
+        }
+
+        else{
+            for (size_t i = 0 ; i < 4; i++) {
+                params.radial_distortion_coeffs[i] = config["radial_distortion_coeffs"].as<vector<float>>()[i];
+            }
+        }
+
+        // Read tangential distortion coefficients
+        if (!config["tangential_distortion_coeffs"] || !config["tangential_distortion_coeffs"].IsSequence()) {
+            cerr << "[CAUTION!] Missing or invalid 'tangential distortion_coeffs' field." << endl;
+            for (size_t i = 0 ; i < 2; i++){
+                params.tangential_distortion_coeffs[i] = 0.0;
+            }
+        }
+
+        else{
+            for (size_t i = 0 ; i < 2; i++) {
+                params.tangential_distortion_coeffs[i] = config["tangential_distortion_coeffs"].as<vector<float>>()[i];
+            }
+        }
+
+        // OpenCV rational, thin prism and tilt terms of the pinhole model
+        readOptionalCoeffs(config, "rational_distortion_coeffs", params.rational_distortion_coeffs, 3);
+        readOptionalCoeffs(config, "thin_prism_coeffs", params.thin_prism_coeffs, 4);
+        readOptionalCoeffs(config, "tilt", params.tilt, 2);
+        if (config["opencv_distortion_coeffs"] && !readOpenCVCoeffs(config["opencv_distortion_coeffs"], params)) {
+            return 0;
+        }
+        if (params.distortion_type != DistortionType::PINHOLE && hasExtendedPinholeTerms(params)) {
+            cerr << "[CAUTION!] Rational, thin prism and tilt terms only apply to 'type: pinhole', ignoring them." << endl;
+            fill(params.rational_distortion_coeffs, params.rational_distortion_coeffs + 3, 0.0f);
+            fill(params.thin_prism_coeffs, params.thin_prism_coeffs + 4, 0.0f);
+            fill(params.tilt, params.tilt + 2, 0.0f);
+        }
+
+        // Double sphere parameters share the radial slots, as the panotool ones do
+        if (params.distortion_type == DistortionType::DOUBLE_SPHERE) {
+            if (!config["xi"] || !config["alpha"]) {
+                cerr << "Error: 'type: double_sphere' needs 'xi' and 'alpha'." << endl;
+                return 0;
+            }
+            params.radial_distortion_coeffs[0] = config["xi"].as<float>();
+            params.radial_distortion_coeffs[1] = config["alpha"].as<float>();
+            params.radial_distortion_coeffs[2] = 0.0f;
+            params.radial_distortion_coeffs[3] = 0.0f;
+            cerr << "Double sphere: xi " << params.radial_distortion_coeffs[0] << ", alpha " << params.radial_distortion_coeffs[1] << endl;
+        }
+
+        cerr << "Distortion Coefficient:" << endl;
+        cerr << "Radial: " << 
+                params.radial_distortion_coeffs[0] << "," << 
+                params.radial_distortion_coeffs[1] << "," << 
+                params.radial_distortion_coeffs[2] << "," << 
+                params.radial_distortion_coeffs[3] << endl;
+
+        cerr << "Tangential: " << 
+                params.tangential_distortion_coeffs[0] << "," << 
+                params.tangential_distortion_coeffs[1] << endl;
+
+        if (hasExtendedPinholeTerms(params)) {
+            cerr << "Rational: " << params.rational_distortion_coeffs[0] << "," << params.rational_distortion_coeffs[1] << ","
+                 << params.rational_distortion_coeffs[2] << endl;
+            cerr << "Thin prism: " << params.thin_prism_coeffs[0] << "," << params.thin_prism_coeffs[1] << ","
+                 << params.thin_prism_coeffs[2] << "," << params.thin_prism_coeffs[3] << endl;
+            cerr << "Tilt: " << params.tilt[0] << "," << params.tilt[1] << endl;
+        }
+
+
+        // Read chromatic distortion coefficient
+        if (!config["chromatic_distortion"] || !config["chromatic_distortion"].IsSequence()) {
+            cerr << "[CAUTION!] Missing or invalid 'chromatic_distortion' field." << endl;
+            for (size_t i = 0 ; i < 3; i++){
+                params.aberr_scale[i] = 1.0;
+            }
+        }
+    
+        else{
+            for (size_t i = 0 ; i < 3; i++) {
+                params.aberr_scale[i] = config["chromatic_distortion"].as<vector<float>>()[i];
+            }
+        }
+
+        cerr << "Chromatic distortion Coefficient:" <<
+                params.aberr_scale[0] << "," << 
+                params.aberr_scale[1] << "," << 
+                params.aberr_scale[2] << endl;
+
+        // Whether to overlay blackout except for circular viewing region
+        if (!config["blackout"]) {
+            cerr << "[CAUTION!] Missing or invalid 'blackout' field." << endl;
+            params.blackout = false;
+        } else {
+            params.blackout = config["blackout"].as<bool>();
+        }
+
+        cerr << "Blackout: " << 
+                params.blackout << endl;
+
+        // Optional exact inverse of the model, solved once into a warp map
+        params.inverse = false;
+        params.inverse_iterations = 20;
+        params.inverse_tolerance = 0.01f;
+        if (config["warp_direction"]){
+            string direction = config["warp_direction"].as<string>();
+            if (direction == "inverse"){
+                params.inverse = true;
+            }
+            else if (direction != "forward"){
+                cerr << "[CAUTION!] Unknown 'warp_direction' " << direction << ", using forward." << endl;
+            }
+        }
+        if (config["inverse_iterations"]){
+            params.inverse_iterations = config["inverse_iterations"].as<int>();
+        }
+        if (config["inverse_tolerance"]){
+            params.inverse_tolerance = config["inverse_tolerance"].as<float>();
+        }
+        if (params.inverse){
+            cerr << "Warp direction: inverse (" << params.inverse_iterations << " iterations, tolerance "
+                 << params.inverse_tolerance << " px)" << endl;
+        }
+
+        // Validate coefficient count based on type
+        // if ((params.camera_type == "fisheye" && params.distortion_coefs.size() != 4) ||
+        //     (params.camera_type == "pinhole" && params.distortion_coefs.size() != 5)) {
+        //     cerr << "Error: Incorrect number of distortion coefficients for " << params.camera_type << " camera." << endl;
+        //     return 0;
+        // }
+
+        return 1;
+    } catch (const YAML::Exception &e) {
+        cerr << "YAML parse error: " << e.what() << endl;
+        return 0;
+    }
+}
+
+
+int validateCameraParams(const CameraParams &params) {
+    if (static_cast<int>(params.distortion_type) < static_cast<int>(DistortionType::PINHOLE) ||
+        static_cast<int>(params.distortion_type) > static_cast<int>(DistortionType::DOUBLE_SPHERE)) {
+        cerr << "Error: unknown distortion type " << static_cast<int>(params.distortion_type) << "." << endl;
+        return 0;
+    }
+    if (!(params.width > 0.0f) || !(params.height > 0.0f)) {
+        cerr << "Error: 'image_size' must be positive." << endl;
+        return 0;
+    }
+    if (!(params.fx > 0.0f) || !(params.fy > 0.0f)) {
+        cerr << "Error: focal lengths 'fx' and 'fy' must be positive." << endl;
+        return 0;
+    }
+    const float center[2] = {params.cx, params.cy};
+    const float* values[7] = {params.radial_distortion_coeffs, params.tangential_distortion_coeffs, params.aberr_scale, center,
+                              params.rational_distortion_coeffs, params.thin_prism_coeffs, params.tilt};
+    const int counts[7] = {4, 2, 3, 2, 3, 4, 2};
+    for (int v = 0 ; v < 7 ; v++) {
+        for (int i = 0 ; i < counts[v] ; i++) {
+            if (!std::isfinite(values[v][i])) {
+                cerr << "Error: distortion coefficients and center must be finite." << endl;
+                return 0;
+            }
+        }
+    }
+    for (int i = 0 ; i < 3 ; i++) {
+        if (!(params.aberr_scale[i] > 0.0f)) {
+            cerr << "Error: 'chromatic_distortion' scales must be positive." << endl;
+            return 0;
+        }
+    }
+    if (params.distortion_type == DistortionType::DOUBLE_SPHERE &&
+        !(params.radial_distortion_coeffs[1] >= 0.0f && params.radial_distortion_coeffs[1] <= 1.0f)) {
+        cerr << "Error: double sphere 'alpha' must be in [0, 1]." << endl;
+        return 0;
+    }
+    if (params.distortion_type == DistortionType::REMAP && params.remap_stamp == 0) {
+        cerr << "Error: 'remap_file' " << params.remap_file << " does not exist." << endl;
+        return 0;
+    }
+    if (params.inverse && (params.inverse_iterations <= 0 || !(params.inverse_tolerance > 0.0f))) {
+        cerr << "Error: 'inverse_iterations' and 'inverse_tolerance' must be positive." << endl;
+        return 0;
+    }
+    return 1;
+}
+
+
+// Exactly count coefficients if the keyframe overrides key, a short list rejects the keyframe
+static int readKeyframeCoeffs(const YAML::Node &keyframe, const char* key, float* values, size_t count) {
+    if (!keyframe[key]) {
+        return 1;
+    }
+    vector<float> list = keyframe[key].as<vector<float>>();
+    if (list.size() != count) {
+        cerr << "Error: keyframe '" << key << "' needs " << count << " values, got " << list.size() << "." << endl;
+        return 0;
+    }
+    for (size_t i = 0 ; i < count ; i++) {
+        values[i] = list[i];
+    }
+    return 1;
+}
+
+// Override the fields of params a keyframe may vary
+static int readKeyframeParams(const YAML::Node &keyframe, bool hasImageSize, CameraParams &params) {
+    for (YAML::const_iterator it = keyframe.begin() ; it != keyframe.end() ; ++it) {
+        string key = it->first.as<string>();
+        if (key != "zoom" && key != "focus" && key != "intrinsic" && key != "radial_distortion_coeffs" &&
+            key != "tangential_distortion_coeffs" && key != "chromatic_distortion" && key != "rational_distortion_coeffs" &&
+            key != "thin_prism_coeffs" && key != "tilt" && key != "opencv_distortion_coeffs" && key != "xi" && key != "alpha") {
+            cerr << "Error: '" << key << "' can not vary between keyframes." << endl;
+            return 0;
+        }
+    }
+
+    if (keyframe["intrinsic"]) {
+        const char* names[4] = {"fx", "fy", "cx", "cy"};
+        float* values[4] = {&params.fx, &params.fy, &params.cx, &params.cy};
+        for (int i = 0 ; i < 4 ; i++) {
+            if (keyframe["intrinsic"][names[i]]) {
+                *values[i] = keyframe["intrinsic"][names[i]].as<double>();
+            }
+        }
+        // Derived from the center as in readCameraParams
+        if (hasImageSize) {
+            params.lens_center[0] = params.cx/params.width;
+            params.lens_center[1] = params.cy/params.height;
+        }
+    }
+    if (!readKeyframeCoeffs(keyframe, "radial_distortion_coeffs", params.radial_distortion_coeffs, 4) ||
+        !readKeyframeCoeffs(keyframe, "tangential_distortion_coeffs", params.tangential_distortion_coeffs, 2) ||
+        !readKeyframeCoeffs(keyframe, "chromatic_distortion", params.aberr_scale, 3) ||
+        !readKeyframeCoeffs(keyframe, "rational_distortion_coeffs", params.rational_distortion_coeffs, 3) ||
+        !readKeyframeCoeffs(keyframe, "thin_prism_coeffs", params.thin_prism_coeffs, 4) ||
+        !readKeyframeCoeffs(keyframe, "tilt", params.tilt, 2)) {
+        return 0;
+    }
+    if (keyframe["opencv_distortion_coeffs"] && !readOpenCVCoeffs(keyframe["opencv_distortion_coeffs"], params)) {
+        return 0;
+    }
+    if (params.distortion_type == DistortionType::DOUBLE_SPHERE) {
+        if (keyframe["xi"]) {
+            params.radial_distortion_coeffs[0] = keyframe["xi"].as<float>();
+        }
+        if (keyframe["alpha"]) {
+            params.radial_distortion_coeffs[1] = keyframe["alpha"].as<float>();
+        }
+    }
+    return 1;
+}
+
+int readLensSchedule(const string &filename, const CameraParams &base, camdistort::LensSchedule &schedule) {
+    schedule.clear();
+    try {
+        YAML::Node config = YAML::LoadFile(filename);
+        if (!config["keyframes"]) {
+            return 1;
+        }
+        if (!config["keyframes"].IsSequence()) {
+            cerr << "Error: 'keyframes' must be a list." << endl;
+            return 0;
+        }
+
+        for (size_t k = 0 ; k < config["keyframes"].size() ; k++) {
+            YAML::Node node = config["keyframes"][k];
+            if (!node.IsMap() || !node["zoom"]) {
+                cerr << "Error: keyframe " << k << " has no 'zoom'." << endl;
+                return 0;
+            }
+            camdistort::LensKeyframe keyframe;
+            keyframe.zoom = node["zoom"].as<float>();
+            keyframe.focus = node["focus"] ? node["focus"].as<float>() : 0.0f;
+            keyframe.params = base;
+            if (!readKeyframeParams(node, static_cast<bool>(config["image_size"]), keyframe.params) || !validateCameraParams(keyframe.params)) {
+                cerr << "Error: invalid keyframe " << k << " (zoom " << keyframe.zoom << ", focus " << keyframe.focus << ")." << endl;
+                return 0;
+            }
+            schedule.addKeyframe(keyframe);
+        }
+
+        cerr << "Lens keyframes: " << schedule.size() << endl;
+        return 1;
+    } catch (const YAML::Exception &e) {
+        cerr << "YAML parse error: " << e.what() << endl;
+        schedule.clear();
+        return 0;
+    }
+}
+
+int readSensorChain(const string &filename, camdistort::SensorChain &chain) {
+    chain.clear();
+    try {
+        YAML::Node config = YAML::LoadFile(filename);
+        if (!config["sensor_stages"]) {
+            return 1;
+        }
+        if (!config["sensor_stages"].IsSequence()) {
+            cerr << "Error: 'sensor_stages' must be a list." << endl;
+            return 0;
+        }
+
+        for (size_t i = 0 ; i < config["sensor_stages"].size() ; i++) {
+            YAML::Node node = config["sensor_stages"][i];
+            if (!node.IsMap() || !node["type"]) {
+                cerr << "Error: sensor stage " << i << " has no 'type'." << endl;
+                return 0;
+            }
+            string type = node["type"].as<string>();
+            camdistort::SensorStage stage;
+            if (type == "vignette") {
+                stage.type = camdistort::SensorStageType::VIGNETTE;
+                stage.values[0] = node["strength"] ? node["strength"].as<float>() : 1.0f;
+                stage.values[1] = node["exponent"] ? node["exponent"].as<float>() : 4.0f;
+            } else if (type == "noise") {
+                stage.type = camdistort::SensorStageType::NOISE;
+                stage.values[0] = node["shot"] ? node["shot"].as<float>() : 0.0f;
+                stage.values[1] = node["read"] ? node["read"].as<float>() : 0.0f;
+            } else if (type == "bayer") {
+                stage.type = camdistort::SensorStageType::BAYER;
+                string pattern = node["pattern"] ? node["pattern"].as<string>() : "rggb";
+                static const char* patterns[4] = {"rggb", "grbg", "gbrg", "bggr"};
+                stage.values[0] = -1.0f;
+                for (int p = 0 ; p < 4 ; p++) {
+                    if (pattern == patterns[p]) {
+                        stage.values[0] = static_cast<float>(p);
+                    }
+                }
+                if (stage.values[0] < 0.0f) {
+                    cerr << "Error: unknown bayer pattern '" << pattern << "', expected rggb, grbg, gbrg or bggr." << endl;
+                    return 0;
+                }
+                stage.values[1] = 0.0f;
+            } else if (type == "tone") {
+                stage.type = camdistort::SensorStageType::TONE;
+                stage.values[0] = node["exposure"] ? node["exposure"].as<float>() : 1.0f;
+                stage.values[1] = node["white"] ? node["white"].as<float>() : 4.0f;
+            } else if (type == "gamma") {
+                stage.type = camdistort::SensorStageType::GAMMA;
+                stage.values[0] = node["gamma"] ? node["gamma"].as<float>() : 2.2f;
+                stage.values[1] = 0.0f;
+            } else {
+                cerr << "Error: unknown sensor stage type '" << type << "'." << endl;
+                return 0;
+            }
+            chain.push_back(stage);
+        }
+
+        if (!camdistort::validateSensorChain(chain)) {
+            chain.clear();
+            return 0;
+        }
+        cerr << "Sensor stages: " << chain.size() << endl;
+        return 1;
+    } catch (const YAML::Exception &e) {
+        cerr << "YAML parse error: " << e.what() << endl;
+        chain.clear();
+        return 0;
+    }
+}
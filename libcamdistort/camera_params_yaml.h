@@ -0,0 +1,73 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMERA_PARAMS_YAML_H
+#define CAMERA_PARAMS_YAML_H
+
+#include <string>
+#include "camera_params.h"
+#include "lens_schedule.h"
+#include "sensor_chain.h"
+
+// Read a calibration file in the format of example/config_file/*.yaml.
+// Returns 1 on success and 0 on error.
+int readCameraParams(const std::string &filename, CameraParams &params);
+
+// Check a set of parameters for values the distortion models can not use, e.g.
+// before a reloaded calibration replaces the current one. Returns 1 if the
+// parameters are usable and 0 otherwise, the reason is printed.
+int validateCameraParams(const CameraParams &params);
+
+// Read the optional 'keyframes' of a calibration file, the calibrations of a zoom /
+// focus lens. Every keyframe starts from base, the parameters of the same file, and
+// overrides its intrinsic, distortion and chromatic coefficients. schedule is left
+// empty if the file has no keyframes. Returns 1 on success and 0 on error.
+int readLensSchedule(const std::string &filename, const CameraParams &base, camdistort::LensSchedule &schedule);
+
+// Read the optional 'sensor_stages' of a calibration file, in order. chain is left
+// empty if the file has none. Returns 1 on success and 0 on error.
+int readSensorChain(const std::string &filename, camdistort::SensorChain &chain);
+
+#endif
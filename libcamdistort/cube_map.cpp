@@ -0,0 +1,319 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "cube_map.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace camdistort {
+
+void getCubeFaceBasis(CubeFace face, float look[3], float right[3], float up[3])
+{
+    static const float bases[CUBE_FACE_COUNT][3][3] = {
+        // look, right, up
+        {{0, 0, 1}, {1, 0, 0}, {0, -1, 0}},
+        {{1, 0, 0}, {0, 0, -1}, {0, -1, 0}},
+        {{-1, 0, 0}, {0, 0, 1}, {0, -1, 0}},
+        {{0, -1, 0}, {1, 0, 0}, {0, 0, -1}},
+        {{0, 1, 0}, {1, 0, 0}, {0, 0, 1}},
+        {{0, 0, -1}, {-1, 0, 0}, {0, -1, 0}},
+    };
+    const int f = static_cast<int>(face);
+    for (int i = 0 ; i < 3 ; i++){
+        look[i] = bases[f][0][i];
+        right[i] = bases[f][1][i];
+        up[i] = bases[f][2][i];
+    }
+}
+
+CubeFace directionToCubeFace(const float dir[3], float &u, float &v)
+{
+    const float ax = std::fabs(dir[0]), ay = std::fabs(dir[1]), az = std::fabs(dir[2]);
+    // ties go to z, then x, as in the shader
+    CubeFace face;
+    if (az >= ax && az >= ay){
+        face = dir[2] >= 0.0f ? CubeFace::FRONT : CubeFace::BACK;
+    }
+    else if (ax >= ay){
+        face = dir[0] >= 0.0f ? CubeFace::RIGHT : CubeFace::LEFT;
+    }
+    else{
+        face = dir[1] >= 0.0f ? CubeFace::DOWN : CubeFace::UP;
+    }
+    float look[3], right[3], up[3];
+    getCubeFaceBasis(face, look, right, up);
+    float depth = dir[0] * look[0] + dir[1] * look[1] + dir[2] * look[2];
+    u = 0.5f + 0.5f * (dir[0] * right[0] + dir[1] * right[1] + dir[2] * right[2]) / depth;
+    v = 0.5f + 0.5f * (dir[0] * up[0] + dir[1] * up[1] + dir[2] * up[2]) / depth;
+    return face;
+}
+
+void aberrateDirection(const float dir[3], float s, float out[3])
+{
+    float lateral = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1]);
+    if (lateral <= 0.0f || s == 1.0f){
+        out[0] = dir[0]; out[1] = dir[1]; out[2] = dir[2];
+        return;
+    }
+    float theta = std::acos(std::max(-1.0f, std::min(1.0f, dir[2]))) * s;
+    float k = std::sin(theta) / lateral;
+    out[0] = dir[0] * k;
+    out[1] = dir[1] * k;
+    out[2] = std::cos(theta);
+}
+
+// Ray of the normalized distorted coordinate (mx, my), false if it has no inverse
+static bool solveRay(const CameraParams &params, double mx, double my, const WarpMapOptions &options,
+                     double dir[3], double &residual)
+{
+    const double focal = std::max(params.fx, params.fy);
+    // Closed form, including the rays past 90 degrees a pinhole can not represent
+    if (params.distortion_type == DistortionType::DOUBLE_SPHERE){
+        residual = 0.0;
+        if (!unprojectDoubleSphere(params.radial_distortion_coeffs[0], params.radial_distortion_coeffs[1], mx, my, dir)){
+            return false;
+        }
+        double n = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        dir[0] /= n;
+        dir[1] /= n;
+        dir[2] /= n;
+        return true;
+    }
+    if (params.distortion_type != DistortionType::FISHEYE){
+        double x, y;
+        undistortPoint(params, mx, my, x, y, options.iterations, options.tolerance / focal);
+        double fx, fy;
+        distortPoint(params, x, y, fx, fy);
+        residual = std::sqrt((fx - mx) * (fx - mx) + (fy - my) * (fy - my)) * focal;
+        double n = std::sqrt(x * x + y * y + 1.0);
+        dir[0] = x / n;
+        dir[1] = y / n;
+        dir[2] = 1.0 / n;
+        return residual < options.tolerance;
+    }
+
+    // Newton on the incidence angle, as the INVERSE fisheye kernel, without going
+    // through tan() so that angles past 90 degrees stay representable
+    const float* k = params.radial_distortion_coeffs;
+    double rdm = std::sqrt(mx * mx + my * my);
+    double thd = std::atan(rdm);
+    double th = thd;
+    double g = 0.0;
+    for (int i = 0 ; i < options.iterations ; i++){
+        double t2 = th * th;
+        g = th * (1.0 + t2 * (k[0] + t2 * (k[1] + t2 * (k[2] + t2 * k[3])))) - thd;
+        double slope = 1.0 + t2 * (3.0 * k[0] + t2 * (5.0 * k[1] + t2 * (7.0 * k[2] + t2 * 9.0 * k[3])));
+        if (slope <= 0.0){
+            break;
+        }
+        th -= g / slope;
+    }
+    double t2 = th * th;
+    g = th * (1.0 + t2 * (k[0] + t2 * (k[1] + t2 * (k[2] + t2 * k[3])))) - thd;
+    // d tan(theta_d) = (1 + |m|^2) d theta_d
+    residual = std::fabs(g) * (1.0 + rdm * rdm) * focal;
+    double s = rdm > 0.0 ? std::sin(th) / rdm : 0.0;
+    dir[0] = mx * s;
+    dir[1] = my * s;
+    dir[2] = std::cos(th);
+    return residual < options.tolerance && th >= 0.0 && th < M_PI;
+}
+
+void buildDirectionMap(const CameraParams &params, int width, int height, float* xyzw,
+                       const WarpMapOptions &options, WarpMapReport* report)
+{
+    if (report){
+        *report = WarpMapReport();
+    }
+    if (width <= 0 || height <= 0){
+        return;
+    }
+    // A remap has no rays to follow past the source image
+    if (params.distortion_type == DistortionType::REMAP){
+        std::fill(xyzw, xyzw + 4 * (size_t)width * height, 0.0f);
+        return;
+    }
+    const WarpGeometry g = computeWarpGeometry(params, width, height);
+    const int tileRows = options.tileRows > 0 ? options.tileRows : 16;
+    const int tiles = (height + tileRows - 1) / tileRows;
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::getDefault();
+    std::mutex reportMutex;
+    pool.parallelFor(tiles, [&](int t){
+        WarpMapReport tile;
+        const int y0 = t * tileRows, y1 = std::min(height, y0 + tileRows);
+        for (int yi = y0 ; yi < y1 ; yi++){
+            for (int xi = 0 ; xi < width ; xi++){
+                // same sub-window mapping as the warp map, rows bottom-up
+                double loc[2] = {(xi + 0.5) / g.window[0], 1.0 - (yi + 0.5) / g.window[1]};
+                double r[2];
+                for (int i = 0 ; i < 2 ; i++){
+                    r[i] = ((loc[i] * g.window[i] - g.subWindowOffset[i]) * g.image[i] / g.subWindowSize[i] - g.center[i]) / g.focal[i];
+                }
+                float* texel = xyzw + 4 * ((size_t)yi * width + xi);
+                texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+                if (g.blackout && std::sqrt(r[0] * r[0] + r[1] * r[1]) > g.blackoutRadius){
+                    continue;
+                }
+                double dir[3], residual;
+                bool converged = solveRay(params, r[0], r[1], options, dir, residual);
+                tile.solvedPixels++;
+                if (residual > tile.maxResidual){
+                    tile.maxResidual = static_cast<float>(residual);
+                }
+                if (!converged){
+                    tile.nonConverged++;
+                    continue;
+                }
+                texel[0] = static_cast<float>(dir[0]);
+                texel[1] = static_cast<float>(dir[1]);
+                texel[2] = static_cast<float>(dir[2]);
+                texel[3] = 1.0f;
+            }
+        }
+        if (report){
+            std::lock_guard<std::mutex> lock(reportMutex);
+            report->maxResidual = std::max(report->maxResidual, tile.maxResidual);
+            report->solvedPixels += tile.solvedPixels;
+            report->nonConverged += tile.nonConverged;
+        }
+    });
+}
+
+CubeFootprint analyzeDirectionMap(const float* xyzw, int width, int height, const float aberr[3], ThreadPool* pool)
+{
+    CubeFootprint footprint;
+    for (int f = 0 ; f < CUBE_FACE_COUNT ; f++){
+        footprint.faces[f].minScale = std::numeric_limits<float>::max();
+    }
+    if (width <= 0 || height <= 0){
+        return footprint;
+    }
+    const int tileRows = 16;
+    const int tiles = (height + tileRows - 1) / tileRows;
+    ThreadPool& p = pool ? *pool : ThreadPool::getDefault();
+    std::mutex footprintMutex;
+    p.parallelFor(tiles, [&](int t){
+        CubeFootprint tile;
+        for (int f = 0 ; f < CUBE_FACE_COUNT ; f++){
+            tile.faces[f].minScale = std::numeric_limits<float>::max();
+        }
+        const int y0 = t * tileRows, y1 = std::min(height, y0 + tileRows);
+        for (int y = y0 ; y < y1 ; y++){
+            for (int x = 0 ; x < width ; x++){
+                const float* texel = xyzw + 4 * ((size_t)y * width + x);
+                if (texel[3] <= 0.0f){
+                    continue;
+                }
+                float u, v;
+                const int face = static_cast<int>(directionToCubeFace(texel, u, v));
+                SourceFootprint &bounds = tile.faces[face];
+                bounds.validPixels++;
+
+                // every channel has to find its face texel
+                for (int c = 0 ; c < 3 ; c++){
+                    float dir[3], cu, cv;
+                    aberrateDirection(texel, aberr[c], dir);
+                    SourceFootprint &channelBounds = tile.faces[static_cast<int>(directionToCubeFace(dir, cu, cv))];
+                    channelBounds.uvMin[0] = std::min(channelBounds.uvMin[0], cu);
+                    channelBounds.uvMin[1] = std::min(channelBounds.uvMin[1], cv);
+                    channelBounds.uvMax[0] = std::max(channelBounds.uvMax[0], cu);
+                    channelBounds.uvMax[1] = std::max(channelBounds.uvMax[1], cv);
+                }
+
+                // Finite differences towards valid neighbours on the same face
+                float j[2][2];
+                bool ok = true;
+                for (int axis = 0 ; axis < 2 && ok ; axis++){
+                    int nx = x + (axis == 0), ny = y + (axis == 1);
+                    float sign = 1.0f;
+                    float nu = 0.0f, nv = 0.0f;
+                    bool found = false;
+                    for (int attempt = 0 ; attempt < 2 && !found ; attempt++){
+                        if (nx >= 0 && ny >= 0 && nx < width && ny < height){
+                            const float* neighbour = xyzw + 4 * ((size_t)ny * width + nx);
+                            found = neighbour[3] > 0.0f && static_cast<int>(directionToCubeFace(neighbour, nu, nv)) == face;
+                        }
+                        if (!found){
+                            nx = x - (axis == 0);
+                            ny = y - (axis == 1);
+                            sign = -1.0f;
+                        }
+                    }
+                    if (!found){
+                        ok = false;
+                        break;
+                    }
+                    j[0][axis] = sign * (nu - u);
+                    j[1][axis] = sign * (nv - v);
+                }
+                if (ok){
+                    bounds.minScale = std::min(bounds.minScale, kernels::minSingularValue(j[0][0], j[0][1], j[1][0], j[1][1]));
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(footprintMutex);
+        for (int f = 0 ; f < CUBE_FACE_COUNT ; f++){
+            SourceFootprint &merged = footprint.faces[f];
+            const SourceFootprint &bounds = tile.faces[f];
+            for (int i = 0 ; i < 2 ; i++){
+                merged.uvMin[i] = std::min(merged.uvMin[i], bounds.uvMin[i]);
+                merged.uvMax[i] = std::max(merged.uvMax[i], bounds.uvMax[i]);
+            }
+            merged.minScale = std::min(merged.minScale, bounds.minScale);
+            merged.validPixels += bounds.validPixels;
+        }
+    });
+    for (int f = 0 ; f < CUBE_FACE_COUNT ; f++){
+        if (footprint.faces[f].minScale == std::numeric_limits<float>::max()){
+            footprint.faces[f].minScale = 0.0f;
+        }
+    }
+    return footprint;
+}
+
+}
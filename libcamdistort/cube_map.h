@@ -0,0 +1,103 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_CUBE_MAP_H
+#define CAMDISTORT_CUBE_MAP_H
+
+// Direction based source for lenses wider than a single perspective image can feed.
+// Every output pixel is turned into the ray the calibrated camera sees through it,
+// and the scene is rendered into the faces of a cube around the camera. Directions
+// are in the camera frame of the calibration: x right, y down, z forward.
+
+#include "camdistort.h"
+
+namespace camdistort {
+
+// Face order, shared with example/shaders/camera_distortion.fs
+enum class CubeFace {
+    FRONT,
+    RIGHT,
+    LEFT,
+    UP,
+    DOWN,
+    BACK,
+};
+
+const int CUBE_FACE_COUNT = 6;
+
+// Viewing direction, image right and image up of a face rendered with a 90 degree
+// square frustum. right x up = -look for every face.
+void getCubeFaceBasis(CubeFace face, float look[3], float right[3], float up[3]);
+
+// Face a direction falls on and its texture coordinate on that face, in [0, 1]
+// with v pointing up like the rendered framebuffer
+CubeFace directionToCubeFace(const float dir[3], float &u, float &v);
+
+// Direction of a color channel with chromatic aberration scale s: the angle to the
+// optical axis is scaled, like the displacement of the planar models
+void aberrateDirection(const float dir[3], float s, float out[3]);
+
+// Fill xyzw (4 * width * height floats, rows bottom-up like buildWarpMap()) with the
+// unit ray direction of every output pixel and w = 1. Pixels outside the blackout
+// circle or whose inverse did not converge are (0, 0, 0, 0). The lens model is
+// inverted as in WarpDirection::INVERSE with the iterations and tolerance of
+// options; fisheye rays are solved on the incidence angle, so they may reach past
+// 90 degrees off axis. type: remap has no directions, every pixel is invalid.
+void buildDirectionMap(const CameraParams &params, int width, int height, float* xyzw,
+                       const WarpMapOptions &options = WarpMapOptions(), WarpMapReport* report = nullptr);
+
+// Per face bounds of a direction map. uvMin / uvMax are face texture coordinates over
+// the three color channels; minScale is in face texture units per output pixel, so a
+// face of 1 / (stretch * minScale) texels keeps every texel below stretch output
+// pixels. Faces with empty bounds are never sampled and need not be rendered.
+struct CubeFootprint {
+    SourceFootprint faces[CUBE_FACE_COUNT];
+};
+
+CubeFootprint analyzeDirectionMap(const float* xyzw, int width, int height, const float aberr[3], ThreadPool* pool = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_KERNELS_H
+#define CAMDISTORT_KERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include "camdistort.h"
+
+namespace camdistort {
+namespace kernels {
+
+// Smallest singular value of the 2x2 matrix [a b; c d], used by the map analyses
+inline float minSingularValue(float a, float b, float c, float d)
+{
+    float sum = a * a + b * b + c * c + d * d;
+    float det = a * d - b * c;
+    float disc = std::sqrt(std::max(0.0f, sum * sum - 4.0f * det * det));
+    return std::sqrt(std::max(0.0f, 0.5f * (sum - disc)));
+}
+
+// Per instruction set entry points, each defined in kernels_<isa>.cpp and compiled
+// with the matching flags. All of them process the rows [y0, y1). The warp kernels
+// accumulate the convergence of their rows into report.
+
+void warpRowsScalar(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report);
+void remapRGBA8RowsScalar(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                          const float aberr[3], uint8_t* dst);
+void remapDepthRowsScalar(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                          RemapFilter filter, float* dst);
+
+#if defined(CAMDISTORT_HAVE_X86)
+void warpRowsSse2(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report);
+void remapRGBA8RowsSse2(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        const float aberr[3], uint8_t* dst);
+void remapDepthRowsSse2(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        RemapFilter filter, float* dst);
+
+void warpRowsAvx2(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report);
+void remapRGBA8RowsAvx2(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        const float aberr[3], uint8_t* dst);
+void remapDepthRowsAvx2(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        RemapFilter filter, float* dst);
+#endif
+
+}
+}
+
+#endif
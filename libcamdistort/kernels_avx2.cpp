@@ -0,0 +1,129 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+// Built with -mavx2 -mfma
+#include "kernels_impl.h"
+
+namespace camdistort {
+namespace kernels {
+
+void warpRowsAvx2(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report)
+{
+    warpRows<VAvx>(g, options, y0, y1, rgba, report);
+}
+
+void remapRGBA8RowsAvx2(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        const float aberr[3], uint8_t* dst)
+{
+    if (aberr[0] == aberr[1] && aberr[2] == aberr[1]){
+        remapRGBA8RowsVector(src, srcWidth, srcHeight, map, width, y0, y1, dst);
+    }
+    else{
+        remapRGBA8RowsGeneric(src, srcWidth, srcHeight, map, width, y0, y1, aberr, dst);
+    }
+}
+
+// Eight pixels at a time with hardware gathers of the four neighbours
+void remapDepthRowsAvx2(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        RemapFilter filter, float* dst)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 sw = _mm256_set1_ps(static_cast<float>(srcWidth));
+    const __m256 sh = _mm256_set1_ps(static_cast<float>(srcHeight));
+    const __m256i maxX = _mm256_set1_epi32(srcWidth - 1);
+    const __m256i maxY = _mm256_set1_epi32(srcHeight - 1);
+    const __m256i zeroi = _mm256_setzero_si256();
+    const __m256i stride = _mm256_set1_epi32(srcWidth);
+    // u and v of 8 consecutive RGBA texels
+    const __m256i uIndex = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    const int vectorCount = (width / 8) * 8;
+    for (int y = y0 ; y < y1 ; y++){
+        const float* row = map + 4 * (size_t)y * width;
+        float* out = dst + (size_t)y * width;
+        for (int x = 0 ; x < vectorCount ; x += 8){
+            __m256 u = _mm256_i32gather_ps(row + 4 * x, uIndex, 4);
+            __m256 v = _mm256_i32gather_ps(row + 4 * x + 1, uIndex, 4);
+            __m256 invalid = _mm256_cmp_ps(u, zero, _CMP_LT_OQ);
+            __m256 result;
+            if (filter == RemapFilter::NEAREST){
+                __m256i xi = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(u, sw))), zeroi), maxX);
+                __m256i yi = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(v, sh))), zeroi), maxY);
+                result = _mm256_i32gather_ps(src, _mm256_add_epi32(_mm256_mullo_epi32(yi, stride), xi), 4);
+            }
+            else{
+                __m256 px = _mm256_sub_ps(_mm256_mul_ps(u, sw), half);
+                __m256 py = _mm256_sub_ps(_mm256_mul_ps(v, sh), half);
+                __m256 fx0 = _mm256_floor_ps(px);
+                __m256 fy0 = _mm256_floor_ps(py);
+                __m256 wx = _mm256_sub_ps(px, fx0);
+                __m256 wy = _mm256_sub_ps(py, fy0);
+                __m256i ix = _mm256_cvttps_epi32(fx0);
+                __m256i iy = _mm256_cvttps_epi32(fy0);
+                __m256i x0 = _mm256_min_epi32(_mm256_max_epi32(ix, zeroi), maxX);
+                __m256i x1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(ix, _mm256_set1_epi32(1)), zeroi), maxX);
+                __m256i r0 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(iy, zeroi), maxY), stride);
+                __m256i r1 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(iy, _mm256_set1_epi32(1)), zeroi), maxY), stride);
+                __m256 d00 = _mm256_i32gather_ps(src, _mm256_add_epi32(r0, x0), 4);
+                __m256 d10 = _mm256_i32gather_ps(src, _mm256_add_epi32(r0, x1), 4);
+                __m256 d01 = _mm256_i32gather_ps(src, _mm256_add_epi32(r1, x0), 4);
+                __m256 d11 = _mm256_i32gather_ps(src, _mm256_add_epi32(r1, x1), 4);
+                __m256 top = _mm256_fmadd_ps(_mm256_sub_ps(d10, d00), wx, d00);
+                __m256 bottom = _mm256_fmadd_ps(_mm256_sub_ps(d11, d01), wx, d01);
+                result = _mm256_fmadd_ps(_mm256_sub_ps(bottom, top), wy, top);
+            }
+            _mm256_storeu_ps(out + x, _mm256_blendv_ps(result, zero, invalid));
+        }
+        // row tail
+        for (int x = vectorCount ; x < width ; x++){
+            const float* texel = row + 4 * x;
+            out[x] = texel[0] < 0.0f ? 0.0f : sampleDepth(src, srcWidth, srcHeight, texel[0], texel[1], filter);
+        }
+    }
+}
+
+}
+}
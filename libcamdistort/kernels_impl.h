@@ -0,0 +1,493 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_KERNELS_IMPL_H
+#define CAMDISTORT_KERNELS_IMPL_H
+
+// Kernel templates shared by the kernels_<isa>.cpp translation units. Only include
+// this from those files: the available vector types depend on their compile flags.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "kernels.h"
+#include "simd.h"
+
+namespace camdistort {
+namespace kernels {
+// Internal linkage, see simd.h
+namespace {
+
+using namespace simd;
+
+//------------------------------------------------------------------------------
+// Lens models on normalized camera coordinates, see camera_distortion.fs
+//------------------------------------------------------------------------------
+template <class V>
+inline V guardPositive(V a)
+{
+    return select(gt(a, V(1e-6f)), a, V(1e-6f));
+}
+
+// OpenCV pinhole with the rational, thin prism and tilt terms
+template <class V>
+inline void pinholeExtended(const WarpGeometry &g, V x, V y, V &ox, V &oy)
+{
+    const V one(1.0f), two(2.0f);
+    const V p0(g.p[0]), p1(g.p[1]);
+    V r2 = x * x + y * y;
+    V r4 = r2 * r2;
+    V radial = (one + r2 * (V(g.k[0]) + r2 * (V(g.k[1]) + r2 * V(g.k[2])))) /
+               (one + r2 * (V(g.rational[0]) + r2 * (V(g.rational[1]) + r2 * V(g.rational[2]))));
+    V dx = x * radial + two * p0 * x * y + p1 * (r2 + two * x * x) + V(g.prism[0]) * r2 + V(g.prism[1]) * r4;
+    V dy = y * radial + p0 * (r2 + two * y * y) + two * p1 * x * y + V(g.prism[2]) * r2 + V(g.prism[3]) * r4;
+    V tx = V(g.tilt[0]) * dx + V(g.tilt[1]) * dy + V(g.tilt[2]);
+    V ty = V(g.tilt[3]) * dx + V(g.tilt[4]) * dy + V(g.tilt[5]);
+    V tz = V(g.tilt[6]) * dx + V(g.tilt[7]) * dy + V(g.tilt[8]);
+    ox = tx / tz;
+    oy = ty / tz;
+}
+
+template <class V>
+inline void evalModel(const WarpGeometry &g, WarpDirection dir, WarpSolver solver, int iterations, V rx, V ry, V &ox, V &oy)
+{
+    const V k0(g.k[0]), k1(g.k[1]), k2(g.k[2]), k3(g.k[3]);
+    const V p0(g.p[0]), p1(g.p[1]);
+    const V zero(0.0f), one(1.0f), two(2.0f);
+
+    if (dir == WarpDirection::FORWARD){
+        switch (g.type) {
+        case DistortionType::PINHOLE:{
+            if (g.extended){
+                pinholeExtended(g, rx, ry, ox, oy);
+                return;
+            }
+            V r2 = rx * rx + ry * ry;
+            V radial = one + r2 * (k0 + r2 * (k1 + r2 * k2));
+            ox = rx * radial + two * p0 * rx * ry + p1 * (r2 + two * rx * rx);
+            oy = ry * radial + p0 * (r2 + two * ry * ry) + two * p1 * rx * ry;
+            return;
+        }
+        case DistortionType::FISHEYE:{
+            V rm = vsqrt(rx * rx + ry * ry);
+            V th = vatan_pos(rm);
+            V t2 = th * th;
+            V thd = th * (one + t2 * (k0 + t2 * (k1 + t2 * (k2 + t2 * k3))));
+            V s = select(gt(rm, V(0.0f)), vtan(thd) / vmax(rm, V(1e-30f)), one);
+            ox = rx * s;
+            oy = ry * s;
+            return;
+        }
+        case DistortionType::DOUBLE_SPHERE:{
+            V r2 = rx * rx + ry * ry;
+            V w = k0 * vsqrt(r2 + one) + one;
+            V denom = k1 * vsqrt(r2 + w * w) + (one - k1) * w;
+            ox = rx / denom;
+            oy = ry / denom;
+            return;
+        }
+        default:{
+            V rm = vsqrt(rx * rx + ry * ry);
+            V s = k3 + rm * (k2 + rm * (k1 + rm * k0));
+            ox = rx * s;
+            oy = ry * s;
+            return;
+        }
+        }
+    }
+
+    // INVERSE: solve forward(o) = r, starting from o = r
+    const bool newton = solver == WarpSolver::NEWTON;
+    switch (g.type) {
+    case DistortionType::PINHOLE:{
+        V x = rx, y = ry;
+        if (g.extended){
+            // No cheap fixed point for the full model: Newton with a central
+            // difference Jacobian in either case
+            const V h(1e-3f), invTwoH(0.5e3f);
+            for (int i = 0 ; i < iterations ; i++){
+                V fx, fy, ax, ay, bx, by;
+                pinholeExtended(g, x, y, fx, fy);
+                pinholeExtended(g, x + h, y, ax, ay);
+                pinholeExtended(g, x - h, y, bx, by);
+                V jxx = (ax - bx) * invTwoH, jyx = (ay - by) * invTwoH;
+                pinholeExtended(g, x, y + h, ax, ay);
+                pinholeExtended(g, x, y - h, bx, by);
+                V jxy = (ax - bx) * invTwoH, jyy = (ay - by) * invTwoH;
+                fx = fx - rx;
+                fy = fy - ry;
+                V det = jxx * jyy - jxy * jyx;
+                typename V::Mask regular = gt(vabs(det), V(1e-12f));
+                V invDet = select(regular, one / select(regular, det, one), zero);
+                x = x - (jyy * fx - jxy * fy) * invDet;
+                y = y - (jxx * fy - jyx * fx) * invDet;
+            }
+            ox = x;
+            oy = y;
+            return;
+        }
+        for (int i = 0 ; i < iterations ; i++){
+            V r2 = x * x + y * y;
+            V radial = one + r2 * (k0 + r2 * (k1 + r2 * k2));
+            V tx = two * p0 * x * y + p1 * (r2 + two * x * x);
+            V ty = p0 * (r2 + two * y * y) + two * p1 * x * y;
+            if (!newton){
+                radial = guardPositive(radial);
+                x = (rx - tx) / radial;
+                y = (ry - ty) / radial;
+                continue;
+            }
+            // 2x2 Newton step with the Jacobian of the Brown-Conrady model
+            V dRadial = two * (k0 + r2 * (two * k1 + V(3.0f) * r2 * k2));
+            V cross = x * y * dRadial + two * (p0 * x + p1 * y);
+            V jxx = radial + x * x * dRadial + two * p0 * y + V(6.0f) * p1 * x;
+            V jyy = radial + y * y * dRadial + V(6.0f) * p0 * y + two * p1 * x;
+            V fx = x * radial + tx - rx;
+            V fy = y * radial + ty - ry;
+            V det = jxx * jyy - cross * cross;
+            // singular Jacobian: leave the lane where it is, the residual reports it
+            typename V::Mask regular = gt(vabs(det), V(1e-12f));
+            V invDet = select(regular, one / select(regular, det, one), zero);
+            x = x - (jyy * fx - cross * fy) * invDet;
+            y = y - (jxx * fy - cross * fx) * invDet;
+        }
+        ox = x;
+        oy = y;
+        return;
+    }
+    case DistortionType::FISHEYE:{
+        // Solve theta_d(theta) = atan(|r|) on the incidence angle
+        V rdm = vsqrt(rx * rx + ry * ry);
+        V thd = vatan_pos(rdm);
+        V th = thd;
+        for (int i = 0 ; i < iterations ; i++){
+            V t2 = th * th;
+            V poly = one + t2 * (k0 + t2 * (k1 + t2 * (k2 + t2 * k3)));
+            if (newton){
+                V slope = one + t2 * (V(3.0f) * k0 + t2 * (V(5.0f) * k1 + t2 * (V(7.0f) * k2 + t2 * V(9.0f) * k3)));
+                th = th - (th * poly - thd) / guardPositive(slope);
+            }
+            else{
+                th = thd / guardPositive(poly);
+            }
+        }
+        V s = select(gt(rdm, V(0.0f)), vtan(th) / vmax(rdm, V(1e-30f)), one);
+        ox = rx * s;
+        oy = ry * s;
+        return;
+    }
+    case DistortionType::DOUBLE_SPHERE:{
+        // Closed form unprojection, rays at or behind 90 degrees have no pinhole
+        // coordinates and come out as NaN
+        V r2 = rx * rx + ry * ry;
+        V mz = (one - k1 * k1 * r2) / (k1 * vsqrt(one - (two * k1 - one) * r2) + one - k1);
+        V factor = (mz * k0 + vsqrt(mz * mz + (one - k0 * k0) * r2)) / (mz * mz + r2);
+        V z = factor * mz - k0;
+        V invZ = select(gt(z, zero), one / z, V(std::numeric_limits<float>::quiet_NaN()));
+        ox = factor * rx * invZ;
+        oy = factor * ry * invZ;
+        return;
+    }
+    default:{
+        // Solve rho * s(rho) = |r| on the undistorted radius
+        V rdm = vsqrt(rx * rx + ry * ry);
+        V rho = rdm;
+        for (int i = 0 ; i < iterations ; i++){
+            if (newton){
+                V h = rho * (k3 + rho * (k2 + rho * (k1 + rho * k0))) - rdm;
+                V slope = k3 + rho * (two * k2 + rho * (V(3.0f) * k1 + rho * V(4.0f) * k0));
+                rho = rho - h / guardPositive(slope);
+            }
+            else{
+                rho = rdm / guardPositive(k3 + rho * (k2 + rho * (k1 + rho * k0)));
+            }
+        }
+        V s = select(gt(rdm, V(0.0f)), rho / vmax(rdm, V(1e-30f)), one);
+        ox = rx * s;
+        oy = ry * s;
+        return;
+    }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Warp map span of count pixels (a multiple of V::N) starting at x0 of row y
+//------------------------------------------------------------------------------
+template <class V>
+inline void warpSpan(const WarpGeometry &g, const WarpMapOptions &options, int y, int x0, int count, float* rgba, WarpMapReport &report)
+{
+    typedef typename V::Mask M;
+    const int N = V::N;
+    const bool inverse = options.direction == WarpDirection::INVERSE;
+    float tu[N], tv[N], tdu[N], tdv[N];
+    // Only written and read for the inverse, value-initialized for -Wmaybe-uninitialized
+    float tres[N] = {}, tsolved[N] = {};
+
+    const V zero(0.0f), one(1.0f), invalid(-1.0f);
+    // rows are bottom-up like the GL texture, calibration coordinates top-down
+    const V oyLoc(1.0f - (y + 0.5f) / g.window[1]);
+    const V ry = ((oyLoc * V(g.window[1]) - V(g.subWindowOffset[1])) * V(g.image[1]) / V(g.subWindowSize[1]) - V(g.center[1])) / V(g.focal[1]);
+
+    for (int x = x0 ; x < x0 + count ; x += N){
+        V oxLoc = (V::ramp(static_cast<float>(x)) + V(0.5f)) / V(g.window[0]);
+        V rx = ((oxLoc * V(g.window[0]) - V(g.subWindowOffset[0])) * V(g.image[0]) / V(g.subWindowSize[0]) - V(g.center[0])) / V(g.focal[0]);
+
+        V mx, my;
+        evalModel(g, options.direction, options.solver, options.iterations, rx, ry, mx, my);
+        V du = mx * V(g.toNormed[0]);
+        V dv = my * V(g.toNormed[1]);
+
+        // always true
+        M ok = mnot(lt(zero, zero));
+        if (g.blackout){
+            ok = mnot(gt(vsqrt(rx * rx + ry * ry), V(g.blackoutRadius)));
+        }
+        if (inverse){
+            // Residual of the solution through the forward model, in image pixels.
+            // NaNs fail the comparison and count as not converged.
+            V fx, fy;
+            evalModel(g, WarpDirection::FORWARD, options.solver, 0, mx, my, fx, fy);
+            V ex = (fx - rx) * V(g.focal[0]);
+            V ey = (fy - ry) * V(g.focal[1]);
+            V residual = vsqrt(ex * ex + ey * ey);
+            select(ok, residual, zero).store(tres);
+            select(ok, one, zero).store(tsolved);
+            ok = mand(ok, lt(residual, V(options.tolerance)));
+        }
+        for (int c = 0 ; c < 3 ; c++){
+            V tcu = V(g.lensCenter[0]) + V(g.aberr[c]) * du;
+            V tcv = V(g.lensCenter[1]) + V(g.aberr[c]) * dv;
+            ok = mand(ok, mnot(mor(mor(lt(tcu, zero), gt(tcu, one)), mor(lt(tcv, zero), gt(tcv, one)))));
+        }
+
+        // back to bottom-up texture coordinates, d_v flips with them
+        select(ok, V(g.lensCenter[0]) + V(g.aberr[1]) * du, invalid).store(tu);
+        select(ok, one - (V(g.lensCenter[1]) + V(g.aberr[1]) * dv), invalid).store(tv);
+        select(ok, du, zero).store(tdu);
+        select(ok, zero - dv, zero).store(tdv);
+
+        float* out = rgba + 4 * (x - x0);
+        for (int i = 0 ; i < N ; i++){
+            out[4 * i + 0] = tu[i];
+            out[4 * i + 1] = tv[i];
+            out[4 * i + 2] = tdu[i];
+            out[4 * i + 3] = tdv[i];
+        }
+        if (inverse){
+            for (int i = 0 ; i < N ; i++){
+                if (tsolved[i] == 0.0f){
+                    continue;
+                }
+                report.solvedPixels++;
+                if (!(tres[i] < options.tolerance)){
+                    report.nonConverged++;
+                }
+                if (tres[i] > report.maxResidual){
+                    report.maxResidual = tres[i];
+                }
+            }
+        }
+    }
+}
+
+template <class V>
+inline void warpRows(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report)
+{
+    const int width = static_cast<int>(g.window[0]);
+    const int vectorCount = (width / V::N) * V::N;
+    for (int y = y0 ; y < y1 ; y++){
+        float* row = rgba + 4 * (size_t)y * (size_t)width;
+        warpSpan<V>(g, options, y, 0, vectorCount, row, report);
+        // row tail
+        warpSpan<VScalar>(g, options, y, vectorCount, width - vectorCount, row + 4 * vectorCount, report);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Remap helpers
+//------------------------------------------------------------------------------
+inline int clampIndex(int i, int size)
+{
+    return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+// Texel indices and weight for a normalized coordinate, clamp to edge like the GL sampler
+inline void bilinearSetup(float coord, int size, int &i0, int &i1, float &f)
+{
+    float p = coord * size - 0.5f;
+    float fl = std::floor(p);
+    f = p - fl;
+    int i = static_cast<int>(fl);
+    i0 = clampIndex(i, size);
+    i1 = clampIndex(i + 1, size);
+}
+
+inline float sampleChannel(const uint8_t* src, int srcWidth, int srcHeight, float u, float v, int channel)
+{
+    int x0, x1, y0, y1;
+    float fx, fy;
+    bilinearSetup(u, srcWidth, x0, x1, fx);
+    bilinearSetup(v, srcHeight, y0, y1, fy);
+    float c00 = src[4 * ((size_t)y0 * srcWidth + x0) + channel];
+    float c10 = src[4 * ((size_t)y0 * srcWidth + x1) + channel];
+    float c01 = src[4 * ((size_t)y1 * srcWidth + x0) + channel];
+    float c11 = src[4 * ((size_t)y1 * srcWidth + x1) + channel];
+    return (c00 * (1.0f - fx) + c10 * fx) * (1.0f - fy) + (c01 * (1.0f - fx) + c11 * fx) * fy;
+}
+
+inline uint8_t toByte(float v)
+{
+    v = v + 0.5f;
+    return static_cast<uint8_t>(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+}
+
+inline void remapRGBA8Pixel(const uint8_t* src, int srcWidth, int srcHeight, const float* texel, const float aberr[3], uint8_t* out)
+{
+    if (texel[0] < 0.0f){
+        out[0] = 0; out[1] = 0; out[2] = 0; out[3] = 255;
+        return;
+    }
+    for (int c = 0 ; c < 3 ; c++){
+        float s = aberr[c] - aberr[1];
+        out[c] = toByte(sampleChannel(src, srcWidth, srcHeight, texel[0] + s * texel[2], texel[1] + s * texel[3], c));
+    }
+    out[3] = 255;
+}
+
+inline float sampleDepth(const float* src, int srcWidth, int srcHeight, float u, float v, RemapFilter filter)
+{
+    if (filter == RemapFilter::NEAREST){
+        int x = clampIndex(static_cast<int>(std::floor(u * srcWidth)), srcWidth);
+        int y = clampIndex(static_cast<int>(std::floor(v * srcHeight)), srcHeight);
+        return src[(size_t)y * srcWidth + x];
+    }
+    int x0, x1, y0, y1;
+    float fx, fy;
+    bilinearSetup(u, srcWidth, x0, x1, fx);
+    bilinearSetup(v, srcHeight, y0, y1, fy);
+    float d00 = src[(size_t)y0 * srcWidth + x0];
+    float d10 = src[(size_t)y0 * srcWidth + x1];
+    float d01 = src[(size_t)y1 * srcWidth + x0];
+    float d11 = src[(size_t)y1 * srcWidth + x1];
+    return (d00 * (1.0f - fx) + d10 * fx) * (1.0f - fy) + (d01 * (1.0f - fx) + d11 * fx) * fy;
+}
+
+inline void remapRGBA8RowsGeneric(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                                  const float aberr[3], uint8_t* dst)
+{
+    for (int y = y0 ; y < y1 ; y++){
+        for (int x = 0 ; x < width ; x++){
+            size_t i = (size_t)y * width + x;
+            remapRGBA8Pixel(src, srcWidth, srcHeight, map + 4 * i, aberr, dst + 4 * i);
+        }
+    }
+}
+
+inline void remapDepthRowsGeneric(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                                  RemapFilter filter, float* dst)
+{
+    for (int y = y0 ; y < y1 ; y++){
+        for (int x = 0 ; x < width ; x++){
+            size_t i = (size_t)y * width + x;
+            const float* texel = map + 4 * i;
+            dst[i] = texel[0] < 0.0f ? 0.0f : sampleDepth(src, srcWidth, srcHeight, texel[0], texel[1], filter);
+        }
+    }
+}
+
+#if defined(__SSE2__)
+//------------------------------------------------------------------------------
+// RGBA8 bilinear with the four channels of one pixel in one register. Only valid
+// when all channels use the same coordinate (no chromatic aberration).
+//------------------------------------------------------------------------------
+inline __m128 loadTexel(const uint8_t* src, size_t index)
+{
+    int32_t packed;
+    std::memcpy(&packed, src + 4 * index, 4);
+    __m128i zero = _mm_setzero_si128();
+    __m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    return _mm_cvtepi32_ps(px);
+}
+
+inline void remapRGBA8RowsVector(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1, uint8_t* dst)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    for (int y = y0 ; y < y1 ; y++){
+        for (int x = 0 ; x < width ; x++){
+            size_t i = (size_t)y * width + x;
+            const float* texel = map + 4 * i;
+            int32_t result;
+            if (texel[0] < 0.0f){
+                result = static_cast<int32_t>(0xFF000000u);
+            }
+            else{
+                int xa, xb, ya, yb;
+                float fx, fy;
+                bilinearSetup(texel[0], srcWidth, xa, xb, fx);
+                bilinearSetup(texel[1], srcHeight, ya, yb, fy);
+                __m128 c00 = loadTexel(src, (size_t)ya * srcWidth + xa);
+                __m128 c10 = loadTexel(src, (size_t)ya * srcWidth + xb);
+                __m128 c01 = loadTexel(src, (size_t)yb * srcWidth + xa);
+                __m128 c11 = loadTexel(src, (size_t)yb * srcWidth + xb);
+                __m128 wx = _mm_set1_ps(fx), wy = _mm_set1_ps(fy);
+                __m128 top = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), wx));
+                __m128 bottom = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), wx));
+                __m128 c = _mm_add_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy)), half);
+                __m128i ci = _mm_cvttps_epi32(c);
+                ci = _mm_packus_epi16(_mm_packs_epi32(ci, ci), ci);
+                result = _mm_cvtsi128_si32(_mm_or_si128(ci, alpha));
+            }
+            std::memcpy(dst + 4 * i, &result, 4);
+        }
+    }
+}
+#endif
+
+}
+}
+}
+
+#endif
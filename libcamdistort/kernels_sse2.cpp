@@ -0,0 +1,76 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+// Built with -msse2 (the x86-64 baseline)
+#include "kernels_impl.h"
+
+namespace camdistort {
+namespace kernels {
+
+void warpRowsSse2(const WarpGeometry &g, const WarpMapOptions &options, int y0, int y1, float* rgba, WarpMapReport &report)
+{
+    warpRows<VSse>(g, options, y0, y1, rgba, report);
+}
+
+void remapRGBA8RowsSse2(const uint8_t* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        const float aberr[3], uint8_t* dst)
+{
+    if (aberr[0] == aberr[1] && aberr[2] == aberr[1]){
+        remapRGBA8RowsVector(src, srcWidth, srcHeight, map, width, y0, y1, dst);
+    }
+    else{
+        remapRGBA8RowsGeneric(src, srcWidth, srcHeight, map, width, y0, y1, aberr, dst);
+    }
+}
+
+void remapDepthRowsSse2(const float* src, int srcWidth, int srcHeight, const float* map, int width, int y0, int y1,
+                        RemapFilter filter, float* dst)
+{
+    // Four single channel gathers per pixel do not vectorize without a gather instruction
+    remapDepthRowsGeneric(src, srcWidth, srcHeight, map, width, y0, y1, filter, dst);
+}
+
+}
+}
@@ -0,0 +1,178 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "lens_schedule.h"
+#include <algorithm>
+#include <cmath>
+
+namespace camdistort {
+
+namespace {
+
+bool settingLess(const LensKeyframe &a, const LensKeyframe &b)
+{
+    return a.zoom < b.zoom || (a.zoom == b.zoom && a.focus < b.focus);
+}
+
+// Position of value between lo and hi in [0, 1], rounded to 1 / steps
+float bracketWeight(float lo, float hi, float value, int steps)
+{
+    if (!(hi > lo)){
+        return 0.0f;
+    }
+    float t = std::min(1.0f, std::max(0.0f, (value - lo) / (hi - lo)));
+    if (steps > 0){
+        t = std::floor(t * steps + 0.5f) / steps;
+    }
+    return t;
+}
+
+float lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+}
+
+CameraParams interpolateCameraParams(const CameraParams &a, const CameraParams &b, float t)
+{
+    // Exact at the keyframes, so that their maps are shared with a static calibration
+    if (t <= 0.0f){
+        return a;
+    }
+    if (t >= 1.0f){
+        CameraParams params = b;
+        params.distortion_type = a.distortion_type;
+        params.blackout = a.blackout;
+        params.inverse = a.inverse;
+        params.inverse_iterations = a.inverse_iterations;
+        params.inverse_tolerance = a.inverse_tolerance;
+        return params;
+    }
+    CameraParams params = a;
+    params.width = lerp(a.width, b.width, t);
+    params.height = lerp(a.height, b.height, t);
+    params.fx = lerp(a.fx, b.fx, t);
+    params.fy = lerp(a.fy, b.fy, t);
+    params.cx = lerp(a.cx, b.cx, t);
+    params.cy = lerp(a.cy, b.cy, t);
+    for (int i = 0 ; i < 4 ; i++){
+        params.radial_distortion_coeffs[i] = lerp(a.radial_distortion_coeffs[i], b.radial_distortion_coeffs[i], t);
+    }
+    for (int i = 0 ; i < 2 ; i++){
+        params.tangential_distortion_coeffs[i] = lerp(a.tangential_distortion_coeffs[i], b.tangential_distortion_coeffs[i], t);
+        params.lens_center[i] = lerp(a.lens_center[i], b.lens_center[i], t);
+        params.tilt[i] = lerp(a.tilt[i], b.tilt[i], t);
+    }
+    for (int i = 0 ; i < 3 ; i++){
+        params.aberr_scale[i] = lerp(a.aberr_scale[i], b.aberr_scale[i], t);
+        params.rational_distortion_coeffs[i] = lerp(a.rational_distortion_coeffs[i], b.rational_distortion_coeffs[i], t);
+    }
+    for (int i = 0 ; i < 4 ; i++){
+        params.thin_prism_coeffs[i] = lerp(a.thin_prism_coeffs[i], b.thin_prism_coeffs[i], t);
+    }
+    return params;
+}
+
+void LensSchedule::addKeyframe(const LensKeyframe &keyframe)
+{
+    std::vector<LensKeyframe>::iterator it = std::lower_bound(m_keyframes.begin(), m_keyframes.end(), keyframe, settingLess);
+    if (it != m_keyframes.end() && it->zoom == keyframe.zoom && it->focus == keyframe.focus){
+        *it = keyframe;
+    }
+    else{
+        m_keyframes.insert(it, keyframe);
+    }
+}
+
+CameraParams LensSchedule::evaluateFocus(size_t begin, size_t end, float focus, int steps) const
+{
+    size_t upper = begin;
+    while (upper < end && m_keyframes[upper].focus < focus){
+        upper++;
+    }
+    if (upper == begin){
+        return m_keyframes[begin].params;
+    }
+    if (upper == end){
+        return m_keyframes[end - 1].params;
+    }
+    const LensKeyframe &lo = m_keyframes[upper - 1];
+    const LensKeyframe &hi = m_keyframes[upper];
+    return interpolateCameraParams(lo.params, hi.params, bracketWeight(lo.focus, hi.focus, focus, steps));
+}
+
+CameraParams LensSchedule::evaluate(float zoom, float focus, int steps) const
+{
+    if (m_keyframes.empty()){
+        return CameraParams();
+    }
+
+    // Runs of keyframes with the same zoom value, the two around zoom are blended
+    size_t loBegin = 0;
+    size_t loEnd = 0;
+    while (loEnd < m_keyframes.size() && m_keyframes[loEnd].zoom == m_keyframes[loBegin].zoom){
+        loEnd++;
+    }
+    while (loEnd < m_keyframes.size() && m_keyframes[loEnd].zoom <= zoom){
+        loBegin = loEnd;
+        while (loEnd < m_keyframes.size() && m_keyframes[loEnd].zoom == m_keyframes[loBegin].zoom){
+            loEnd++;
+        }
+    }
+    CameraParams lo = evaluateFocus(loBegin, loEnd, focus, steps);
+    if (loEnd == m_keyframes.size() || zoom <= m_keyframes[loBegin].zoom){
+        return lo;
+    }
+
+    size_t hiEnd = loEnd;
+    while (hiEnd < m_keyframes.size() && m_keyframes[hiEnd].zoom == m_keyframes[loEnd].zoom){
+        hiEnd++;
+    }
+    CameraParams hi = evaluateFocus(loEnd, hiEnd, focus, steps);
+    return interpolateCameraParams(lo, hi, bracketWeight(m_keyframes[loBegin].zoom, m_keyframes[loEnd].zoom, zoom, steps));
+}
+
+}
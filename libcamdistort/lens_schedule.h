@@ -0,0 +1,96 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_LENS_SCHEDULE_H
+#define CAMDISTORT_LENS_SCHEDULE_H
+
+// Calibrations of a zoom / focus lens, e.g. a surgical scope, sampled at a set of
+// lens settings. Parameters in between are interpolated linearly, first along
+// focus within the two calibrated zoom values around the setting, then along zoom.
+// The keyframes of one zoom value need not share focus values.
+
+#include <cstddef>
+#include <vector>
+#include "camera_params.h"
+
+namespace camdistort {
+
+struct LensKeyframe {
+    float zoom;
+    float focus;
+    CameraParams params;
+};
+
+// Blend of the continuous fields of a and b, the discrete ones (type, blackout,
+// inverse solve) are taken from a
+CameraParams interpolateCameraParams(const CameraParams &a, const CameraParams &b, float t);
+
+class LensSchedule {
+public:
+    void clear() { m_keyframes.clear(); }
+    // Keeps the keyframes sorted by (zoom, focus), a keyframe at an existing
+    // setting replaces it
+    void addKeyframe(const LensKeyframe &keyframe);
+
+    bool empty() const { return m_keyframes.empty(); }
+    size_t size() const { return m_keyframes.size(); }
+    const LensKeyframe& getKeyframe(size_t i) const { return m_keyframes[i]; }
+
+    // Parameters at (zoom, focus), clamped to the calibrated range. With steps > 0
+    // the position between two adjacent keyframes is rounded to a multiple of
+    // 1 / steps, so a continuously moving setting only ever produces a bounded set
+    // of parameters and the maps derived from them can be cached.
+    CameraParams evaluate(float zoom, float focus, int steps = 0) const;
+
+private:
+    // Parameters along focus of the keyframes [begin, end), which share one zoom value
+    CameraParams evaluateFocus(size_t begin, size_t end, float focus, int steps) const;
+
+    std::vector<LensKeyframe> m_keyframes;
+};
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "remap_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace camdistort {
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int exponent = static_cast<int>((bits >> 23) & 0xffu);
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xff){
+        // Inf stays inf, NaN stays a quiet NaN
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    int halfExponent = exponent - 127 + 15;
+    if (halfExponent >= 0x1f){
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (halfExponent <= 0){
+        // Subnormal half, or zero below half of the smallest one
+        if (halfExponent < -10){
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))){
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    // Round to nearest even, a carry into the exponent is the correct result
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))){
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits;
+    if (exponent == 0x1f){
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if (exponent != 0){
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0){
+        bits = sign;
+    }
+    else{
+        // Subnormal half, normalized as a float
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400u)){
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+RemapFile::RemapFile()
+{
+    m_header = nullptr;
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+}
+
+RemapFile::~RemapFile()
+{
+    close();
+}
+
+static size_t bytesPerPixel(RemapFormat format)
+{
+    return format == RemapFormat::FLOAT16_OFFSET ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+}
+
+bool RemapFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        std::cerr << "ERROR! Can not open remap file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(RemapFileHeader))){
+        std::cerr << "ERROR! " << path << " is too small for a remap file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+        std::cerr << "ERROR! mmap of remap file " << path << " failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const RemapFileHeader* header = static_cast<const RemapFileHeader*>(mapping);
+    const char* error = nullptr;
+    if (std::memcmp(header->magic, REMAP_FILE_MAGIC, sizeof(REMAP_FILE_MAGIC)) != 0){
+        error = "not a remap file";
+    }
+    else if (header->version != REMAP_FILE_VERSION){
+        error = "unsupported version";
+    }
+    else if (header->format != static_cast<uint32_t>(RemapFormat::FLOAT32) &&
+             header->format != static_cast<uint32_t>(RemapFormat::FLOAT16_OFFSET)){
+        error = "unknown format";
+    }
+    else if (header->width == 0 || header->height == 0 || header->sourceWidth == 0 || header->sourceHeight == 0){
+        error = "empty map";
+    }
+    else if (header->headerSize < sizeof(RemapFileHeader) || header->headerSize % 4 != 0 ||
+             header->headerSize + (uint64_t)header->width * header->height * bytesPerPixel(static_cast<RemapFormat>(header->format)) > size){
+        error = "truncated";
+    }
+    if (error){
+        std::cerr << "ERROR! Remap file " << path << ": " << error << std::endl;
+        munmap(mapping, size);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = size;
+    m_header = header;
+    m_data = static_cast<const unsigned char*>(mapping) + header->headerSize;
+    return true;
+}
+
+void RemapFile::close()
+{
+    if (m_mapping){
+        munmap(m_mapping, m_mappingSize);
+    }
+    m_header = nullptr;
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+}
+
+size_t RemapFile::getDataSize() const
+{
+    return m_header ? (size_t)m_header->width * m_header->height * bytesPerPixel(getFormat()) : 0;
+}
+
+void RemapFile::getSourcePixel(int x, int y, float &sx, float &sy) const
+{
+    size_t i = 2 * ((size_t)y * m_header->width + x);
+    if (getFormat() == RemapFormat::FLOAT32){
+        const float* data = reinterpret_cast<const float*>(m_data);
+        sx = data[i];
+        sy = data[i + 1];
+        return;
+    }
+    const uint16_t* data = reinterpret_cast<const uint16_t*>(m_data);
+    sx = halfToFloat(data[i]) + (x + 0.5f) * m_header->sourceWidth / m_header->width - 0.5f;
+    sy = halfToFloat(data[i + 1]) + (y + 0.5f) * m_header->sourceHeight / m_header->height - 0.5f;
+}
+
+bool writeRemapFile(const std::string &path, int width, int height, const float* mapX, const float* mapY,
+                    int sourceWidth, int sourceHeight, RemapFormat format)
+{
+    if (width <= 0 || height <= 0 || sourceWidth <= 0 || sourceHeight <= 0){
+        std::cerr << "ERROR! Empty remap" << std::endl;
+        return false;
+    }
+    RemapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, REMAP_FILE_MAGIC, sizeof(REMAP_FILE_MAGIC));
+    header.version = REMAP_FILE_VERSION;
+    header.headerSize = sizeof(RemapFileHeader);
+    header.width = width;
+    header.height = height;
+    header.sourceWidth = sourceWidth;
+    header.sourceHeight = sourceHeight;
+    header.format = static_cast<uint32_t>(format);
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file){
+        std::cerr << "ERROR! Can not write remap file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    // One row at a time, interleaved
+    std::vector<float> row32(format == RemapFormat::FLOAT32 ? 2 * (size_t)width : 0);
+    std::vector<uint16_t> row16(format == RemapFormat::FLOAT16_OFFSET ? 2 * (size_t)width : 0);
+    for (int y = 0 ; y < height && ok ; y++){
+        for (int x = 0 ; x < width ; x++){
+            size_t i = (size_t)y * width + x;
+            if (format == RemapFormat::FLOAT32){
+                row32[2 * x] = mapX[i];
+                row32[2 * x + 1] = mapY[i];
+            }
+            else{
+                row16[2 * x] = floatToHalf(mapX[i] - ((x + 0.5f) * sourceWidth / width - 0.5f));
+                row16[2 * x + 1] = floatToHalf(mapY[i] - ((y + 0.5f) * sourceHeight / height - 0.5f));
+            }
+        }
+        ok = format == RemapFormat::FLOAT32 ? std::fwrite(row32.data(), sizeof(float), row32.size(), file) == row32.size() :
+                                              std::fwrite(row16.data(), sizeof(uint16_t), row16.size(), file) == row16.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok){
+        std::cerr << "ERROR! Writing remap file " << path << " failed" << std::endl;
+    }
+    return ok;
+}
+
+uint64_t getRemapFileStamp(const std::string &path)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0){
+        return 0;
+    }
+    return ((uint64_t)info.st_mtime << 32) ^ (uint64_t)info.st_size;
+}
+
+void buildRemapWarpMap(const RemapFile &file, const CameraParams &params, int width, int height, float* rgba, ThreadPool* pool)
+{
+    if (width <= 0 || height <= 0){
+        return;
+    }
+    const WarpGeometry g = computeWarpGeometry(params, width, height);
+    const int mapSize[2] = {file.getWidth(), file.getHeight()};
+    const float sourceSize[2] = {static_cast<float>(file.getSourceWidth()), static_cast<float>(file.getSourceHeight())};
+
+    ThreadPool& p = pool ? *pool : ThreadPool::getDefault();
+    p.parallelFor(height, [&](int yi){
+        for (int xi = 0 ; xi < width ; xi++){
+            float* texel = rgba + 4 * ((size_t)yi * width + xi);
+            texel[0] = -1.0f;
+            texel[1] = -1.0f;
+            texel[2] = 0.0f;
+            texel[3] = 0.0f;
+            if (!file.isOpen()){
+                continue;
+            }
+
+            // Calibrated image pixel of the output pixel, as for the models
+            const float loc[2] = {(xi + 0.5f) / g.window[0], 1.0f - (yi + 0.5f) / g.window[1]};
+            float image[2], m[2], r[2];
+            bool valid = true;
+            for (int i = 0 ; i < 2 ; i++){
+                image[i] = (loc[i] * g.window[i] - g.subWindowOffset[i]) * g.image[i] / g.subWindowSize[i];
+                r[i] = (image[i] - g.center[i]) / g.focal[i];
+                // Map pixel, centers at integers
+                m[i] = image[i] / g.image[i] * mapSize[i] - 0.5f;
+                valid = valid && m[i] >= -0.5f && m[i] <= mapSize[i] - 0.5f;
+            }
+            if (!valid || (g.blackout && std::sqrt(r[0] * r[0] + r[1] * r[1]) > g.blackoutRadius)){
+                continue;
+            }
+
+            // Bilinear, clamped to the edge texels like the GL_LINEAR texture
+            int x0 = std::min(std::max(static_cast<int>(std::floor(m[0])), 0), mapSize[0] - 1);
+            int y0 = std::min(std::max(static_cast<int>(std::floor(m[1])), 0), mapSize[1] - 1);
+            int x1 = std::min(x0 + 1, mapSize[0] - 1);
+            int y1 = std::min(y0 + 1, mapSize[1] - 1);
+            float fx = std::min(std::max(m[0] - x0, 0.0f), 1.0f);
+            float fy = std::min(std::max(m[1] - y0, 0.0f), 1.0f);
+            float s00[2], s10[2], s01[2], s11[2];
+            file.getSourcePixel(x0, y0, s00[0], s00[1]);
+            file.getSourcePixel(x1, y0, s10[0], s10[1]);
+            file.getSourcePixel(x0, y1, s01[0], s01[1]);
+            file.getSourcePixel(x1, y1, s11[0], s11[1]);
+
+            float tc[2], d[2];
+            for (int i = 0 ; i < 2 ; i++){
+                float s = (s00[i] * (1.0f - fx) + s10[i] * fx) * (1.0f - fy) + (s01[i] * (1.0f - fx) + s11[i] * fx) * fy;
+                // Top-down texture coordinate of the scene, as g.lensCenter
+                tc[i] = (s + 0.5f) / sourceSize[i] * g.subWindowSize[i] / g.window[i] + g.subWindowOffset[i] / g.window[i];
+                d[i] = (tc[i] - g.lensCenter[i]) / g.aberr[1];
+                valid = valid && std::isfinite(tc[i]);
+            }
+            for (int c = 0 ; c < 3 && valid ; c++){
+                for (int i = 0 ; i < 2 ; i++){
+                    float t = g.lensCenter[i] + g.aberr[c] * d[i];
+                    valid = valid && t >= 0.0f && t <= 1.0f;
+                }
+            }
+            if (!valid){
+                continue;
+            }
+            texel[0] = tc[0];
+            texel[1] = 1.0f - tc[1];
+            texel[2] = d[0];
+            texel[3] = -d[1];
+        }
+    });
+}
+
+}
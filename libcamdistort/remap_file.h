@@ -0,0 +1,143 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_REMAP_FILE_H
+#define CAMDISTORT_REMAP_FILE_H
+
+// Dense, non-parametric lens maps for type: remap. A remap file holds for every pixel
+// of a width x height output image the source pixel to sample, with the conventions
+// of cv::remap(): pixel centers at integer coordinates, rows top to bottom. The maps
+// of cv::initUndistortRectifyMap() are stored as is, (map_x, map_y) interleaved like a
+// CV_32FC2 map. The file is memory mapped, the data is never parsed.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "camdistort.h"
+
+namespace camdistort {
+
+enum class RemapFormat : uint32_t {
+    // Source pixel coordinates as 32 bit floats
+    FLOAT32 = 0,
+    // Offsets of the source pixel from the pixel at the same relative position,
+    // ((x + 0.5) * sourceWidth / width - 0.5, (y + 0.5) * sourceHeight / height - 0.5),
+    // as IEEE half floats. Half the size; the offsets are far smaller than the
+    // coordinates, so they keep 1/16 px or better below 128 px of displacement.
+    FLOAT16_OFFSET = 1,
+};
+
+const char REMAP_FILE_MAGIC[8] = {'C', 'D', 'R', 'E', 'M', 'A', 'P', '\0'};
+const uint32_t REMAP_FILE_VERSION = 1;
+
+// Little endian, followed at headerSize by width * height (x, y) pairs
+struct RemapFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t width;
+    uint32_t height;
+    // Size of the image the coordinates point into
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    uint32_t format;
+    uint32_t reserved;
+};
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// Read-only mapping of a remap file
+class RemapFile {
+public:
+    RemapFile();
+    ~RemapFile();
+    RemapFile(const RemapFile&) = delete;
+    RemapFile& operator=(const RemapFile&) = delete;
+
+    // Map the file and check its header, the reason of a failure is printed
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    int getWidth() const { return m_header ? static_cast<int>(m_header->width) : 0; }
+    int getHeight() const { return m_header ? static_cast<int>(m_header->height) : 0; }
+    int getSourceWidth() const { return m_header ? static_cast<int>(m_header->sourceWidth) : 0; }
+    int getSourceHeight() const { return m_header ? static_cast<int>(m_header->sourceHeight) : 0; }
+    RemapFormat getFormat() const { return m_header ? static_cast<RemapFormat>(m_header->format) : RemapFormat::FLOAT32; }
+
+    // The (x, y) pairs as stored, 2 floats or 2 halfs per pixel, e.g. to upload as is
+    const void* getData() const { return m_data; }
+    size_t getDataSize() const;
+
+    // Source pixel of map pixel (x, y), offsets added back
+    void getSourcePixel(int x, int y, float &sx, float &sy) const;
+
+private:
+    const RemapFileHeader* m_header;
+    const unsigned char* m_data;
+    void* m_mapping;
+    size_t m_mappingSize;
+};
+
+// Write map_x / map_y (width * height floats each, e.g. the two CV_32FC1 maps of
+// cv::initUndistortRectifyMap()) as a remap file. Returns false on error.
+bool writeRemapFile(const std::string &path, int width, int height, const float* mapX, const float* mapY,
+                    int sourceWidth, int sourceHeight, RemapFormat format = RemapFormat::FLOAT32);
+
+// Changes whenever the file is rewritten (size and modification time), 0 if it does not exist
+uint64_t getRemapFileStamp(const std::string &path);
+
+// Fill rgba (4 * width * height floats) like buildWarpMap() from the map of a
+// type: remap calibration. The output is mapped onto the map with the same centered
+// sub-window as the models and the map is sampled bilinearly; the chromatic
+// aberration scales are applied around the principal point. Called by
+// buildWarpMap() for DistortionType::REMAP.
+void buildRemapWarpMap(const RemapFile &file, const CameraParams &params, int width, int height, float* rgba,
+                       ThreadPool* pool = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "sensor_chain.h"
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace camdistort {
+
+namespace {
+
+// GLSL 1.10 float literal, integers need the decimal point
+std::string glslFloat(float value)
+{
+    std::ostringstream out;
+    out.precision(9);
+    out << value;
+    std::string literal = out.str();
+    if (literal.find_first_of(".e") == std::string::npos) {
+        literal += ".0";
+    }
+    return literal;
+}
+
+// Statement of one stage on the vec3 c at output pixel px, stream separates the noise of the stages
+std::string stageCall(const SensorStage &stage, int stream)
+{
+    switch (stage.type) {
+    case SensorStageType::VIGNETTE:
+        return "c = vignette(c, px, " + glslFloat(stage.values[0]) + ", " + glslFloat(stage.values[1]) + ");";
+    case SensorStageType::NOISE:
+        return "c = sensorNoise(c, px, " + glslFloat(stage.values[0]) + ", " + glslFloat(stage.values[1]) + ", " +
+               glslFloat(static_cast<float>(stream)) + ");";
+    case SensorStageType::TONE:
+        return "c = toneCurve(c, " + glslFloat(stage.values[0]) + ", " + glslFloat(stage.values[1]) + ");";
+    case SensorStageType::GAMMA:
+        return "c = pow(max(c, vec3(0.0)), vec3(" + glslFloat(1.0f / stage.values[0]) + "));";
+    default:
+        return "";
+    }
+}
+
+uint64_t splitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+int validateSensorChain(const SensorChain &chain)
+{
+    int bayerStages = 0;
+    for (size_t i = 0 ; i < chain.size() ; i++) {
+        const SensorStage &stage = chain[i];
+        if (!std::isfinite(stage.values[0]) || !std::isfinite(stage.values[1])) {
+            std::cerr << "Error: sensor stage " << i << " has a non-finite value." << std::endl;
+            return 0;
+        }
+        switch (stage.type) {
+        case SensorStageType::VIGNETTE:
+        case SensorStageType::NOISE:
+            if (stage.values[0] < 0.0f || stage.values[1] < 0.0f) {
+                std::cerr << "Error: sensor stage " << i << " needs non-negative values." << std::endl;
+                return 0;
+            }
+            break;
+        case SensorStageType::BAYER:
+            bayerStages++;
+            break;
+        case SensorStageType::TONE:
+        case SensorStageType::GAMMA:
+            if (stage.values[0] <= 0.0f || (stage.type == SensorStageType::TONE && stage.values[1] <= 0.0f)) {
+                std::cerr << "Error: sensor stage " << i << " needs positive values." << std::endl;
+                return 0;
+            }
+            break;
+        }
+    }
+    if (bayerStages > 1) {
+        std::cerr << "Error: at most one bayer sensor stage is supported." << std::endl;
+        return 0;
+    }
+    return 1;
+}
+
+std::string getSensorChainDefines(const SensorChain &chain)
+{
+    if (chain.empty()) {
+        return std::string();
+    }
+    std::string raw, post;
+    int bayer = -1;
+    for (size_t i = 0 ; i < chain.size() ; i++) {
+        if (chain[i].type == SensorStageType::BAYER) {
+            bayer = static_cast<int>(chain[i].values[0]);
+            continue;
+        }
+        std::string &stages = (bayer < 0) ? raw : post;
+        stages += " " + stageCall(chain[i], static_cast<int>(i));
+    }
+    // Without a mosaic everything is per pixel, the split only matters for the demosaic
+    std::string defines = "#define SENSOR_CHAIN 1\n";
+    defines += "#define SENSOR_BAYER " + std::to_string(bayer) + "\n";
+    defines += "#define SENSOR_RAW(c, px)" + raw + "\n";
+    defines += "#define SENSOR_POST(c, px)" + post + "\n";
+    return defines;
+}
+
+void getSensorFrameSeed(uint64_t frame, float seed[2])
+{
+    uint64_t key = splitMix64(frame);
+    // 24 bits each, exact in a float
+    seed[0] = static_cast<float>(key & 0xFFFFFF) / 16777216.0f;
+    seed[1] = static_cast<float>((key >> 24) & 0xFFFFFF) / 16777216.0f;
+}
+
+} // namespace camdistort
@@ -0,0 +1,103 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_SENSOR_CHAIN_H
+#define CAMDISTORT_SENSOR_CHAIN_H
+
+// Ordered list of sensor effects applied after the lens ('sensor_stages' in the
+// distortion config). The plugin compiles the chain into the distortion program as
+// preprocessor macros, so every stage runs in the same pass as the lens lookup.
+// Stages before a bayer stage act on the raw mosaic, the others on RGB.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace camdistort {
+
+enum class SensorStageType {
+    // Falloff toward the image corners: mix(1, cos(theta)^exponent, strength)
+    VIGNETTE,
+    // Signal dependent shot noise and constant read noise, variance shot * v + read^2
+    NOISE,
+    // Color filter array mosaic followed by a bilinear demosaic
+    BAYER,
+    // Extended Reinhard curve: v * exposure * (1 + v * exposure / white^2) / (1 + v * exposure)
+    TONE,
+    // v^(1 / gamma)
+    GAMMA,
+};
+
+// Order of the filters over a 2x2 block, top-left first, shared with the shader
+enum class BayerPattern {
+    RGGB,
+    GRBG,
+    GBRG,
+    BGGR,
+};
+
+struct SensorStage {
+    SensorStageType type;
+    // VIGNETTE: strength, exponent. NOISE: shot, read. BAYER: pattern.
+    // TONE: exposure, white. GAMMA: gamma.
+    float values[2];
+};
+
+typedef std::vector<SensorStage> SensorChain;
+
+// 1 if the values of every stage are usable and there is at most one bayer stage,
+// 0 otherwise with the reason printed
+int validateSensorChain(const SensorChain &chain);
+
+// Preprocessor defines of the fused sensor stages, empty for an empty chain
+std::string getSensorChainDefines(const SensorChain &chain);
+
+// Key of the noise of the frame: the shader hashes it with the pixel and the
+// stage, so the noise of any pixel of any frame can be recomputed on its own
+void getSensorFrameSeed(uint64_t frame, float seed[2]);
+
+} // namespace camdistort
+
+#endif
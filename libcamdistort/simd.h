@@ -0,0 +1,234 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CAMDISTORT_SIMD_H
+#define CAMDISTORT_SIMD_H
+
+// Thin float vector wrappers so the kernels in kernels.h are written once and
+// instantiated per instruction set. Each translation unit only sees the wrappers its
+// compile flags allow (kernels_sse2.cpp is built with SSE2, kernels_avx2.cpp with AVX2/FMA).
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace camdistort {
+namespace simd {
+// Internal linkage: the same inline code is compiled with different instruction
+// sets in each kernel translation unit and must not be merged by the linker.
+namespace {
+
+//------------------------------------------------------------------------------
+// Scalar, also used for the row tails of the vector kernels
+//------------------------------------------------------------------------------
+struct VScalar {
+    static const int N = 1;
+    typedef bool Mask;
+    float v;
+    VScalar() {}
+    VScalar(float a): v(a) {}
+    static VScalar load(const float* p) { return VScalar(p[0]); }
+    void store(float* p) const { p[0] = v; }
+    // (s, s + 1, ..., s + N - 1)
+    static VScalar ramp(float s) { return VScalar(s); }
+};
+
+inline VScalar operator+(VScalar a, VScalar b) { return VScalar(a.v + b.v); }
+inline VScalar operator-(VScalar a, VScalar b) { return VScalar(a.v - b.v); }
+inline VScalar operator*(VScalar a, VScalar b) { return VScalar(a.v * b.v); }
+inline VScalar operator/(VScalar a, VScalar b) { return VScalar(a.v / b.v); }
+inline VScalar vsqrt(VScalar a) { return VScalar(std::sqrt(a.v)); }
+inline VScalar vmin(VScalar a, VScalar b) { return VScalar(a.v < b.v ? a.v : b.v); }
+inline VScalar vmax(VScalar a, VScalar b) { return VScalar(a.v > b.v ? a.v : b.v); }
+inline VScalar vabs(VScalar a) { return VScalar(std::fabs(a.v)); }
+inline VScalar vfloor(VScalar a) { return VScalar(std::floor(a.v)); }
+inline bool lt(VScalar a, VScalar b) { return a.v < b.v; }
+inline bool gt(VScalar a, VScalar b) { return a.v > b.v; }
+inline bool mand(bool a, bool b) { return a && b; }
+inline bool mor(bool a, bool b) { return a || b; }
+inline bool mnot(bool a) { return !a; }
+inline VScalar select(bool m, VScalar a, VScalar b) { return m ? a : b; }
+
+#if defined(__SSE2__)
+//------------------------------------------------------------------------------
+// SSE2, 4 lanes
+//------------------------------------------------------------------------------
+struct MSse {
+    __m128 v;
+    MSse() {}
+    explicit MSse(__m128 a): v(a) {}
+};
+
+struct VSse {
+    static const int N = 4;
+    typedef MSse Mask;
+    __m128 v;
+    VSse() {}
+    VSse(float a): v(_mm_set1_ps(a)) {}
+    explicit VSse(__m128 a): v(a) {}
+    static VSse load(const float* p) { return VSse(_mm_loadu_ps(p)); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+    static VSse ramp(float s) { return VSse(_mm_add_ps(_mm_set1_ps(s), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f))); }
+};
+
+inline VSse operator+(VSse a, VSse b) { return VSse(_mm_add_ps(a.v, b.v)); }
+inline VSse operator-(VSse a, VSse b) { return VSse(_mm_sub_ps(a.v, b.v)); }
+inline VSse operator*(VSse a, VSse b) { return VSse(_mm_mul_ps(a.v, b.v)); }
+inline VSse operator/(VSse a, VSse b) { return VSse(_mm_div_ps(a.v, b.v)); }
+inline VSse vsqrt(VSse a) { return VSse(_mm_sqrt_ps(a.v)); }
+inline VSse vmin(VSse a, VSse b) { return VSse(_mm_min_ps(a.v, b.v)); }
+inline VSse vmax(VSse a, VSse b) { return VSse(_mm_max_ps(a.v, b.v)); }
+inline VSse vabs(VSse a) { return VSse(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+inline VSse vfloor(VSse a) {
+    // truncate, then step down for negative non-integers
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    __m128 fix = _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f));
+    return VSse(_mm_sub_ps(t, fix));
+}
+inline MSse lt(VSse a, VSse b) { return MSse(_mm_cmplt_ps(a.v, b.v)); }
+inline MSse gt(VSse a, VSse b) { return MSse(_mm_cmpgt_ps(a.v, b.v)); }
+inline MSse mand(MSse a, MSse b) { return MSse(_mm_and_ps(a.v, b.v)); }
+inline MSse mor(MSse a, MSse b) { return MSse(_mm_or_ps(a.v, b.v)); }
+inline MSse mnot(MSse a) { return MSse(_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))); }
+inline VSse select(MSse m, VSse a, VSse b) { return VSse(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))); }
+#endif
+
+#if defined(__AVX2__)
+//------------------------------------------------------------------------------
+// AVX2, 8 lanes
+//------------------------------------------------------------------------------
+struct MAvx {
+    __m256 v;
+    MAvx() {}
+    explicit MAvx(__m256 a): v(a) {}
+};
+
+struct VAvx {
+    static const int N = 8;
+    typedef MAvx Mask;
+    __m256 v;
+    VAvx() {}
+    VAvx(float a): v(_mm256_set1_ps(a)) {}
+    explicit VAvx(__m256 a): v(a) {}
+    static VAvx load(const float* p) { return VAvx(_mm256_loadu_ps(p)); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+    static VAvx ramp(float s) { return VAvx(_mm256_add_ps(_mm256_set1_ps(s), _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f))); }
+};
+
+inline VAvx operator+(VAvx a, VAvx b) { return VAvx(_mm256_add_ps(a.v, b.v)); }
+inline VAvx operator-(VAvx a, VAvx b) { return VAvx(_mm256_sub_ps(a.v, b.v)); }
+inline VAvx operator*(VAvx a, VAvx b) { return VAvx(_mm256_mul_ps(a.v, b.v)); }
+inline VAvx operator/(VAvx a, VAvx b) { return VAvx(_mm256_div_ps(a.v, b.v)); }
+inline VAvx vsqrt(VAvx a) { return VAvx(_mm256_sqrt_ps(a.v)); }
+inline VAvx vmin(VAvx a, VAvx b) { return VAvx(_mm256_min_ps(a.v, b.v)); }
+inline VAvx vmax(VAvx a, VAvx b) { return VAvx(_mm256_max_ps(a.v, b.v)); }
+inline VAvx vabs(VAvx a) { return VAvx(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+inline VAvx vfloor(VAvx a) { return VAvx(_mm256_floor_ps(a.v)); }
+inline MAvx lt(VAvx a, VAvx b) { return MAvx(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+inline MAvx gt(VAvx a, VAvx b) { return MAvx(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline MAvx mand(MAvx a, MAvx b) { return MAvx(_mm256_and_ps(a.v, b.v)); }
+inline MAvx mor(MAvx a, MAvx b) { return MAvx(_mm256_or_ps(a.v, b.v)); }
+inline MAvx mnot(MAvx a) { return MAvx(_mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))); }
+inline VAvx select(MAvx m, VAvx a, VAvx b) { return VAvx(_mm256_blendv_ps(b.v, a.v, m.v)); }
+#endif
+
+//------------------------------------------------------------------------------
+// Math built on the wrappers
+//------------------------------------------------------------------------------
+
+// atan for x >= 0, Cephes style range reduction and polynomial (~1e-7 rel. error)
+template <class V>
+inline V vatan_pos(V x)
+{
+    typedef typename V::Mask M;
+    const float pi_2 = 1.57079632679489661923f;
+    const float pi_4 = 0.78539816339744830962f;
+    M big = gt(x, V(2.414213562373095f));
+    M mid = mand(gt(x, V(0.4142135623730950f)), mnot(big));
+    V safe = vmax(x, V(1e-30f));
+    V t = select(big, V(-1.0f) / safe, select(mid, (x - V(1.0f)) / (x + V(1.0f)), x));
+    V y0 = select(big, V(pi_2), select(mid, V(pi_4), V(0.0f)));
+    V z = t * t;
+    V p = (((V(8.05374449538e-2f) * z - V(1.38776856032e-1f)) * z + V(1.99777106478e-1f)) * z - V(3.33329491539e-1f)) * z * t + t;
+    return y0 + p;
+}
+
+// atan for any sign
+template <class V>
+inline V vatan(V x)
+{
+    V a = vatan_pos(vabs(x));
+    return select(lt(x, V(0.0f)), V(0.0f) - a, a);
+}
+
+// tan, reduced to [-pi/2, pi/2] then to [0, pi/4] with tan(x) = 1 / tan(pi/2 - x)
+template <class V>
+inline V vtan(V x)
+{
+    const float pi = 3.14159265358979323846f;
+    const float pi_2 = 1.57079632679489661923f;
+    const float pi_4 = 0.78539816339744830962f;
+    V xr = x - V(pi) * vfloor(x * V(1.0f / pi) + V(0.5f));
+    V a = vabs(xr);
+    typename V::Mask cot = gt(a, V(pi_4));
+    V z = select(cot, V(pi_2) - a, a);
+    V zz = z * z;
+    V p = (((((V(9.38540185543e-3f) * zz + V(3.11992232697e-3f)) * zz + V(2.44301354525e-2f)) * zz
+            + V(5.34112807005e-2f)) * zz + V(1.33387994085e-1f)) * zz + V(3.33331568548e-1f)) * zz * z + z;
+    V r = select(cot, V(1.0f) / vmax(p, V(1e-30f)), p);
+    return select(lt(xr, V(0.0f)), V(0.0f) - r, r);
+}
+
+}
+}
+}
+
+#endif
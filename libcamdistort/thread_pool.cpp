@@ -0,0 +1,149 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "thread_pool.h"
+
+namespace camdistort {
+
+ThreadPool::ThreadPool(int a_numThreads)
+{
+    m_job = nullptr;
+    m_count = 0;
+    m_next = 0;
+    m_pending = 0;
+    m_generation = 0;
+    m_stop = false;
+
+    if (a_numThreads <= 0){
+        a_numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (a_numThreads <= 0){
+        a_numThreads = 1;
+    }
+    for (int i = 1 ; i < a_numThreads ; i++){
+        m_workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0 ; i < m_workers.size() ; i++){
+        m_workers[i].join();
+    }
+}
+
+ThreadPool& ThreadPool::getDefault()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::runTasks()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_job && m_next < m_count){
+        int index = m_next++;
+        const std::function<void(int)>* job = m_job;
+        lock.unlock();
+        (*job)(index);
+        lock.lock();
+        if (--m_pending == 0){
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    unsigned long seen = 0;
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]{ return m_stop || m_generation != seen; });
+            if (m_stop){
+                return;
+            }
+            seen = m_generation;
+        }
+        runTasks();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &fn)
+{
+    if (count <= 0){
+        return;
+    }
+    if (m_workers.empty() || count == 1){
+        for (int i = 0 ; i < count ; i++){
+            fn(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_count = count;
+        m_next = 0;
+        m_pending = count;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]{ return m_pending == 0; });
+    m_job = nullptr;
+}
+
+}
@@ -0,0 +1,355 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "shm_ring.h"
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace shmring {
+
+// Slot headers start on their own cache line so that readers of one slot don't
+// share lines with the writer filling the next one
+static const uint64_t SLOT_ALIGNMENT = 64;
+
+static uint64_t alignUp(uint64_t a_value, uint64_t a_alignment)
+{
+    return (a_value + a_alignment - 1) / a_alignment * a_alignment;
+}
+
+static uint64_t headerSize()
+{
+    return alignUp(sizeof(RingHeader), SLOT_ALIGNMENT);
+}
+
+size_t getBytesPerPixel(PixelFormat format)
+{
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return 4;
+    case PixelFormat::RGBA8_DEPTH32F:
+        return 4 + sizeof(float);
+    }
+    return 0;
+}
+
+Writer::Writer()
+{
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_nextSlot = 0;
+    m_published = 0;
+}
+
+Writer::~Writer()
+{
+    close();
+}
+
+bool Writer::create(const string &a_name, uint32_t a_numSlots, uint64_t a_slotCapacity)
+{
+    close();
+    if (a_numSlots == 0){
+        return false;
+    }
+
+    uint64_t slotStride = alignUp(sizeof(SlotHeader) + a_slotCapacity, SLOT_ALIGNMENT);
+    size_t size = headerSize() + slotStride * a_numSlots;
+
+    // Readers attached to a previous run keep their old mapping, new ones see the new ring
+    shm_unlink(a_name.c_str());
+    int fd = shm_open(a_name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0){
+        cerr << "ERROR! shm_open(" << a_name << ") failed: " << strerror(errno) << endl;
+        return false;
+    }
+    if (ftruncate(fd, size) != 0){
+        cerr << "ERROR! Can't resize shared memory " << a_name << " to " << size << " bytes: " << strerror(errno) << endl;
+        ::close(fd);
+        shm_unlink(a_name.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+        cerr << "ERROR! mmap of shared memory " << a_name << " failed: " << strerror(errno) << endl;
+        shm_unlink(a_name.c_str());
+        return false;
+    }
+
+    m_name = a_name;
+    m_mapping = mapping;
+    m_mappingSize = size;
+
+    uint8_t* base = static_cast<uint8_t*>(m_mapping);
+    for (uint32_t i = 0 ; i < a_numSlots ; i++){
+        SlotHeader* slot = new (base + headerSize() + i * slotStride) SlotHeader();
+        slot->sequence.store(0, memory_order_relaxed);
+        slot->width = 0;
+        slot->height = 0;
+        slot->format = PixelFormat::RGBA8;
+        slot->reserved = 0;
+        slot->frameId = 0;
+        slot->simTime = 0.0;
+        slot->paramsHash = 0;
+        slot->payloadSize = 0;
+    }
+
+    RingHeader* header = new (base) RingHeader();
+    header->version = VERSION;
+    header->numSlots = a_numSlots;
+    header->reserved = 0;
+    header->slotCapacity = a_slotCapacity;
+    header->slotStride = slotStride;
+    header->latestSlot.store(0, memory_order_relaxed);
+    header->latestFrame.store(0, memory_order_relaxed);
+    // Readers check the magic last, once everything else is in place
+    atomic_thread_fence(memory_order_release);
+    header->magic = MAGIC;
+
+    m_header = header;
+    m_nextSlot = 0;
+    m_published = 0;
+    return true;
+}
+
+void Writer::close()
+{
+    if (m_mapping){
+        munmap(m_mapping, m_mappingSize);
+        shm_unlink(m_name.c_str());
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+}
+
+uint64_t Writer::getSlotCapacity() const
+{
+    return m_header ? m_header->slotCapacity : 0;
+}
+
+bool Writer::publish(uint32_t a_width, uint32_t a_height, PixelFormat a_format, uint64_t a_frameId, double a_simTime,
+                     uint64_t a_paramsHash, const void* a_color, const float* a_depth)
+{
+    if (!m_header){
+        return false;
+    }
+    uint64_t numPixels = (uint64_t)a_width * a_height;
+    uint64_t payloadSize = numPixels * getBytesPerPixel(a_format);
+    if (payloadSize > m_header->slotCapacity || (a_format == PixelFormat::RGBA8_DEPTH32F && !a_depth)){
+        return false;
+    }
+
+    uint8_t* slotBase = static_cast<uint8_t*>(m_mapping) + headerSize() + m_nextSlot * m_header->slotStride;
+    SlotHeader* slot = reinterpret_cast<SlotHeader*>(slotBase);
+    uint8_t* payload = slotBase + sizeof(SlotHeader);
+
+    // Odd: readers that look now or hold a view of this slot will retry
+    uint64_t sequence = slot->sequence.load(memory_order_relaxed);
+    slot->sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->width = a_width;
+    slot->height = a_height;
+    slot->format = a_format;
+    slot->frameId = a_frameId;
+    slot->simTime = a_simTime;
+    slot->paramsHash = a_paramsHash;
+    slot->payloadSize = payloadSize;
+    memcpy(payload, a_color, numPixels * 4);
+    if (a_format == PixelFormat::RGBA8_DEPTH32F){
+        memcpy(payload + numPixels * 4, a_depth, numPixels * sizeof(float));
+    }
+
+    slot->sequence.store(sequence + 2, memory_order_release);
+    m_header->latestSlot.store(m_nextSlot, memory_order_relaxed);
+    m_header->latestFrame.store(a_frameId + 1, memory_order_release);
+
+    m_nextSlot = (m_nextSlot + 1) % m_header->numSlots;
+    m_published++;
+    return true;
+}
+
+Reader::Reader()
+{
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+}
+
+Reader::~Reader()
+{
+    close();
+}
+
+bool Reader::open(const string &a_name)
+{
+    close();
+    int fd = shm_open(a_name.c_str(), O_RDONLY, 0);
+    if (fd < 0){
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < headerSize()){
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+        return false;
+    }
+
+    const RingHeader* header = static_cast<const RingHeader*>(mapping);
+    bool valid = header->magic == MAGIC;
+    atomic_thread_fence(memory_order_acquire);
+    valid = valid && header->version == VERSION &&
+            headerSize() + header->slotStride * header->numSlots <= (uint64_t)info.st_size;
+    if (!valid){
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = info.st_size;
+    m_header = header;
+    return true;
+}
+
+void Reader::close()
+{
+    if (m_mapping){
+        munmap(m_mapping, m_mappingSize);
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+}
+
+const SlotHeader* Reader::getSlot(uint32_t a_index) const
+{
+    const uint8_t* base = static_cast<const uint8_t*>(m_mapping);
+    return reinterpret_cast<const SlotHeader*>(base + headerSize() + a_index * m_header->slotStride);
+}
+
+bool Reader::acquireLatest(FrameView &a_view, int a_maxRetries) const
+{
+    if (!m_header){
+        return false;
+    }
+    for (int attempt = 0 ; attempt < a_maxRetries ; attempt++){
+        if (m_header->latestFrame.load(memory_order_acquire) == 0){
+            return false;
+        }
+        uint32_t index = m_header->latestSlot.load(memory_order_relaxed);
+        if (index >= m_header->numSlots){
+            return false;
+        }
+        const SlotHeader* slot = getSlot(index);
+
+        uint64_t sequence = slot->sequence.load(memory_order_acquire);
+        if (sequence & 1){
+            continue;
+        }
+        a_view.slot = slot;
+        a_view.sequence = sequence;
+        a_view.width = slot->width;
+        a_view.height = slot->height;
+        a_view.format = slot->format;
+        a_view.frameId = slot->frameId;
+        a_view.simTime = slot->simTime;
+        a_view.paramsHash = slot->paramsHash;
+
+        uint64_t numPixels = (uint64_t)a_view.width * a_view.height;
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(slot) + sizeof(SlotHeader);
+        a_view.color = payload;
+        a_view.depth = a_view.format == PixelFormat::RGBA8_DEPTH32F ? reinterpret_cast<const float*>(payload + numPixels * 4) : nullptr;
+
+        if (numPixels * getBytesPerPixel(a_view.format) > m_header->slotCapacity){
+            continue;
+        }
+        if (isValid(a_view)){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Reader::isValid(const FrameView &a_view) const
+{
+    atomic_thread_fence(memory_order_acquire);
+    return a_view.slot->sequence.load(memory_order_relaxed) == a_view.sequence;
+}
+
+bool Reader::copyLatest(FrameView &a_view, uint8_t* a_buffer, size_t a_bufferSize, int a_maxRetries) const
+{
+    for (int attempt = 0 ; attempt < a_maxRetries ; attempt++){
+        if (!acquireLatest(a_view, a_maxRetries)){
+            return false;
+        }
+        uint64_t numPixels = (uint64_t)a_view.width * a_view.height;
+        size_t size = numPixels * getBytesPerPixel(a_view.format);
+        if (size > a_bufferSize){
+            return false;
+        }
+        memcpy(a_buffer, a_view.color, size);
+        if (isValid(a_view)){
+            a_view.color = a_buffer;
+            a_view.depth = a_view.depth ? reinterpret_cast<const float*>(a_buffer + numPixels * 4) : nullptr;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
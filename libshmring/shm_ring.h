@@ -0,0 +1,176 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+// Ring of fixed-size frame slots in POSIX shared memory. One writer publishes, any
+// number of processes read the latest frame straight out of the mapping. Every slot
+// is guarded by a sequence number (seqlock): it is odd while the writer fills the
+// slot and is bumped to the next even value when the frame is complete, so readers
+// never block the writer and detect torn reads by comparing the sequence before
+// and after using the data.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace shmring {
+
+const uint32_t MAGIC = 0x44524d53;  // "SMRD"
+const uint32_t VERSION = 1;
+
+enum class PixelFormat : uint32_t {
+    RGBA8 = 1,
+    // RGBA8 followed by width * height float depth values
+    RGBA8_DEPTH32F = 2,
+};
+
+size_t getBytesPerPixel(PixelFormat format);
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numSlots;
+    uint32_t reserved;
+    // Payload bytes available in every slot
+    uint64_t slotCapacity;
+    // Distance between two slot headers, including the payload and padding
+    uint64_t slotStride;
+    // Slot and frame id of the most recent complete frame, latestFrame is 0 before the first
+    std::atomic<uint32_t> latestSlot;
+    std::atomic<uint64_t> latestFrame;
+};
+
+struct SlotHeader {
+    // Odd while the writer owns the slot
+    std::atomic<uint64_t> sequence;
+    uint32_t width;
+    uint32_t height;
+    PixelFormat format;
+    uint32_t reserved;
+    uint64_t frameId;
+    double simTime;
+    // Identifies the lens model the frame was rendered with, see cameraParamsHash()
+    uint64_t paramsHash;
+    uint64_t payloadSize;
+};
+
+// Latest complete frame, pointing into the shared mapping. The data may be
+// overwritten by the writer at any time; call Reader::isValid() after using it.
+struct FrameView {
+    const SlotHeader* slot;
+    uint64_t sequence;
+    uint32_t width;
+    uint32_t height;
+    PixelFormat format;
+    uint64_t frameId;
+    double simTime;
+    uint64_t paramsHash;
+    const uint8_t* color;
+    // nullptr unless format is RGBA8_DEPTH32F
+    const float* depth;
+};
+
+class Writer {
+public:
+    Writer();
+    ~Writer();
+
+    // Create (or replace) the shared memory object a_name, e.g. "/ambf_camera_left",
+    // with a_numSlots slots of a_slotCapacity payload bytes
+    bool create(const std::string &a_name, uint32_t a_numSlots, uint64_t a_slotCapacity);
+    // Unmap, and unlink the name so that readers can't attach anymore
+    void close();
+
+    // Copy one frame into the next slot. Returns false if it does not fit.
+    bool publish(uint32_t a_width, uint32_t a_height, PixelFormat a_format, uint64_t a_frameId, double a_simTime,
+                 uint64_t a_paramsHash, const void* a_color, const float* a_depth = nullptr);
+
+    bool isOpen() const { return m_header != nullptr; }
+    uint64_t getSlotCapacity() const;
+    uint64_t getPublishedCount() const { return m_published; }
+
+protected:
+    std::string m_name;
+    void* m_mapping;
+    size_t m_mappingSize;
+    RingHeader* m_header;
+    uint32_t m_nextSlot;
+    uint64_t m_published;
+};
+
+class Reader {
+public:
+    Reader();
+    ~Reader();
+
+    bool open(const std::string &a_name);
+    void close();
+
+    // Latest complete frame, without copying. Returns false if there is none yet or
+    // the writer kept overwriting it during a_maxRetries attempts.
+    bool acquireLatest(FrameView &a_view, int a_maxRetries = 8) const;
+    // True if the slot of a_view was not touched by the writer since it was acquired
+    bool isValid(const FrameView &a_view) const;
+
+    // Copy of the latest frame, for consumers that keep it around
+    bool copyLatest(FrameView &a_view, uint8_t* a_buffer, size_t a_bufferSize, int a_maxRetries = 8) const;
+
+    bool isOpen() const { return m_header != nullptr; }
+    const RingHeader* getHeader() const { return m_header; }
+
+protected:
+    const SlotHeader* getSlot(uint32_t a_index) const;
+
+    void* m_mapping;
+    size_t m_mappingSize;
+    const RingHeader* m_header;
+};
+
+}
+
+#endif
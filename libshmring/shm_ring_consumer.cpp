@@ -0,0 +1,166 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+// Stand-in consumer of the shared-memory ring published by the camera distortion
+// plugin. Polls for the latest frame, reads it in place and reports the rate,
+// skipped frame ids and reads torn by the writer.
+//
+//   shm_ring_consumer <name> [--seconds N] [--save file.ppm]
+
+#include "shm_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static bool savePPM(const string &a_filename, const shmring::FrameView &a_view)
+{
+    FILE* file = fopen(a_filename.c_str(), "wb");
+    if (!file){
+        return false;
+    }
+    fprintf(file, "P6\n%u %u\n255\n", a_view.width, a_view.height);
+    vector<unsigned char> row(a_view.width * 3);
+    // Frames are in OpenGL row order, PPM starts at the top
+    for (int y = (int)a_view.height - 1 ; y >= 0 ; y--){
+        const uint8_t* src = a_view.color + (size_t)y * a_view.width * 4;
+        for (uint32_t x = 0 ; x < a_view.width ; x++){
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2){
+        cerr << "Usage: " << argv[0] << " <name> [--seconds N] [--save file.ppm]" << endl;
+        return 1;
+    }
+    string name = argv[1];
+    double seconds = 0.0;
+    string saveFile;
+    for (int i = 2 ; i < argc ; i++){
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc){
+            seconds = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--save") && i + 1 < argc){
+            saveFile = argv[++i];
+        }
+    }
+
+    shmring::Reader reader;
+    while (!reader.open(name)){
+        cerr << "[INFO!] Waiting for " << name << endl;
+        this_thread::sleep_for(chrono::seconds(1));
+    }
+    const shmring::RingHeader* header = reader.getHeader();
+    cerr << "[INFO!] Attached to " << name << ": " << header->numSlots << " slots of " << header->slotCapacity << " bytes" << endl;
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+    uint64_t lastFrame = 0;
+    bool haveFrame = false;
+    unsigned long received = 0, skipped = 0, torn = 0;
+    uint64_t lastHash = 0;
+
+    while (seconds <= 0.0 || chrono::duration<double>(Clock::now() - start).count() < seconds){
+        shmring::FrameView view;
+        if (!reader.acquireLatest(view) || (haveFrame && view.frameId == lastFrame)){
+            this_thread::sleep_for(chrono::microseconds(500));
+        }
+        else{
+            // Touch every pixel in place as a consumer would
+            uint64_t sum = 0;
+            size_t numBytes = (size_t)view.width * view.height * 4;
+            for (size_t i = 0 ; i < numBytes ; i += 4){
+                sum += view.color[i + 1];
+            }
+
+            if (!reader.isValid(view)){
+                torn++;
+            }
+            else{
+                if (haveFrame && view.frameId > lastFrame + 1){
+                    skipped += view.frameId - lastFrame - 1;
+                }
+                if (view.paramsHash != lastHash){
+                    cerr << "[INFO!] Frame " << view.frameId << ": " << view.width << "x" << view.height
+                         << " params hash " << hex << view.paramsHash << dec << endl;
+                    lastHash = view.paramsHash;
+                }
+                if (!saveFile.empty() && received == 0){
+                    if (savePPM(saveFile, view) && reader.isValid(view)){
+                        cerr << "[INFO!] Saved frame " << view.frameId << " to " << saveFile << endl;
+                    }
+                }
+                lastFrame = view.frameId;
+                haveFrame = true;
+                received++;
+            }
+            (void)sum;
+        }
+
+        Clock::time_point now = Clock::now();
+        double elapsed = chrono::duration<double>(now - lastReport).count();
+        if (elapsed >= 1.0){
+            cout << "frame " << lastFrame << " | " << received / chrono::duration<double>(now - start).count() << " Hz"
+                 << " | received " << received << " skipped " << skipped << " torn " << torn << endl;
+            lastReport = now;
+        }
+    }
+    return 0;
+}
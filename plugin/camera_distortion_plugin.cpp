@@ -52,6 +52,43 @@ afCameraDistortionPlugin::afCameraDistortionPlugin()
     cout << "/*********************************************" << endl;
     cout << "/* AMBF Camera Distortion Plugin" << endl;
     cout << "/*********************************************" << endl;
+
+    m_useWarpMap = false;
+    m_warpMapFailed = false;
+    m_warpMapFailedVersion = 0;
+    m_shaderVariants = true;
+    m_tightFrustum = false;
+    m_useCubeMap = false;
+    m_blackoutMask = false;
+    m_blackoutMaskBuilt = false;
+    m_sceneMask = nullptr;
+    m_coverageWorld = nullptr;
+    m_coverageMesh = nullptr;
+    m_headless = false;
+    m_presentBlit = false;
+    m_outputWidth = 0;
+    m_outputHeight = 0;
+    m_frameIndex = 0;
+    m_sensorFrame = 0;
+    m_paramsVersion = 0;
+    m_shmWarned = false;
+    m_readback = false;
+    m_depthFilterMin = false;
+    m_sceneMipmaps = false;
+    m_anisotropy = 1.0f;
+    m_quadWorld.m_world = nullptr;
+    m_quadWorld.m_quadMesh = nullptr;
+    m_emptyWorld = nullptr;
+    m_lensSteps = 32;
+    m_warpMapCacheSize = 0;
+    m_lensSetting[0] = 0.0f;
+    m_lensSetting[1] = 0.0f;
+    m_lensSettingChanged = false;
+    m_warpMapRequested = false;
+    m_pendingReload.hasParams = false;
+    m_pendingReload.shadersChanged = false;
+    m_reloadOutputSize[0] = 0;
+    m_reloadOutputSize[1] = 0;
 }
 
 int afCameraDistortionPlugin::init(const afBaseObjectPtr a_afObjectPtr, const afBaseObjectAttribsPtr a_objectAttribs)
@@ -70,9 +107,43 @@ int afCameraDistortionPlugin::init(const afBaseObjectPtr a_afObjectPtr, const af
 
     // If there is a configuration file given in the ADF file
     if (specificationDataNode["plugins"][0]["distortion_config"]){
-        string m_configPath = specificationDataNode["plugins"][0]["distortion_config"].as<string>();
+        m_configPath = specificationDataNode["plugins"][0]["distortion_config"].as<string>();
         cerr << "[INFO!] Reading configuration file: " << m_configPath << endl;
-        readCameraParams(m_configPath, m_cameraParams);
+        if (!readCameraParams(m_configPath, m_cameraParams) || !validateCameraParams(m_cameraParams)){
+            cerr << "ERROR! Invalid camera configuration " << m_configPath << endl;
+            return -1;
+        }
+
+        // Zoom / focus lens, the calibration follows setLensSetting()
+        if (!readLensSchedule(m_configPath, m_cameraParams, m_lensSchedule)){
+            cerr << "WARNING! Ignoring the keyframes of " << m_configPath << endl;
+        }
+        // Vignette, noise, mosaic and tone of the sensor, fused into the distortion pass
+        if (!readSensorChain(m_configPath, m_sensorChain)){
+            cerr << "WARNING! Ignoring the sensor stages of " << m_configPath << endl;
+            m_sensorChain.clear();
+        }
+        if (!m_lensSchedule.empty()){
+            m_lensSetting[0] = m_lensSchedule.getKeyframe(0).zoom;
+            m_lensSetting[1] = m_lensSchedule.getKeyframe(0).focus;
+            m_warpMapCacheSize = 16;
+            if (specificationDataNode["plugins"][0]["zoom"]){
+                m_lensSetting[0] = specificationDataNode["plugins"][0]["zoom"].as<float>();
+            }
+            if (specificationDataNode["plugins"][0]["focus"]){
+                m_lensSetting[1] = specificationDataNode["plugins"][0]["focus"].as<float>();
+            }
+            if (specificationDataNode["plugins"][0]["lens_steps"]){
+                m_lensSteps = specificationDataNode["plugins"][0]["lens_steps"].as<int>();
+            }
+            if (specificationDataNode["plugins"][0]["warp_map_cache"]){
+                m_warpMapCacheSize = max(0, specificationDataNode["plugins"][0]["warp_map_cache"].as<int>());
+            }
+            m_cameraParams = m_lensSchedule.evaluate(m_lensSetting[0], m_lensSetting[1], m_lensSteps);
+            afResourceCache::getInstance().retainUnusedWarpMaps(m_warpMapCacheSize);
+            cerr << "[INFO!] Lens calibrated at " << m_lensSchedule.size() << " zoom / focus settings, starting at zoom "
+                 << m_lensSetting[0] << ", focus " << m_lensSetting[1] << endl;
+        }
     }
     
     // If there is no configuration file given
@@ -81,73 +152,349 @@ int afCameraDistortionPlugin::init(const afBaseObjectPtr a_afObjectPtr, const af
         return -1;
     }
 
-    
-    // change screen size to match camera params
-    // user can later resize
-    changeScreenSize(m_cameraParams.width, m_cameraParams.height);
-    // changeScreenSize(500, 500);
-    cerr << "Camera image: [" << m_camera->m_width << "x" << m_camera->m_height  << "]" << endl;
+    // Headless: render at the calibrated image size into offscreen targets, no monitor needed
+    if (specificationDataNode["plugins"][0]["headless"]){
+        m_headless = specificationDataNode["plugins"][0]["headless"].as<bool>();
+    }
+
+    // Opt-in: the data resolution is image_size whatever the window size, the window only
+    // gets a blit. The window then bypasses afCamera::render(), so no label updates, no
+    // window size refresh or close handling and no image / depth publishing of AMBF.
+    if (specificationDataNode["plugins"][0]["present"]){
+        string present = specificationDataNode["plugins"][0]["present"].as<string>();
+        if (present == "blit"){
+            m_presentBlit = true;
+        }
+        else if (present != "direct"){
+            cerr << "WARNING! Unknown present: " << present << ", using direct" << endl;
+        }
+    }
+
+    string outputDir;
+    if (m_headless){
+        glfwHideWindow(m_camera->m_window);
+        glfwSwapInterval(0);
+        cerr << "[INFO!] Headless rendering at [" << m_cameraParams.width << "x" << m_cameraParams.height << "]" << endl;
+
+        if (specificationDataNode["plugins"][0]["output_dir"]){
+            outputDir = specificationDataNode["plugins"][0]["output_dir"].as<string>();
+            if (!m_frameWriter.start(outputDir, m_camera->getName())){
+                return -1;
+            }
+            cerr << "[INFO!] Writing distorted frames to: " << outputDir << endl;
+            m_readback = true;
+        }
+    }
+    else{
+        // change screen size to match camera params
+        // user can later resize
+        changeScreenSize(m_cameraParams.width, m_cameraParams.height);
+        // changeScreenSize(500, 500);
+        cerr << "Camera image: [" << m_camera->m_width << "x" << m_camera->m_height  << "]" << endl;
+        if (m_presentBlit){
+            cerr << "[INFO!] Rendering at [" << m_cameraParams.width << "x" << m_cameraParams.height << "], scaled into the window" << endl;
+        }
+    }
+    updateOutputSize();
+
+    // Asynchronous readback of the distorted frames, also available with a window
+    if (specificationDataNode["plugins"][0]["readback"]){
+        m_readback = m_readback || specificationDataNode["plugins"][0]["readback"].as<bool>();
+    }
+    string shmName;
+    if (specificationDataNode["plugins"][0]["shm_name"]){
+        shmName = specificationDataNode["plugins"][0]["shm_name"].as<string>();
+        m_readback = true;
+    }
+    if (m_readback){
+        int numSlots = 3;
+        bool captureDepth = false;
+        if (specificationDataNode["plugins"][0]["readback_frames"]){
+            numSlots = specificationDataNode["plugins"][0]["readback_frames"].as<int>();
+        }
+        if (specificationDataNode["plugins"][0]["capture_depth"]){
+            captureDepth = specificationDataNode["plugins"][0]["capture_depth"].as<bool>();
+        }
+        m_readbackRing.setup(numSlots, captureDepth);
+        // Texels at object edges either sample the nearest scene depth or the closest of the 2x2 around it
+        if (specificationDataNode["plugins"][0]["depth_filter"]){
+            string depthFilter = specificationDataNode["plugins"][0]["depth_filter"].as<string>();
+            if (depthFilter == "min"){
+                m_depthFilterMin = true;
+            }
+            else if (depthFilter != "nearest"){
+                cerr << "WARNING! Unknown depth_filter: " << depthFilter << ", using nearest" << endl;
+            }
+        }
+        m_readbackRing.setCallback([this](afFrame &a_frame){ onFrameReady(a_frame, m_shmWriter, m_shmWarned, m_frameWriter); });
+        cerr << "[INFO!] Reading back distorted frames through " << m_readbackRing.getNumSlots() << " PBOs"
+             << (captureDepth ? " (color + depth)" : " (color)") << endl;
+    }
+
+    // Publish to out-of-process consumers, slots are sized for the initial output size
+    if (!shmName.empty()){
+        int numSlots = 4;
+        if (specificationDataNode["plugins"][0]["shm_slots"]){
+            numSlots = specificationDataNode["plugins"][0]["shm_slots"].as<int>();
+        }
+        shmring::PixelFormat format = m_readbackRing.getCaptureDepth() ? shmring::PixelFormat::RGBA8_DEPTH32F : shmring::PixelFormat::RGBA8;
+        uint64_t capacity = (uint64_t)m_outputWidth * m_outputHeight * shmring::getBytesPerPixel(format);
+        if (!m_shmWriter.create(shmName, numSlots, capacity)){
+            return -1;
+        }
+        cerr << "[INFO!] Publishing distorted frames to shared memory: " << shmName << endl;
+    }
+
+    // More resolutions of the same frame, each with its own distortion pass and consumers
+    // named after its size
+    if (specificationDataNode["plugins"][0]["extra_outputs"]){
+        YAML::Node extraOutputs = specificationDataNode["plugins"][0]["extra_outputs"];
+        for (size_t i = 0 ; i < extraOutputs.size() ; i++){
+            if (!extraOutputs[i].IsSequence() || extraOutputs[i].size() != 2){
+                cerr << "WARNING! extra_outputs entries are [width, height], ignoring entry " << i << endl;
+                continue;
+            }
+            unique_ptr<afExtraOutput> output(new afExtraOutput());
+            output->m_width = extraOutputs[i][0].as<int>();
+            output->m_height = extraOutputs[i][1].as<int>();
+            if (output->m_width <= 0 || output->m_height <= 0){
+                cerr << "WARNING! Invalid extra output size [" << output->m_width << "x" << output->m_height << "], ignored" << endl;
+                continue;
+            }
+            string suffix = "_" + to_string(output->m_width) + "x" + to_string(output->m_height);
+            if (m_readback){
+                afExtraOutput* extra = output.get();
+                output->m_readbackRing.setup(m_readbackRing.getNumSlots(), m_readbackRing.getCaptureDepth());
+                output->m_readbackRing.setCallback([this, extra](afFrame &a_frame){ onFrameReady(a_frame, extra->m_shmWriter, extra->m_shmWarned, extra->m_frameWriter); });
+            }
+            if (!outputDir.empty() && !output->m_frameWriter.start(outputDir, m_camera->getName() + suffix)){
+                return -1;
+            }
+            if (m_shmWriter.isOpen()){
+                shmring::PixelFormat format = m_readbackRing.getCaptureDepth() ? shmring::PixelFormat::RGBA8_DEPTH32F : shmring::PixelFormat::RGBA8;
+                uint64_t capacity = (uint64_t)output->m_width * output->m_height * shmring::getBytesPerPixel(format);
+                int numSlots = 4;
+                if (specificationDataNode["plugins"][0]["shm_slots"]){
+                    numSlots = specificationDataNode["plugins"][0]["shm_slots"].as<int>();
+                }
+                if (!output->m_shmWriter.create(shmName + suffix, numSlots, capacity)){
+                    return -1;
+                }
+            }
+            cerr << "[INFO!] Extra output [" << output->m_width << "x" << output->m_height << "]" << endl;
+            m_extraOutputs.push_back(std::move(output));
+        }
+    }
 
 
     m_camera->setOverrideRendering(true);
-    m_frameBuffer = cFrameBuffer::create();
+
+    // Per-stage CPU/GPU timings, off unless requested
+    m_stages.scene = m_profiler.addStage("scene");
+    m_stages.params = m_profiler.addStage("params");
+    m_stages.resize = m_profiler.addStage("resize");
+    m_stages.warpMap = m_profiler.addStage("warp_map");
+    m_stages.sourceFrustum = m_profiler.addStage("source_frustum");
+    m_stages.blackoutMask = m_profiler.addStage("blackout_mask");
+    m_stages.cubeSource = m_profiler.addStage("cube_source");
+    m_stages.offscreen = m_profiler.addStage("offscreen");
+    m_stages.distortion = m_profiler.addStage("distortion");
+    m_stages.present = m_profiler.addStage("present");
+    m_stages.reuse = m_profiler.addStage("reuse");
+    if (specificationDataNode["plugins"][0]["profile"] && specificationDataNode["plugins"][0]["profile"].as<bool>()){
+        string profileFile;
+        double profilePeriod = 5.0;
+        if (specificationDataNode["plugins"][0]["profile_file"]){
+            profileFile = specificationDataNode["plugins"][0]["profile_file"].as<string>();
+        }
+        if (specificationDataNode["plugins"][0]["profile_period"]){
+            profilePeriod = specificationDataNode["plugins"][0]["profile_period"].as<double>();
+        }
+        m_profiler.enable(profileFile, profilePeriod);
+        cerr << "[INFO!] Profiling render stages" << (profileFile.empty() ? "" : " to: " + profileFile) << endl;
+    }
+
+    // Resizes are debounced and previous sizes pooled, see afFrameBufferManager
+    if (specificationDataNode["plugins"][0]["resize_debounce"]){
+        m_frameBufferManager.setDebounceTime(specificationDataNode["plugins"][0]["resize_debounce"].as<double>());
+    }
+    if (specificationDataNode["plugins"][0]["framebuffer_pool_size"]){
+        m_frameBufferManager.setPoolSize(specificationDataNode["plugins"][0]["framebuffer_pool_size"].as<int>());
+    }
+
+    // Render only the part of the scene the distortion samples, at the resolution it needs
+    if (specificationDataNode["plugins"][0]["tight_frustum"]){
+        m_tightFrustum = specificationDataNode["plugins"][0]["tight_frustum"].as<bool>();
+    }
+    if (specificationDataNode["plugins"][0]["max_texel_stretch"]){
+        m_sourceFrustum.setMaxTexelStretch(specificationDataNode["plugins"][0]["max_texel_stretch"].as<double>());
+        m_cubeSource.setMaxTexelStretch(specificationDataNode["plugins"][0]["max_texel_stretch"].as<double>());
+    }
+    if (specificationDataNode["plugins"][0]["max_source_scale"]){
+        m_sourceFrustum.setMaxSourceScale(specificationDataNode["plugins"][0]["max_source_scale"].as<double>());
+    }
+
+    // Lenses past what one perspective frustum covers render the scene into cube faces
+    if (specificationDataNode["plugins"][0]["cubemap"]){
+        m_useCubeMap = specificationDataNode["plugins"][0]["cubemap"].as<bool>();
+    }
+    if (specificationDataNode["plugins"][0]["max_cube_face"]){
+        m_cubeSource.setMaxFaceSize(specificationDataNode["plugins"][0]["max_cube_face"].as<int>());
+    }
+    if (m_useCubeMap){
+        cerr << "[INFO!] Rendering the scene into cube faces, sampled through the inverse of the lens model" << endl;
+        if (m_tightFrustum){
+            cerr << "[INFO!] tight_frustum does not apply to cubemap, the faces are cropped instead" << endl;
+            m_tightFrustum = false;
+        }
+        if (m_readbackRing.getCaptureDepth()){
+            cerr << "WARNING! capture_depth is not supported with cubemap, the captured depth is 0" << endl;
+        }
+    }
+
+    // Mip pyramid of the scene, sampled with the footprint of every output pixel so that
+    // compressed regions of the lens do not alias
+    if (specificationDataNode["plugins"][0]["scene_mipmaps"]){
+        m_sceneMipmaps = specificationDataNode["plugins"][0]["scene_mipmaps"].as<bool>();
+    }
+    if (specificationDataNode["plugins"][0]["anisotropy"]){
+        m_anisotropy = specificationDataNode["plugins"][0]["anisotropy"].as<float>();
+    }
+    if (m_sceneMipmaps){
+        if (m_useCubeMap){
+            cerr << "[INFO!] scene_mipmaps does not apply to cubemap, the faces are sized to the lens instead" << endl;
+            m_sceneMipmaps = false;
+        }
+        else if (m_anisotropy > 1.0f){
+            GLfloat maxAnisotropy = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+            m_anisotropy = min(m_anisotropy, maxAnisotropy);
+        }
+    }
+
+    // Sensor readout, reprojects the rows of the single scene pass to their exposure times
+    if (specificationDataNode["plugins"][0]["readout_time"]){
+        m_rollingShutter.setReadoutTime(specificationDataNode["plugins"][0]["readout_time"].as<double>());
+    }
+    if (specificationDataNode["plugins"][0]["exposure_time"]){
+        int samples = 4;
+        if (specificationDataNode["plugins"][0]["shutter_samples"]){
+            samples = specificationDataNode["plugins"][0]["shutter_samples"].as<int>();
+        }
+        m_rollingShutter.setExposureTime(specificationDataNode["plugins"][0]["exposure_time"].as<double>(), samples);
+    }
+    if (m_rollingShutter.isEnabled()){
+        if (m_useCubeMap){
+            cerr << "WARNING! readout_time and exposure_time are not supported with cubemap, rendering a global shutter" << endl;
+            m_rollingShutter.setReadoutTime(0.0);
+            m_rollingShutter.setExposureTime(0.0, 1);
+        }
+        else{
+            cerr << "[INFO!] Rolling shutter: readout " << m_rollingShutter.getReadoutTime() << " s, exposure "
+                 << m_rollingShutter.getExposureTime() << " s over " << m_rollingShutter.getSamples() << " poses" << endl;
+        }
+    }
+
+    // Frame rate of the modeled camera, the ticks in between reuse the last frame
+    if (specificationDataNode["plugins"][0]["rate_hz"]){
+        double rate = specificationDataNode["plugins"][0]["rate_hz"].as<double>();
+        if (rate < 0.0){
+            cerr << "WARNING! rate_hz must be positive, rendering at every tick" << endl;
+            rate = 0.0;
+        }
+        m_updateGate.setRate(rate);
+    }
+    if (specificationDataNode["plugins"][0]["skip_static"]){
+        m_updateGate.setSkipStatic(specificationDataNode["plugins"][0]["skip_static"].as<bool>());
+    }
+    if (m_updateGate.isEnabled()){
+        cerr << "[INFO!] Rendering " << (m_updateGate.getRate() > 0.0 ? "at " + to_string(m_updateGate.getRate()) + " Hz" : "at every tick")
+             << (m_updateGate.getSkipStatic() ? ", only when the camera, its parameters or the scene moved" : "") << endl;
+    }
+
+    // Skip the pixels and scene texels hidden by the blackout circle and the border
+    if (specificationDataNode["plugins"][0]["blackout_mask"]){
+        m_blackoutMask = specificationDataNode["plugins"][0]["blackout_mask"].as<bool>();
+    }
 
     // Initialize framebuffer (framebuffer store color/depth information)
     // after changeScreenSize, should match cameraParams width and height
-    m_frameBuffer->setup(m_camera->getInternalCamera(), m_camera->m_width, m_camera->m_height, true, true, GL_RGBA);
+    m_frameBufferManager.setup(m_camera->getInternalCamera(), m_outputWidth, m_outputHeight, true, true, GL_RGBA);
+    m_frameBuffer = m_frameBufferManager.getFrameBuffer();
 
-    // Specify shader files
-    afShaderAttributes shaderAttribs;
-    shaderAttribs.m_shaderDefined = true;
-    shaderAttribs.m_vtxFilepath = specificationDataNode["plugins"][0]["vertex_shader"].as<string>();
-    shaderAttribs.m_fragFilepath = specificationDataNode["plugins"][0]["fragment_shader"].as<string>();
+    // Cameras with the same shaders share the program and the quad, see afResourceCache
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    m_vertexShader = specificationDataNode["plugins"][0]["vertex_shader"].as<string>();
+    m_fragmentShader = specificationDataNode["plugins"][0]["fragment_shader"].as<string>();
 
-    m_shaderPgm = afShaderUtils::createFromAttribs(&shaderAttribs, "CameraDistortion", "CameraDistortion");
+    // One program per lens model / feature combination, see getShaderDefines()
+    if (specificationDataNode["plugins"][0]["shader_variants"]){
+        m_shaderVariants = specificationDataNode["plugins"][0]["shader_variants"].as<bool>();
+    }
+    m_shaderDefines = getShaderDefines(m_cameraParams);
+    m_shaderPgm = resourceCache.acquireProgram(m_vertexShader, m_fragmentShader, "CameraDistortion", m_shaderDefines);
+    if (!m_shaderPgm && m_shaderVariants){
+        cerr << "WARNING! Falling back to the generic distortion program" << endl;
+        m_shaderVariants = false;
+        m_shaderDefines = getShaderDefines(m_cameraParams);
+        m_shaderPgm = resourceCache.acquireProgram(m_vertexShader, m_fragmentShader, "CameraDistortion", m_shaderDefines);
+    }
     if (!m_shaderPgm){
         cerr << "ERROR! FAILED TO LOAD SHADER PGM \n";
         return -1;
     }
 
-    // Set two sets of trinangles
-    m_quadMesh = new cMesh();
-    float quad[] = {
-        // positions
-         -1.0f,  1.0f, 0.0f,
-         -1.0f, -1.0f, 0.0f,
-          1.0f, -1.0f, 0.0f,
-         -1.0f,  1.0f, 0.0f,
-          1.0f, -1.0f, 0.0f,
-          1.0f,  1.0f, 0.0f,
-    };
-
-    // Create triangles to set Texture coordinate
-    for (int vI = 0 ; vI < 2 ; vI++){
-        int off = vI * 9;
-        cVector3d v0(quad[off + 0], quad[off + 1], quad[off + 2]);
-        cVector3d v1(quad[off + 3], quad[off + 4], quad[off + 5]);
-        cVector3d v2(quad[off + 6], quad[off + 7], quad[off + 8]);
-        m_quadMesh->newTriangle(v0, v1, v2);
-    }
-
-    m_quadMesh->m_vertices->setTexCoord(1, 0.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(2, 1.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(0, 0.0, 1.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(3, 0.0, 1.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(4, 1.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(5, 1.0, 1.0, 1.0);
-
-    m_quadMesh->computeAllNormals();
-    m_quadMesh->m_texture = m_frameBuffer->m_imageBuffer;
-    m_quadMesh->setUseTexture(true);
+    // Optionally replace the per-fragment distortion model by a precomputed lookup texture
+    if (specificationDataNode["plugins"][0]["warp_map"]){
+        m_useWarpMap = specificationDataNode["plugins"][0]["warp_map"].as<bool>();
+    }
+    m_warpMapRequested = m_useWarpMap;
+    // The shader only evaluates the forward model, the inverse only exists as a map
+    if (m_cameraParams.inverse && !m_useWarpMap){
+        cerr << "[INFO!] warp_direction: inverse requires the precomputed warp map, enabling it" << endl;
+        m_useWarpMap = true;
+    }
+    // A remap is its own warp map, there are no rays to render cube faces for
+    if (m_cameraParams.distortion_type == DistortionType::REMAP){
+        if (m_useCubeMap){
+            cerr << "WARNING! cubemap does not apply to type: remap, rendering a single frustum" << endl;
+            m_useCubeMap = false;
+        }
+        m_useWarpMap = true;
+    }
+    // The cube faces are always sampled through the direction map
+    if (m_useCubeMap){
+        m_useWarpMap = false;
+    }
+    if (m_useWarpMap){
+        cerr << "[INFO!] Using precomputed warp map" << endl;
+    }
+
+    // Resolve the uniform locations once for this program
+    registerUniforms();
 
-    m_quadMesh->setShaderProgram(m_shaderPgm);
-    m_quadMesh->setShowEnabled(true);
+    m_quadWorld = resourceCache.acquireQuadWorld(m_shaderPgm);
+    m_quadMesh = m_quadWorld.m_quadMesh;
+    m_distortedWorld = m_quadWorld.m_world;
 
-    m_distortedWorld = new cWorld();
-    m_distortedWorld->addChild(m_quadMesh);
+    // Replaces the front layer so that only the camera feed distortion is rendered
+    m_emptyWorld = resourceCache.acquireEmptyWorld();
 
     updateCameraParams();
 
+    // Pick up edits of the config and the shaders without restarting the simulation
+    if (specificationDataNode["plugins"][0]["hot_reload"] && specificationDataNode["plugins"][0]["hot_reload"].as<bool>()){
+        m_reloadOutputSize[0] = m_outputWidth;
+        m_reloadOutputSize[1] = m_outputHeight;
+        vector<string> files;
+        files.push_back(m_configPath);
+        files.push_back(m_vertexShader);
+        files.push_back(m_fragmentShader);
+        if (m_fileWatcher.start(files, [this](const vector<string> &a_files){ onFilesChanged(a_files); })){
+            cerr << "[INFO!] Watching " << m_configPath << ", " << m_vertexShader << " and " << m_fragmentShader << " for changes" << endl;
+        }
+    }
+
     // makeFullScreen();
 
     return 1;
@@ -156,75 +503,824 @@ int afCameraDistortionPlugin::init(const afBaseObjectPtr a_afObjectPtr, const af
 void afCameraDistortionPlugin::graphicsUpdate()
 {
     glfwMakeContextCurrent(m_camera->m_window);
+    m_profiler.beginFrame();
+    if (m_fileWatcher.isRunning()){
+        applyPendingReload();
+    }
+
+    // Decided before any pass, the size and the lens setting take part in the decision
+    updateOutputSize();
+    updateLensSetting();
+    if (m_updateGate.isEnabled() && !m_updateGate.update(m_camera->getInternalCamera(), m_camera->m_afWorld->getSimulationTime(), m_paramsVersion)){
+        afProfileScope scope(m_profiler, m_stages.reuse);
+        reuseFrame();
+        return;
+    }
 
-    m_frameBuffer->renderView();
+    m_profiler.begin(m_stages.scene);
+    if (m_useCubeMap){
+        m_cubeSource.render(m_camera->getInternalCamera());
+    }
+    else{
+        if (m_tightFrustum){
+            m_sourceFrustum.begin(m_camera->getInternalCamera());
+        }
+        if (m_sceneMask){
+            m_sceneMask->setShowEnabled(!m_sceneMask->isEmpty());
+        }
+        m_frameBuffer->renderView();
+        if (m_sceneMask){
+            m_sceneMask->setShowEnabled(false);
+        }
+        if (m_sceneMipmaps){
+            updateSceneMipmaps();
+        }
+        if (m_tightFrustum){
+            m_sourceFrustum.end(m_camera->getInternalCamera());
+        }
+    }
+    m_profiler.end(m_stages.scene);
 
     // do these two steps after rending the view otherwise
     // the silhouettes of objects in the scene may appear
-    // update params, specifically window size
+    // update params
+    m_profiler.begin(m_stages.params);
+    updateShaderVariant();
+    if (m_rollingShutter.isEnabled()){
+        m_rollingShutter.update(m_camera->getInternalCamera(), m_camera->m_afWorld->getSimulationTime());
+    }
+    if (!m_sensorChain.empty()){
+        float seed[2];
+        camdistort::getSensorFrameSeed(m_sensorFrame++, seed);
+        m_shaderParams.setVec2(m_uniforms.sensorSeed, seed[0], seed[1]);
+    }
     updateCameraParams();
-    // dynamically resize buffer
-    m_frameBuffer->setSize(m_camera->m_width, m_camera->m_height);
+    m_profiler.end(m_stages.params);
+
+    // rebuild the lookup only if the params or the window size changed
+    if (m_useWarpMap || m_useCubeMap){
+        afProfileScope scope(m_profiler, m_stages.warpMap);
+        afWarpMapType type = getWarpMapType(m_cameraParams);
+        bool failed = m_warpMapFailed && m_warpMapFailedVersion == m_paramsVersion;
+        if (!failed && (!m_warpMap || m_warpMap->isStale(m_cameraParams, m_outputWidth, m_outputHeight, type))){
+            shared_ptr<afWarpMap> warpMap = afResourceCache::getInstance().acquireWarpMap(m_cameraParams, m_outputWidth, m_outputHeight, type);
+            m_warpMapFailed = !warpMap;
+            if (warpMap){
+                afResourceCache::getInstance().releaseWarpMap(m_warpMap);
+                m_warpMap = warpMap;
+            }
+            else{
+                m_warpMapFailedVersion = m_paramsVersion;
+                cerr << "WARNING! Building the warp map failed, " << (m_warpMap ? "keeping the previous map" : "rendering an undistorted pinhole image") << endl;
+            }
+        }
+        if (m_warpMap){
+            m_warpMap->bind(GL_TEXTURE3);
+        }
+        updateWarpMapUniforms();
+        m_shaderParams.upload();
+    }
+    updateSourceFrustum();
+    updateCubeSource();
+    updateBlackoutMask();
+    vector<float>().swap(m_analysisMap);
+
+    // dynamically resize buffer, only once the window size settled
+    m_profiler.begin(m_stages.resize);
+    int sourceWidth = m_tightFrustum ? m_sourceFrustum.getSourceWidth() : m_outputWidth;
+    int sourceHeight = m_tightFrustum ? m_sourceFrustum.getSourceHeight() : m_outputHeight;
+    // Not sampled in cube mode, kept only because the quad expects a texture
+    if (m_useCubeMap){
+        sourceWidth = 16;
+        sourceHeight = 16;
+    }
+    if (m_frameBufferManager.update(sourceWidth, sourceHeight)){
+        m_frameBuffer = m_frameBufferManager.getFrameBuffer();
+    }
+    m_profiler.end(m_stages.resize);
+
+    // The quad may be shared with other cameras, point it at our scene
+    m_quadMesh->m_texture = m_frameBuffer->m_imageBuffer;
+    if (m_coverageMesh){
+        m_coverageMesh->m_texture = m_frameBuffer->m_imageBuffer;
+    }
+
+    if (m_useCubeMap){
+        m_cubeSource.bind(GL_TEXTURE5);
+    }
+
+    // Scene depth for the distorted depth written by the shader and the rolling shutter
+    // reprojection, never interpolated across edges
+    if (m_readbackRing.getCaptureDepth() || m_rollingShutter.isEnabled()){
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, m_frameBuffer->m_depthBuffer->getTextureId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glActiveTexture(GL_TEXTURE0);
+        m_shaderParams.setVec2(m_uniforms.depthTextureSize, static_cast<float>(m_frameBuffer->getWidth()),
+                               static_cast<float>(m_frameBuffer->getHeight()));
+    }
+
+    if (m_headless || m_presentBlit || m_readback || !m_extraOutputs.empty()){
+        afProfileScope scope(m_profiler, m_stages.offscreen);
+        renderOffscreen();
+    }
+    if (m_headless){
+        return;
+    }
+    if (m_presentBlit){
+        afProfileScope scope(m_profiler, m_stages.present);
+        presentOutput();
+        return;
+    }
+
+    renderDirect();
+}
 
+void afCameraDistortionPlugin::renderDirect()
+{
     afRenderOptions ro;
     ro.m_updateLabels = true;
 
     // Temporarily switch camera to Distorted world
     cWorld* cachedWorld = m_camera->getInternalCamera()->getParentWorld();
     m_camera->getInternalCamera()->setStereoMode(C_STEREO_DISABLED);
-    m_camera->getInternalCamera()->setParentWorld(m_distortedWorld);
+    m_camera->getInternalCamera()->setParentWorld(m_coverageWorld ? m_coverageWorld : m_distortedWorld);
 
     // Render only camera feed distortion
-    static cWorld* emptyWorld = new cWorld();
     cWorld* frontLayer = m_camera->getInternalCamera()->m_frontLayer;
-    m_camera->getInternalCamera()->m_frontLayer = emptyWorld;
+    m_camera->getInternalCamera()->m_frontLayer = m_emptyWorld;
+    m_profiler.begin(m_stages.distortion);
     m_camera->render(ro);
+    m_profiler.end(m_stages.distortion);
     m_camera->getInternalCamera()->m_frontLayer = frontLayer;
 
     m_camera->getInternalCamera()->setStereoMode(C_STEREO_DISABLED);
     m_camera->getInternalCamera()->setParentWorld(cachedWorld);
 }
 
-void afCameraDistortionPlugin::physicsUpdate(double dt)
+void afCameraDistortionPlugin::updateSceneMipmaps()
 {
+    // Chai3D sets the filters of its textures itself whenever it binds them
+    m_frameBuffer->m_imageBuffer->setMinFunction(GL_LINEAR_MIPMAP_LINEAR);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_frameBuffer->m_imageBuffer->getTextureId());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    if (m_anisotropy > 1.0f){
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, m_anisotropy);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
 
+void afCameraDistortionPlugin::updateOutputSize()
+{
+    const int width = m_outputWidth;
+    const int height = m_outputHeight;
+    if (m_headless || m_presentBlit){
+        m_outputWidth = static_cast<int>(m_cameraParams.width);
+        m_outputHeight = static_cast<int>(m_cameraParams.height);
+    }
+    else{
+        m_outputWidth = m_camera->m_width;
+        m_outputHeight = m_camera->m_height;
+    }
+    if (m_outputWidth != width || m_outputHeight != height){
+        m_paramsVersion++;
+    }
 }
 
-void afCameraDistortionPlugin::reset(){
+void afCameraDistortionPlugin::updateSourceFrustum()
+{
+    if (!m_tightFrustum || !m_sourceFrustum.isStale(m_cameraParams, m_outputWidth, m_outputHeight)){
+        return;
+    }
+    afProfileScope scope(m_profiler, m_stages.sourceFrustum);
+    m_sourceFrustum.update(m_cameraParams, m_outputWidth, m_outputHeight, getCpuWarpMap());
+}
 
+afWarpMapType afCameraDistortionPlugin::getWarpMapType(const CameraParams &a_params) const
+{
+    if (m_useCubeMap){
+        return afWarpMapType::DIRECTION;
+    }
+    return a_params.distortion_type == DistortionType::REMAP ? afWarpMapType::REMAP : afWarpMapType::UV;
 }
 
-bool afCameraDistortionPlugin::close()
+const float* afCameraDistortionPlugin::getCpuWarpMap()
 {
-    return true;
+    if (m_warpMap && m_warpMap->getType() != afWarpMapType::REMAP){
+        return m_warpMap->getData().data();
+    }
+    if (m_analysisMap.size() == 4 * (size_t)m_outputWidth * m_outputHeight){
+        return m_analysisMap.data();
+    }
+    // Same model as the shader
+    if (!m_analysisWarpMap || m_analysisWarpMap->isStale(m_cameraParams, m_outputWidth, m_outputHeight, afWarpMapType::UV)){
+        afResourceCache& resourceCache = afResourceCache::getInstance();
+        shared_ptr<afWarpMap> warpMap = resourceCache.acquireWarpMap(m_cameraParams, m_outputWidth, m_outputHeight, afWarpMapType::UV);
+        resourceCache.releaseWarpMap(m_analysisWarpMap);
+        m_analysisWarpMap = warpMap;
+    }
+    return m_analysisWarpMap->getData().data();
 }
 
-void afCameraDistortionPlugin::updateCameraParams()
+void afCameraDistortionPlugin::updateBlackoutMask()
+{
+    if (!m_blackoutMask){
+        return;
+    }
+    const float fullFrame[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    const float* rect = m_tightFrustum ? m_sourceFrustum.getNextRect() : fullFrame;
+    int size[4] = {m_outputWidth, m_outputHeight, m_outputWidth, m_outputHeight};
+    if (m_tightFrustum){
+        size[2] = m_sourceFrustum.getSourceWidth();
+        size[3] = m_sourceFrustum.getSourceHeight();
+    }
+    bool stale = !m_blackoutMaskBuilt || m_blackoutMaskParams != m_cameraParams;
+    for (int i = 0 ; i < 4 ; i++){
+        stale = stale || size[i] != m_blackoutMaskSize[i] || rect[i] != m_blackoutMaskRect[i];
+    }
+    if (!stale){
+        return;
+    }
+    afProfileScope scope(m_profiler, m_stages.blackoutMask);
+    m_blackoutMaskBuilt = true;
+    m_blackoutMaskParams = m_cameraParams;
+    for (int i = 0 ; i < 4 ; i++){
+        m_blackoutMaskSize[i] = size[i];
+        m_blackoutMaskRect[i] = rect[i];
+    }
+
+    // Cells of 8 pixels / texels; a pixel belongs to the cell its center is in, which
+    // is also the cell quad that rasterizes it
+    const int cellSize = 8;
+    afCellGrid visible, sampled;
+    visible.resize((size[0] + cellSize - 1) / cellSize, (size[1] + cellSize - 1) / cellSize);
+    sampled.resize((size[2] + cellSize - 1) / cellSize, (size[3] + cellSize - 1) / cellSize);
+    const float* map = getCpuWarpMap();
+    const float* aberr = m_cameraParams.aberr_scale;
+    for (int y = 0 ; y < m_outputHeight ; y++){
+        for (int x = 0 ; x < m_outputWidth ; x++){
+            const float* texel = map + 4 * ((size_t)y * m_outputWidth + x);
+            // direction maps flag invalid rays with w = 0, warp maps with u < 0
+            if (m_useCubeMap ? texel[3] <= 0.0f : texel[0] < 0.0f){
+                continue;
+            }
+            visible.mark((x + 0.5f) / m_outputWidth, (y + 0.5f) / m_outputHeight);
+            if (m_useCubeMap){
+                continue;
+            }
+            for (int c = 0 ; c < 3 ; c++){
+                float u = texel[0] + (aberr[c] - aberr[1]) * texel[2];
+                float v = texel[1] + (aberr[c] - aberr[1]) * texel[3];
+                sampled.mark((u - rect[0]) * rect[2], (v - rect[1]) * rect[3]);
+            }
+        }
+    }
+
+    // The distortion pass draws only the visible cells, the rest keeps the black background
+    if (m_coverageWorld){
+        // The world deletes the mesh
+        delete m_coverageWorld;
+        m_coverageWorld = nullptr;
+        m_coverageMesh = nullptr;
+    }
+    double visibleFraction = visible.getCoverage();
+    if (visibleFraction < 1.0){
+        m_coverageMesh = afCreateCoverageMesh(visible);
+        m_coverageMesh->setShaderProgram(m_shaderPgm);
+        m_coverageWorld = new cWorld();
+        m_coverageWorld->addChild(m_coverageMesh);
+    }
+
+    // The cube faces are cropped instead
+    if (!m_useCubeMap){
+        // One cell of margin for the bilinear footprint
+        sampled.dilate();
+        if (!m_sceneMask){
+            m_sceneMask = new afHiddenAreaMask();
+            m_sceneMask->setShowEnabled(false);
+            m_sceneMask->attach(m_camera->getInternalCamera()->getParentWorld());
+        }
+        m_sceneMask->setFrameWidth(size[2]);
+        m_sceneMask->build(0, sampled);
+    }
+}
+
+void afCameraDistortionPlugin::updateCubeSource()
+{
+    if (!m_useCubeMap || !m_cubeSource.isStale(m_cameraParams, m_outputWidth, m_outputHeight)){
+        return;
+    }
+    afProfileScope scope(m_profiler, m_stages.cubeSource);
+    m_cubeSource.update(m_camera->getInternalCamera(), m_cameraParams, m_outputWidth, m_outputHeight, m_warpMap->getData().data());
+}
+
+void afCameraDistortionPlugin::onFilesChanged(const vector<string> &a_changedFiles)
 {
-    GLint id = m_shaderPgm->getId();
-    //    cerr << "INFO! Shader ID " << id << endl; // Shader ID is always 1 in my case
-    glUseProgram(id);
-    glUniform1i(glGetUniformLocation(id, "WarpTexture"), 2);
-    glUniform1i(glGetUniformLocation(id, "DistortionType"), static_cast<int>(m_cameraParams.distortion_type));
-    glUniform3fv(glGetUniformLocation(id, "ChromaticAberr"), 1, m_cameraParams.aberr_scale);
-    glUniform2fv(glGetUniformLocation(id, "LensCenter"), 1, m_cameraParams.lens_center);
+    bool configChanged = false;
+    bool shadersChanged = false;
+    for (size_t i = 0 ; i < a_changedFiles.size() ; i++){
+        configChanged = configChanged || a_changedFiles[i] == m_configPath;
+        shadersChanged = shadersChanged || a_changedFiles[i] == m_vertexShader || a_changedFiles[i] == m_fragmentShader;
+    }
+
+    if (shadersChanged){
+        // Compiling needs the GL context, that happens at the frame boundary
+        cerr << "[INFO!] Shaders changed, recompiling at the next frame" << endl;
+        lock_guard<mutex> lock(m_reloadMutex);
+        m_pendingReload.shadersChanged = true;
+    }
+    if (!configChanged){
+        return;
+    }
+
+    cerr << "[INFO!] Reloading configuration file: " << m_configPath << endl;
+    CameraParams params = CameraParams();
+    if (!readCameraParams(m_configPath, params) || !validateCameraParams(params)){
+        cerr << "WARNING! Reloading " << m_configPath << " failed, keeping the current parameters" << endl;
+        return;
+    }
+    camdistort::LensSchedule schedule;
+    if (!readLensSchedule(m_configPath, params, schedule)){
+        cerr << "WARNING! Reloading the keyframes of " << m_configPath << " failed, keeping the current parameters" << endl;
+        return;
+    }
+    camdistort::SensorChain sensorChain;
+    if (!readSensorChain(m_configPath, sensorChain)){
+        cerr << "WARNING! Reloading the sensor stages of " << m_configPath << " failed, keeping the current parameters" << endl;
+        return;
+    }
+    if (!schedule.empty()){
+        lock_guard<mutex> lock(m_lensMutex);
+        params = schedule.evaluate(m_lensSetting[0], m_lensSetting[1], m_lensSteps);
+    }
 
-    GLfloat center[] = {m_cameraParams.cx, m_cameraParams.cy};
-    glUniform2fv(glGetUniformLocation(id, "Center"), 1, center); 
+    int size[2];
+    {
+        lock_guard<mutex> lock(m_reloadMutex);
+        size[0] = m_reloadOutputSize[0];
+        size[1] = m_reloadOutputSize[1];
+    }
+    if (m_headless || m_presentBlit){
+        size[0] = static_cast<int>(params.width);
+        size[1] = static_cast<int>(params.height);
+    }
 
-    GLfloat focal_length[] = {m_cameraParams.fx, m_cameraParams.fy};
-    glUniform2fv(glGetUniformLocation(id, "FocalLength"), 1, focal_length); 
+    // The heavy part, the maps the new params need, is built here on a pool of its
+    // own so that the render thread never waits for it
+    if (!m_reloadPool){
+        m_reloadPool.reset(new camdistort::ThreadPool(max(1, (int)thread::hardware_concurrency() / 2)));
+    }
+    shared_ptr<afWarpMap> warpMap;
+    vector<float> analysisMap;
+    afWarpMapType type = getWarpMapType(params);
+    if (m_useCubeMap || m_warpMapRequested || params.inverse || type == afWarpMapType::REMAP){
+        warpMap = make_shared<afWarpMap>();
+        if (!warpMap->build(params, size[0], size[1], type, m_reloadPool.get())){
+            cerr << "WARNING! Building the warp map of " << m_configPath << " failed, keeping the current parameters" << endl;
+            return;
+        }
+    }
+    // A remap keeps no CPU lookup, the analyses need one
+    if ((!warpMap || type == afWarpMapType::REMAP) && (m_tightFrustum || m_blackoutMask)){
+        camdistort::WarpMapOptions options;
+        options.pool = m_reloadPool.get();
+        analysisMap.resize(4 * (size_t)size[0] * size[1]);
+        camdistort::buildWarpMap(params, size[0], size[1], analysisMap.data(), options);
+    }
 
-    GLfloat image_size[] = {m_cameraParams.width, m_cameraParams.height};
-    glUniform2fv(glGetUniformLocation(id, "ImageSize"), 1, image_size); 
+    lock_guard<mutex> lock(m_reloadMutex);
+    m_pendingReload.hasParams = true;
+    m_pendingReload.params = params;
+    m_pendingReload.schedule = schedule;
+    m_pendingReload.sensorChain = sensorChain;
+    m_pendingReload.warpMap = warpMap;
+    m_pendingReload.analysisMap.swap(analysisMap);
+    m_pendingReload.analysisSize[0] = size[0];
+    m_pendingReload.analysisSize[1] = size[1];
+}
+
+void afCameraDistortionPlugin::applyPendingReload()
+{
+    bool hasParams, shadersChanged;
+    CameraParams params;
+    shared_ptr<afWarpMap> warpMap;
+    {
+        lock_guard<mutex> lock(m_reloadMutex);
+        m_reloadOutputSize[0] = m_outputWidth;
+        m_reloadOutputSize[1] = m_outputHeight;
+        hasParams = m_pendingReload.hasParams;
+        shadersChanged = m_pendingReload.shadersChanged;
+        if (!hasParams && !shadersChanged){
+            return;
+        }
+        params = m_pendingReload.params;
+        if (hasParams){
+            m_lensSchedule = m_pendingReload.schedule;
+            // Takes effect through the next updateShaderVariant()
+            m_sensorChain = m_pendingReload.sensorChain;
+        }
+        warpMap.swap(m_pendingReload.warpMap);
+        if (hasParams && m_pendingReload.analysisSize[0] == m_outputWidth && m_pendingReload.analysisSize[1] == m_outputHeight){
+            m_analysisMap.swap(m_pendingReload.analysisMap);
+        }
+        vector<float>().swap(m_pendingReload.analysisMap);
+        m_pendingReload.hasParams = false;
+        m_pendingReload.shadersChanged = false;
+    }
+    m_paramsVersion++;
+
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    if (shadersChanged){
+        // Only the current variant, the others are compiled from the new files when next needed
+        cShaderProgramPtr program = resourceCache.reloadProgram(m_shaderPgm, m_vertexShader, m_fragmentShader, "CameraDistortion",
+                                                                m_shaderDefines);
+        if (!program){
+            cerr << "WARNING! Recompiling " << m_vertexShader << " / " << m_fragmentShader << " failed, keeping the current program" << endl;
+        }
+        else{
+            // reloadProgram() already dropped our reference to the old program
+            setShaderProgram(program);
+            cerr << "[INFO!] Shaders reloaded" << endl;
+        }
+    }
 
-    GLfloat window_size[] = {static_cast<float>(m_camera->m_width), static_cast<float>(m_camera->m_height)};
-    glUniform2fv(glGetUniformLocation(id, "WindowSize"), 1, window_size); 
+    if (hasParams){
+        m_cameraParams = params;
+        // The setting may have moved since the worker evaluated the new keyframes
+        if (!m_lensSchedule.empty()){
+            lock_guard<mutex> lock(m_lensMutex);
+            m_lensSettingChanged = true;
+        }
+        if (!m_useCubeMap){
+            m_useWarpMap = m_warpMapRequested || m_cameraParams.inverse || m_cameraParams.distortion_type == DistortionType::REMAP;
+        }
+        if (warpMap){
+            // Uploaded here, the rest of the frame finds it in the cache
+            afWarpMapType type = getWarpMapType(m_cameraParams);
+            shared_ptr<afWarpMap> acquired = resourceCache.acquireWarpMap(m_cameraParams, warpMap->getWidth(), warpMap->getHeight(), type, warpMap);
+            if (acquired){
+                resourceCache.releaseWarpMap(m_warpMap);
+                m_warpMap = acquired;
+            }
+        }
+        else if (!m_useWarpMap && !m_useCubeMap && m_warpMap){
+            resourceCache.releaseWarpMap(m_warpMap);
+            m_warpMap.reset();
+        }
+        cerr << "[INFO!] Configuration reloaded" << endl;
+    }
+}
 
-    glUniform4fv(glGetUniformLocation(id, "RadialDistortion"), 1, m_cameraParams.radial_distortion_coeffs);
-    glUniform2fv(glGetUniformLocation(id, "TangentialDistortion"), 1, m_cameraParams.tangential_distortion_coeffs);
+string afCameraDistortionPlugin::getShaderDefines(const CameraParams &a_params) const
+{
+    // The sensor stages exist only as generated code, even the generic program needs them
+    string sensorDefines = camdistort::getSensorChainDefines(m_sensorChain);
+    if (!m_shaderVariants){
+        return sensorDefines;
+    }
+    return camdistort::getShaderDefines(a_params) + "#define ROLLING_SHUTTER " + (m_rollingShutter.isEnabled() ? "1" : "0") + "\n"
+           "#define FILTERED_SAMPLING " + (m_sceneMipmaps ? "1" : "0") + "\n" + sensorDefines;
+}
 
-    glUniform1i(glGetUniformLocation(id, "Blackout"), m_cameraParams.blackout); 
+void afCameraDistortionPlugin::updateShaderVariant()
+{
+    string defines = getShaderDefines(m_cameraParams);
+    if (defines == m_shaderDefines){
+        return;
+    }
+    // Compiled on first use, cached with the other cameras' variants afterwards
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    cShaderProgramPtr program = resourceCache.acquireProgram(m_vertexShader, m_fragmentShader, "CameraDistortion", defines);
+    // The current program has the old model compiled in, the generic one reads it from
+    // the DistortionType uniform. As in init, variants stay off once one failed.
+    if (!program && m_shaderVariants){
+        cerr << "WARNING! Falling back to the generic distortion program" << endl;
+        m_shaderVariants = false;
+        defines = getShaderDefines(m_cameraParams);
+        program = resourceCache.acquireProgram(m_vertexShader, m_fragmentShader, "CameraDistortion", defines);
+    }
+    // Not retried every frame
+    m_shaderDefines = defines;
+    if (!program){
+        cerr << "ERROR! Compiling the generic distortion program failed, keeping the current program" << endl;
+        return;
+    }
+    resourceCache.releaseProgram(m_shaderPgm);
+    setShaderProgram(program);
+}
+
+void afCameraDistortionPlugin::setShaderProgram(const cShaderProgramPtr &a_program)
+{
+    // The quad world is cached per program
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    resourceCache.releaseQuadWorld(m_quadWorld);
+    m_shaderPgm = a_program;
+    m_quadWorld = resourceCache.acquireQuadWorld(m_shaderPgm);
+    m_quadMesh = m_quadWorld.m_quadMesh;
+    m_distortedWorld = m_quadWorld.m_world;
+    if (m_coverageMesh){
+        m_coverageMesh->setShaderProgram(m_shaderPgm);
+    }
+    m_shaderParams.setProgram(m_shaderPgm->getId());
+}
+
+void afCameraDistortionPlugin::setLensSetting(float a_zoom, float a_focus)
+{
+    lock_guard<mutex> lock(m_lensMutex);
+    if (a_zoom != m_lensSetting[0] || a_focus != m_lensSetting[1]){
+        m_lensSetting[0] = a_zoom;
+        m_lensSetting[1] = a_focus;
+        m_lensSettingChanged = true;
+    }
+}
+
+void afCameraDistortionPlugin::updateLensSetting()
+{
+    if (m_lensSchedule.empty()){
+        return;
+    }
+    float zoom, focus;
+    {
+        lock_guard<mutex> lock(m_lensMutex);
+        if (!m_lensSettingChanged){
+            return;
+        }
+        m_lensSettingChanged = false;
+        zoom = m_lensSetting[0];
+        focus = m_lensSetting[1];
+    }
+    // Rounded to m_lensSteps, the warp map of a revisited setting is still in the cache
+    m_cameraParams = m_lensSchedule.evaluate(zoom, focus, m_lensSteps);
+    m_paramsVersion++;
+}
+
+void afCameraDistortionPlugin::renderOffscreen()
+{
+    cCamera* camera = m_camera->getInternalCamera();
+
+    // Temporarily switch camera to Distorted world
+    cWorld* cachedWorld = camera->getParentWorld();
+    camera->setStereoMode(C_STEREO_DISABLED);
+    camera->setParentWorld(m_coverageWorld ? m_coverageWorld : m_distortedWorld);
+    cWorld* frontLayer = camera->m_frontLayer;
+    camera->m_frontLayer = m_emptyWorld;
+
+    m_shaderParams.setInt(m_uniforms.writeDepth, m_readbackRing.getCaptureDepth());
+    renderOutput(m_outputTarget, m_outputWidth, m_outputHeight, m_readback ? &m_readbackRing : nullptr);
+    // The lens model is resolution independent, only the size the shader maps to changes
+    for (size_t i = 0 ; i < m_extraOutputs.size() ; i++){
+        afExtraOutput &output = *m_extraOutputs[i];
+        m_shaderParams.setVec2(m_uniforms.windowSize, static_cast<float>(output.m_width), static_cast<float>(output.m_height));
+        renderOutput(output.m_target, output.m_width, output.m_height, m_readback ? &output.m_readbackRing : nullptr);
+    }
+    m_shaderParams.setVec2(m_uniforms.windowSize, static_cast<float>(m_outputWidth), static_cast<float>(m_outputHeight));
+    m_shaderParams.setInt(m_uniforms.writeDepth, false);
+    m_shaderParams.upload();
+    m_frameIndex++;
+
+    camera->m_frontLayer = frontLayer;
+    camera->setParentWorld(cachedWorld);
+}
+
+void afCameraDistortionPlugin::renderOutput(afOffscreenTarget &a_target, int a_width, int a_height, afReadbackRing* a_readbackRing)
+{
+    // The linear depth goes to a second target in the same draw
+    vector<GLint> formats(1, GL_RGBA8);
+    if (m_readbackRing.getCaptureDepth()){
+        formats.push_back(GL_R32F);
+    }
+    if (!a_target.setup(a_width, a_height, formats)){
+        return;
+    }
+
+    // Draw into the offscreen target instead of the window, not tied to the display refresh
+    a_target.bind();
+    m_shaderParams.upload();
+    m_camera->getInternalCamera()->renderView(a_width, a_height, C_STEREO_LEFT_EYE, false);
+    if (a_readbackRing){
+        a_readbackRing->readback(a_width, a_height, m_frameIndex, m_camera->m_afWorld->getSimulationTime(), cameraParamsHash(m_cameraParams));
+    }
+    a_target.unbind();
+}
+
+void afCameraDistortionPlugin::presentOutput()
+{
+    // Nothing to show, the frame was still rendered and read back
+    GLFWwindow* window = m_camera->m_window;
+    if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE)){
+        return;
+    }
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    m_outputTarget.blitToWindow(width, height);
+    glfwSwapBuffers(window);
+}
+
+void afCameraDistortionPlugin::reuseFrame()
+{
+    // The outputs keep the last frame, readback and publishing only see new ones
+    if (m_headless){
+        return;
+    }
+    if (m_presentBlit){
+        presentOutput();
+        return;
+    }
+    // The window has no copy of the last frame, draw it again from the scene texture of
+    // the last scene pass
+    m_quadMesh->m_texture = m_frameBuffer->m_imageBuffer;
+    if (m_coverageMesh){
+        m_coverageMesh->m_texture = m_frameBuffer->m_imageBuffer;
+    }
+    renderDirect();
+}
+
+void afCameraDistortionPlugin::onFrameReady(afFrame &a_frame, shmring::Writer &a_shmWriter, bool &a_shmWarned, afFrameWriter &a_frameWriter)
+{
+    // Published straight from the mapped readback buffers
+    if (a_shmWriter.isOpen()){
+        shmring::PixelFormat format = a_frame.m_mappedDepth ? shmring::PixelFormat::RGBA8_DEPTH32F : shmring::PixelFormat::RGBA8;
+        if (!a_shmWriter.publish(a_frame.m_width, a_frame.m_height, format, a_frame.m_index, a_frame.m_simTime,
+                                 a_frame.m_paramsHash, a_frame.m_mappedRgba, a_frame.m_mappedDepth)){
+            if (!a_shmWarned){
+                cerr << "WARNING! Frame of [" << a_frame.m_width << "x" << a_frame.m_height << "] does not fit the shared memory slots, not published" << endl;
+                a_shmWarned = true;
+            }
+        }
+    }
+    // The writer keeps the frame past the mapping
+    if (a_frameWriter.isRunning()){
+        a_frame.retain();
+        a_frameWriter.write(std::move(a_frame));
+    }
+}
+
+void afCameraDistortionPlugin::physicsUpdate(double dt)
+{
+
+}
+
+void afCameraDistortionPlugin::reset(){
+    m_updateGate.invalidate();
+}
+
+bool afCameraDistortionPlugin::close()
+{
+    glfwMakeContextCurrent(m_camera->m_window);
+    m_fileWatcher.stop();
+    m_profiler.disable();
+    if (m_updateGate.isEnabled()){
+        cerr << "[INFO!] " << m_camera->getName() << ": rendered " << m_updateGate.getRenderedFrames() << " frames, reused "
+             << m_updateGate.getSkippedFrames() << endl;
+    }
+    m_readbackRing.flush();
+    m_readbackRing.destroy();
+    m_frameWriter.stop();
+    m_shmWriter.close();
+    for (size_t i = 0 ; i < m_extraOutputs.size() ; i++){
+        afExtraOutput &output = *m_extraOutputs[i];
+        output.m_readbackRing.flush();
+        output.m_readbackRing.destroy();
+        output.m_frameWriter.stop();
+        output.m_shmWriter.close();
+        output.m_target.destroy();
+    }
+    m_extraOutputs.clear();
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    resourceCache.releaseWarpMap(m_warpMap);
+    m_warpMap.reset();
+    resourceCache.releaseWarpMap(m_analysisWarpMap);
+    m_analysisWarpMap.reset();
+    resourceCache.releaseUnusedWarpMaps(m_warpMapCacheSize);
+    m_cubeSource.destroy();
+    if (m_sceneMask){
+        m_sceneMask->detach();
+        delete m_sceneMask;
+        m_sceneMask = nullptr;
+    }
+    if (m_coverageWorld){
+        delete m_coverageWorld;
+        m_coverageWorld = nullptr;
+        m_coverageMesh = nullptr;
+    }
+    resourceCache.releaseQuadWorld(m_quadWorld);
+    if (m_emptyWorld){
+        resourceCache.releaseEmptyWorld();
+        m_emptyWorld = nullptr;
+    }
+    resourceCache.releaseProgram(m_shaderPgm);
+    m_outputTarget.destroy();
+    m_frameBufferManager.clear();
+    return true;
+}
+
+void afCameraDistortionPlugin::registerUniforms()
+{
+    m_uniforms.warpTexture = m_shaderParams.addUniform("WarpTexture", afUniformType::INT);
+    m_uniforms.distortionType = m_shaderParams.addUniform("DistortionType", afUniformType::INT);
+    m_uniforms.chromaticAberr = m_shaderParams.addUniform("ChromaticAberr", afUniformType::VEC3);
+    m_uniforms.lensCenter = m_shaderParams.addUniform("LensCenter", afUniformType::VEC2);
+    m_uniforms.center = m_shaderParams.addUniform("Center", afUniformType::VEC2);
+    m_uniforms.focalLength = m_shaderParams.addUniform("FocalLength", afUniformType::VEC2);
+    m_uniforms.imageSize = m_shaderParams.addUniform("ImageSize", afUniformType::VEC2);
+    m_uniforms.windowSize = m_shaderParams.addUniform("WindowSize", afUniformType::VEC2);
+    m_uniforms.radialDistortion = m_shaderParams.addUniform("RadialDistortion", afUniformType::VEC4);
+    m_uniforms.tangentialDistortion = m_shaderParams.addUniform("TangentialDistortion", afUniformType::VEC2);
+    m_uniforms.rationalDistortion = m_shaderParams.addUniform("RationalDistortion", afUniformType::VEC3);
+    m_uniforms.thinPrism = m_shaderParams.addUniform("ThinPrism", afUniformType::VEC4);
+    for (int i = 0 ; i < 3 ; i++){
+        m_uniforms.tiltMatrix[i] = m_shaderParams.addUniform("TiltMatrix[" + to_string(i) + "]", afUniformType::VEC3);
+    }
+    m_uniforms.blackout = m_shaderParams.addUniform("Blackout", afUniformType::INT);
+    m_uniforms.warpMap = m_shaderParams.addUniform("WarpMap", afUniformType::INT);
+    m_uniforms.useWarpMap = m_shaderParams.addUniform("UseWarpMap", afUniformType::INT);
+    m_uniforms.depthTexture = m_shaderParams.addUniform("DepthTexture", afUniformType::INT);
+    m_uniforms.writeDepth = m_shaderParams.addUniform("WriteDepth", afUniformType::INT);
+    m_uniforms.depthRange = m_shaderParams.addUniform("DepthRange", afUniformType::VEC2);
+    m_uniforms.depthFilterMin = m_shaderParams.addUniform("DepthFilterMin", afUniformType::INT);
+    m_uniforms.depthTextureSize = m_shaderParams.addUniform("DepthTextureSize", afUniformType::VEC2);
+    m_uniforms.rollingShutter = m_shaderParams.addUniform("RollingShutter", afUniformType::INT);
+    m_uniforms.readoutTime = m_shaderParams.addUniform("ReadoutTime", afUniformType::FLOAT);
+    m_uniforms.exposureTime = m_shaderParams.addUniform("ExposureTime", afUniformType::FLOAT);
+    m_uniforms.shutterSamples = m_shaderParams.addUniform("ShutterSamples", afUniformType::INT);
+    m_uniforms.cameraVelocity = m_shaderParams.addUniform("CameraVelocity", afUniformType::VEC3);
+    m_uniforms.cameraAngularVelocity = m_shaderParams.addUniform("CameraAngularVelocity", afUniformType::VEC3);
+    m_uniforms.sensorSeed = m_shaderParams.addUniform("SensorSeed", afUniformType::VEC2);
+    m_uniforms.sourceRect = m_shaderParams.addUniform("SourceRect", afUniformType::VEC4);
+    m_uniforms.useCubeMap = m_shaderParams.addUniform("UseCubeMap", afUniformType::INT);
+    m_uniforms.useRemap = m_shaderParams.addUniform("UseRemap", afUniformType::INT);
+    m_uniforms.remapOffsets = m_shaderParams.addUniform("RemapOffsets", afUniformType::INT);
+    m_uniforms.remapSourceSize = m_shaderParams.addUniform("RemapSourceSize", afUniformType::VEC2);
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        m_uniforms.cubeFaces[f] = m_shaderParams.addUniform("CubeFace" + to_string(f), afUniformType::INT);
+        m_uniforms.cubeRects[f] = m_shaderParams.addUniform("CubeRect[" + to_string(f) + "]", afUniformType::VEC4);
+    }
+    m_shaderParams.setProgram(m_shaderPgm->getId());
+}
+
+void afCameraDistortionPlugin::updateCameraParams()
+{
+    // Only the values that changed since the last frame are sent to the driver
+    m_shaderParams.setInt(m_uniforms.warpTexture, 2);
+    m_shaderParams.setInt(m_uniforms.distortionType, static_cast<int>(m_cameraParams.distortion_type));
+    m_shaderParams.setVec(m_uniforms.chromaticAberr, m_cameraParams.aberr_scale);
+    m_shaderParams.setVec(m_uniforms.lensCenter, m_cameraParams.lens_center);
+    m_shaderParams.setVec2(m_uniforms.center, m_cameraParams.cx, m_cameraParams.cy);
+    m_shaderParams.setVec2(m_uniforms.focalLength, m_cameraParams.fx, m_cameraParams.fy);
+    m_shaderParams.setVec2(m_uniforms.imageSize, m_cameraParams.width, m_cameraParams.height);
+    m_shaderParams.setVec2(m_uniforms.windowSize, static_cast<float>(m_outputWidth), static_cast<float>(m_outputHeight));
+    m_shaderParams.setVec(m_uniforms.radialDistortion, m_cameraParams.radial_distortion_coeffs);
+    m_shaderParams.setVec(m_uniforms.tangentialDistortion, m_cameraParams.tangential_distortion_coeffs);
+    m_shaderParams.setVec(m_uniforms.rationalDistortion, m_cameraParams.rational_distortion_coeffs);
+    m_shaderParams.setVec(m_uniforms.thinPrism, m_cameraParams.thin_prism_coeffs);
+    double tilt[9];
+    camdistort::computeTiltMatrix(m_cameraParams.tilt[0], m_cameraParams.tilt[1], tilt);
+    for (int i = 0 ; i < 3 ; i++){
+        const float row[3] = {static_cast<float>(tilt[3 * i]), static_cast<float>(tilt[3 * i + 1]), static_cast<float>(tilt[3 * i + 2])};
+        m_shaderParams.setVec(m_uniforms.tiltMatrix[i], row);
+    }
+    m_shaderParams.setInt(m_uniforms.blackout, m_cameraParams.blackout);
+    m_shaderParams.setInt(m_uniforms.warpMap, 3);
+    m_shaderParams.setInt(m_uniforms.depthTexture, 4);
+    // Only the offscreen pass writes depth, see renderOffscreen
+    m_shaderParams.setInt(m_uniforms.writeDepth, false);
+    cCamera* camera = m_camera->getInternalCamera();
+    m_shaderParams.setVec2(m_uniforms.depthRange, static_cast<float>(camera->getNearClippingPlane()),
+                           static_cast<float>(camera->getFarClippingPlane()));
+    m_shaderParams.setInt(m_uniforms.depthFilterMin, m_depthFilterMin);
+    m_shaderParams.setInt(m_uniforms.rollingShutter, m_rollingShutter.isEnabled());
+    m_shaderParams.setFloat(m_uniforms.readoutTime, m_rollingShutter.getReadoutTime());
+    m_shaderParams.setFloat(m_uniforms.exposureTime, m_rollingShutter.getExposureTime());
+    m_shaderParams.setInt(m_uniforms.shutterSamples, m_rollingShutter.getSamples());
+    m_shaderParams.setVec(m_uniforms.cameraVelocity, m_rollingShutter.getLinearVelocity());
+    m_shaderParams.setVec(m_uniforms.cameraAngularVelocity, m_rollingShutter.getAngularVelocity());
+    // Region the current scene texture was rendered with
+    m_shaderParams.setVec(m_uniforms.sourceRect, m_sourceFrustum.getRect());
+    m_shaderParams.setInt(m_uniforms.useCubeMap, m_useCubeMap);
+    updateWarpMapUniforms();
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        m_shaderParams.setInt(m_uniforms.cubeFaces[f], 5 + f);
+        m_shaderParams.setVec(m_uniforms.cubeRects[f], m_cubeSource.getRect(f));
+    }
+    m_shaderParams.upload();
+}
+
+void afCameraDistortionPlugin::updateWarpMapUniforms()
+{
+    // The bound map lags behind the params when the last build failed, a remap is
+    // sampled as stored and the shader adds back the offsets
+    bool useWarpMap = m_useWarpMap && m_warpMap;
+    bool useRemap = useWarpMap && m_warpMap->getType() == afWarpMapType::REMAP;
+    m_shaderParams.setInt(m_uniforms.useWarpMap, useWarpMap);
+    m_shaderParams.setInt(m_uniforms.useRemap, useRemap);
+    if (useRemap){
+        m_shaderParams.setInt(m_uniforms.remapOffsets, m_warpMap->getRemapFormat() == camdistort::RemapFormat::FLOAT16_OFFSET);
+        m_shaderParams.setVec2(m_uniforms.remapSourceSize, static_cast<float>(m_warpMap->getRemapSourceWidth()),
+                               static_cast<float>(m_warpMap->getRemapSourceHeight()));
+    }
 }
 
 void afCameraDistortionPlugin::makeFullScreen()
@@ -262,145 +1358,3 @@ void afCameraDistortionPlugin::changeScreenSize(int w, int h)
     glfwSwapInterval(0);
     cerr << "\t Making " << m_camera->getName() << " fullscreen \n" ;
 }
-
-// Function to read YAML file and extract camera parameters
-int afCameraDistortionPlugin::readCameraParams(const string &filename, CameraParams &params) {
-    try {
-        YAML::Node config = YAML::LoadFile(filename);
-
-        // Read camera type
-        if (!config["type"] || !config["type"].IsScalar()) {
-            cerr << "Error: Missing or invalid 'type' field." << endl;
-            return 0;
-        }
-        if (config["type"].as<string>() == "pinhole"){
-            params.distortion_type = DistortionType::PINHOLE;
-            cout << "distortion_type: PINHOLE " << static_cast<int>(DistortionType::PINHOLE)<< endl;
-        }
-        else if (config["type"].as<string>() == "fisheye"){
-            params.distortion_type = DistortionType::FISHEYE;
-            cout << "distortion_type: FISHEYE " << static_cast<int>(DistortionType::FISHEYE)<< endl;
-        }
-        else if (config["type"].as<string>() == "panotool"){
-            params.distortion_type = DistortionType::PANOTOOL;
-            cout << "distortion_type: PANOTOOL " << static_cast<int>(DistortionType::PANOTOOL)<< endl;
-        }
-
-        // Read intrinsic parameters
-        if (!config["intrinsic"] || !config["intrinsic"].IsMap()) {
-            cerr << "Error: Missing or invalid 'intrinsic' field." << endl;
-            return 0;
-        }
-
-        try {
-            params.fx = config["intrinsic"]["fx"].as<double>();
-            params.fy = config["intrinsic"]["fy"].as<double>();
-            params.cx = config["intrinsic"]["cx"].as<double>();
-            params.cy = config["intrinsic"]["cy"].as<double>();
-
-
-            if (config["image_size"]){
-                params.width = config["image_size"].as<vector<double>>()[0];
-                params.height = config["image_size"].as<vector<double>>()[1];
-                params.lens_center[0] = params.cx/params.width;
-                params.lens_center[1] = params.cy/params.height;
-
-                cout << "image_size: [" << params.width << "," << params.height << ']' << endl;
-                cout << "len center: [" << params.lens_center[0]  << "," << params.lens_center[1] << ']' << endl;
-            }  
-
-            else{
-                params.lens_center[0] = 0.5;
-                params.lens_center[1] = 0.5;
-            }
-
-
-        } catch (const YAML::Exception &e) {
-            cerr << "Error reading intrinsic parameters: " << e.what() << endl;
-            return 0;
-        }
-
-        // Read radial distortion coefficients
-        if (!config["radial_distortion_coeffs"] || !config["radial_distortion_coeffs"].IsSequence()) {
-            cerr << "[CAUTION!] Missing or invalid 'radial distortion_coeffs' field." << endl;
-            for (size_t i = 0 ; i < 4; i++){
-                params.radial_distortion_coeffs[i] = 0.0;
-            }
-        }
-
-        else{
-            for (size_t i = 0 ; i < 4; i++) {
-                params.radial_distortion_coeffs[i] = config["radial_distortion_coeffs"].as<vector<float>>()[i];
-            }
-        }
-
-        // Read tangential distortion coefficients
-        if (!config["tangential_distortion_coeffs"] || !config["tangential_distortion_coeffs"].IsSequence()) {
-            cerr << "[CAUTION!] Missing or invalid 'tangential distortion_coeffs' field." << endl;
-            for (size_t i = 0 ; i < 2; i++){
-                params.tangential_distortion_coeffs[i] = 0.0;
-            }
-        }
-
-        else{
-            for (size_t i = 0 ; i < 2; i++) {
-                params.tangential_distortion_coeffs[i] = config["tangential_distortion_coeffs"].as<vector<float>>()[i];
-            }
-        }
-
-        cerr << "Distortion Coefficient:" << endl;
-        cerr << "Radial: " << 
-                m_cameraParams.radial_distortion_coeffs[0] << "," << 
-                m_cameraParams.radial_distortion_coeffs[1] << "," << 
-                m_cameraParams.radial_distortion_coeffs[2] << "," << 
-                m_cameraParams.radial_distortion_coeffs[3] << endl;
-
-        cerr << "Tangential: " << 
-                m_cameraParams.tangential_distortion_coeffs[0] << "," << 
-                m_cameraParams.tangential_distortion_coeffs[1] << endl;
-
-
-        // Read chromatic distortion coefficient
-        if (!config["chromatic_distortion"] || !config["chromatic_distortion"].IsSequence()) {
-            cerr << "[CAUTION!] Missing or invalid 'chromatic_distortion' field." << endl;
-            for (size_t i = 0 ; i < 3; i++){
-                params.aberr_scale[i] = 1.0;
-            }
-        }
-    
-        else{
-            for (size_t i = 0 ; i < 3; i++) {
-                params.aberr_scale[i] = config["chromatic_distortion"].as<vector<float>>()[i];
-            }
-        }
-
-        cerr << "Chromatic distortion Coefficient:" <<
-                m_cameraParams.aberr_scale[0] << "," << 
-                m_cameraParams.aberr_scale[1] << "," << 
-                m_cameraParams.aberr_scale[2] << endl;
-
-        // Whether to overlay blackout except for circular viewing region
-        if (!config["blackout"]) {
-            cerr << "[CAUTION!] Missing or invalid 'blackout' field." << endl;
-            params.blackout = false;
-        } else {
-            params.blackout = config["blackout"].as<bool>();
-        }
-
-        cerr << "Blackout: " << 
-                m_cameraParams.blackout << endl;
-
-        // Validate coefficient count based on type
-        // if ((params.camera_type == "fisheye" && params.distortion_coefs.size() != 4) ||
-        //     (params.camera_type == "pinhole" && params.distortion_coefs.size() != 5)) {
-        //     cerr << "Error: Incorrect number of distortion coefficients for " << params.camera_type << " camera." << endl;
-        //     return 0;
-        // }
-
-        return 1;
-    } catch (const YAML::Exception &e) {
-        cerr << "YAML parse error: " << e.what() << endl;
-        return 0;
-    }
-}
-
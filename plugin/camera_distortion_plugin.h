@@ -44,28 +44,39 @@
 #define GL_SILENCE_DEPRECATION
 #include <afFramework.h>
 #include <yaml-cpp/yaml.h>
+#include "camera_params.h"
+#include "camera_params_yaml.h"
+#include "warp_map.h"
+#include "shader_params.h"
+#include "framebuffer_manager.h"
+#include "offscreen_target.h"
+#include "frame_writer.h"
+#include "readback_ring.h"
+#include "shm_ring.h"
+#include "pass_profiler.h"
+#include "resource_cache.h"
+#include "source_frustum.h"
+#include "cube_source.h"
+#include "hidden_area_mask.h"
+#include "file_watcher.h"
+#include "rolling_shutter.h"
+#include "update_gate.h"
 
 
 using namespace std;
 using namespace ambf;
 
-// Define an enum for camera types
-enum class DistortionType {
-    PINHOLE,
-    FISHEYE,
-    PANOTOOL,
-};
-
-// Struct to store camera parameters
-struct CameraParams {
-    DistortionType distortion_type;
-    float width, height;
-    float fx, fy, cx, cy;
-    float radial_distortion_coeffs[4];
-    float tangential_distortion_coeffs[2];
-    float aberr_scale[3];
-    float lens_center[2];
-    bool blackout;
+// Additional resolution of the distorted image, rendered by its own distortion pass
+// and published next to the image_size frames (see extra_outputs)
+struct afExtraOutput{
+    int m_width;
+    int m_height;
+    afOffscreenTarget m_target;
+    afReadbackRing m_readbackRing;
+    afFrameWriter m_frameWriter;
+    shmring::Writer m_shmWriter;
+    // A frame that did not fit the slots was reported
+    bool m_shmWarned = false;
 };
 
 class afCameraDistortionPlugin: public afObjectPlugin{
@@ -77,24 +88,232 @@ public:
     virtual void reset() override;
     virtual bool close() override;
 
+    void registerUniforms();
     void updateCameraParams();
 
+    // Lookup mode of the shader, from the map actually bound rather than the params
+    void updateWarpMapUniforms();
+
+    // Preprocessor defines of the shader variant specialized for a_params, see
+    // camdistort::getShaderDefines(). Only the sensor stages when shader_variants is off.
+    string getShaderDefines(const CameraParams &a_params) const;
+
+    // Switch to the program variant of m_cameraParams when its defines changed
+    void updateShaderVariant();
+
+    // Make a_program the one the quad, the coverage mesh and the uniforms use
+    void setShaderProgram(const cShaderProgramPtr &a_program);
+
+    // Zoom / focus of a lens calibrated at several settings ('keyframes' in the
+    // distortion config). Thread safe, the interpolated calibration is applied at
+    // the next frame. No effect without keyframes.
+    void setLensSetting(float a_zoom, float a_focus);
+    bool hasLensSchedule() const { return !m_lensSchedule.empty(); }
+
+    // Re-evaluate m_cameraParams from m_lensSchedule when the setting changed
+    void updateLensSetting();
+
+    // Regenerate the mip pyramid of the scene texture after the scene pass
+    void updateSceneMipmaps();
+
+    // Size the distortion pass renders at: image_size, or the window with present: direct
+    void updateOutputSize();
+
+    // Re-derive the tight scene frustum when the params or the output size changed
+    void updateSourceFrustum();
+
+    // Rebuild the direction map and the cube faces when the params or the output size changed
+    void updateCubeSource();
+
+    // Rebuild the masks of the pixels and texels the distortion never shows
+    void updateBlackoutMask();
+
+    // What m_warpMap holds for a_params: directions for the cube faces, the file of
+    // a remap, or source coordinates
+    afWarpMapType getWarpMapType(const CameraParams &a_params) const;
+
+    // CPU copy of the current warp (or direction) map, built on demand for the
+    // analyses when the shader evaluates the model itself or samples a remap
+    const float* getCpuWarpMap();
+
+    // Distortion pass into m_outputTarget and the extra outputs instead of the window
+    void renderOffscreen();
+
+    // One distortion pass into a_target at a_width x a_height, read back when a_readbackRing is given
+    void renderOutput(afOffscreenTarget &a_target, int a_width, int a_height, afReadbackRing* a_readbackRing);
+
+    // Scale the image_size frame into the window, skipped while the window is hidden
+    void presentOutput();
+
+    // Distortion pass of the scene texture into the window, with present: direct
+    void renderDirect();
+
+    // Show the last frame again at a tick the update gate skipped
+    void reuseFrame();
+
+    // Called by the readback rings on the render thread for every finished frame.
+    // a_shmWarned is the oversized frame warning of that output, given once.
+    void onFrameReady(afFrame &a_frame, shmring::Writer &a_shmWriter, bool &a_shmWarned, afFrameWriter &a_frameWriter);
+
+    // Worker thread of m_fileWatcher: parse, validate and prebuild the maps of the
+    // changed config, check the changed shaders
+    void onFilesChanged(const vector<string> &a_changedFiles);
+
+    // Swap in what the worker prepared, called at the start of a frame
+    void applyPendingReload();
+
     void makeFullScreen();
     void changeScreenSize(int w, int h);
 
-    int readCameraParams(const string &filename, CameraParams &params);
+    // Rolling per-stage statistics, see afPassProfiler::getStats()
+    afPassProfiler& getProfiler() { return m_profiler; }
 
 protected:
     afCameraPtr m_camera;
     string m_current_filepath;
     cFrameBufferPtr m_frameBuffer;
+    afFrameBufferManager m_frameBufferManager;
+    // Shared with the other cameras through afResourceCache
+    afQuadWorld m_quadWorld;
     cWorld* m_distortedWorld;
+    cWorld* m_emptyWorld;
     cMesh* m_quadMesh;
     // int m_windowWidth;
     // int m_windowHeight;
     cShaderProgramPtr m_shaderPgm;
+    // Specialized programs per lens model instead of the generic one, and the
+    // defines m_shaderPgm was built with
+    bool m_shaderVariants;
+    string m_shaderDefines;
     int m_distortion_type;
     CameraParams m_cameraParams;
+
+    // Precomputed source UV lookup instead of evaluating the model per fragment
+    bool m_useWarpMap;
+    shared_ptr<afWarpMap> m_warpMap;
+    // Set when the map of m_paramsVersion m_warpMapFailedVersion could not be built. It
+    // is not retried before the params change, the last good map or the model is used.
+    bool m_warpMapFailed;
+    unsigned long m_warpMapFailedVersion;
+
+    // Cached uniform locations and values of the distortion program
+    afShaderParamBlock m_shaderParams;
+    struct {
+        int warpTexture, distortionType, chromaticAberr, lensCenter, center, focalLength;
+        int imageSize, windowSize, radialDistortion, tangentialDistortion, blackout;
+        int warpMap, useWarpMap, depthTexture, writeDepth, sourceRect;
+        int useCubeMap, cubeFaces[camdistort::CUBE_FACE_COUNT], cubeRects[camdistort::CUBE_FACE_COUNT];
+        int useRemap, remapOffsets, remapSourceSize;
+        int rationalDistortion, thinPrism, tiltMatrix[3];
+        int depthRange, depthFilterMin, depthTextureSize;
+        int rollingShutter, readoutTime, exposureTime, shutterSamples, cameraVelocity, cameraAngularVelocity;
+        int sensorSeed;
+    } m_uniforms;
+
+    // Scene pass restricted to the sampled region of the camera image
+    bool m_tightFrustum;
+    afSourceFrustum m_sourceFrustum;
+    // CPU map for the analyses when the shader evaluates the model itself: built by a
+    // reload and only kept until the end of the frame's updates, or else taken from the
+    // warp map cache so that a lens sweep builds each setting once
+    vector<float> m_analysisMap;
+    shared_ptr<afWarpMap> m_analysisWarpMap;
+
+    // Blackout circle and out-of-texture border: the distortion pass only draws
+    // the cells with visible pixels, the scene pass depth-masks the texels no
+    // visible pixel samples
+    bool m_blackoutMask;
+    bool m_blackoutMaskBuilt;
+    CameraParams m_blackoutMaskParams;
+    int m_blackoutMaskSize[4];
+    float m_blackoutMaskRect[4];
+    afHiddenAreaMask* m_sceneMask;
+    cWorld* m_coverageWorld;
+    cMesh* m_coverageMesh;
+
+    // Scene rendered into cube faces for lenses wider than a perspective frustum,
+    // sampled through the direction map held in m_warpMap
+    bool m_useCubeMap;
+    afCubeSource m_cubeSource;
+
+    // Calibrations of a zoom / focus lens, m_cameraParams follows m_lensSetting.
+    // The setting is rounded to m_lensSteps positions between adjacent keyframes,
+    // the warp maps of the last m_warpMapCacheSize positions are kept.
+    camdistort::LensSchedule m_lensSchedule;
+    int m_lensSteps;
+    int m_warpMapCacheSize;
+    float m_lensSetting[2];
+    bool m_lensSettingChanged;
+    mutex m_lensMutex;
+
+    // Hot reload of the distortion config and the shaders
+    string m_configPath;
+    string m_vertexShader;
+    string m_fragmentShader;
+    // warp_map as set in the plugin block, before warp_direction: inverse forces it
+    bool m_warpMapRequested;
+    afFileWatcher m_fileWatcher;
+    unique_ptr<camdistort::ThreadPool> m_reloadPool;
+    struct {
+        bool hasParams;
+        CameraParams params;
+        camdistort::LensSchedule schedule;
+        camdistort::SensorChain sensorChain;
+        shared_ptr<afWarpMap> warpMap;
+        vector<float> analysisMap;
+        int analysisSize[2];
+        bool shadersChanged;
+    } m_pendingReload;
+    // Output size the worker builds the maps for, guarded by m_reloadMutex with m_pendingReload
+    int m_reloadOutputSize[2];
+    mutex m_reloadMutex;
+
+    // Headless batch rendering
+    bool m_headless;
+    // The window shows a scaled blit of the image_size frame instead of its own pass
+    bool m_presentBlit;
+    int m_outputWidth;
+    int m_outputHeight;
+    afOffscreenTarget m_outputTarget;
+    afFrameWriter m_frameWriter;
+    unsigned long m_frameIndex;
+
+    // Non-blocking PBO readback of the distorted frames
+    bool m_readback;
+    afReadbackRing m_readbackRing;
+    // Captured depth takes the closest of the 2x2 scene texels instead of the nearest
+    bool m_depthFilterMin;
+
+    // Scene sampled through its mip pyramid, with up to m_anisotropy samples along the
+    // compressed direction
+    bool m_sceneMipmaps;
+    float m_anisotropy;
+
+    // Per-row readout and exposure of the sensor
+    afRollingShutter m_rollingShutter;
+
+    // Sensor stages of the config compiled into the distortion program, the noise
+    // is keyed by m_sensorFrame
+    camdistort::SensorChain m_sensorChain;
+    unsigned long m_sensorFrame;
+
+    // Frames rendered at rate_hz and / or only when something moved, the others reuse
+    // the last one. m_paramsVersion counts the changes of the calibration, the output
+    // size and the shaders.
+    afUpdateGate m_updateGate;
+    unsigned long m_paramsVersion;
+
+    // Shared-memory ring for consumers in other processes
+    shmring::Writer m_shmWriter;
+    bool m_shmWarned;
+
+    vector<unique_ptr<afExtraOutput>> m_extraOutputs;
+
+    // Stage timings of graphicsUpdate()
+    afPassProfiler m_profiler;
+    struct {
+        int scene, params, resize, warpMap, sourceFrustum, blackoutMask, cubeSource, offscreen, distortion, present, reuse;
+    } m_stages;
 };
 
 
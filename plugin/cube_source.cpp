@@ -0,0 +1,200 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "cube_source.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Chai3D cameras look along their local x with z up and y to the left of the image
+static cVector3d toCameraFrame(const float a_v[3])
+{
+    return cVector3d(a_v[2], -a_v[0], -a_v[1]);
+}
+
+afCubeSource::afCubeSource()
+{
+    m_maxTexelStretch = 1.0;
+    m_maxFaceSize = 2048;
+    m_width = 0;
+    m_height = 0;
+    m_updated = false;
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        afCubeFace &face = m_faces[f];
+        face.m_active = false;
+        face.m_rect[0] = 0.0f; face.m_rect[1] = 0.0f; face.m_rect[2] = 1.0f; face.m_rect[3] = 1.0f;
+        face.m_width = 0;
+        face.m_height = 0;
+
+        float look[3], right[3], up[3];
+        camdistort::getCubeFaceBasis(static_cast<camdistort::CubeFace>(f), look, right, up);
+        cVector3d left = toCameraFrame(right) * -1.0;
+        face.m_rotation.setCol(toCameraFrame(look), left, toCameraFrame(up));
+    }
+}
+
+bool afCubeSource::isStale(const CameraParams &a_params, int a_width, int a_height) const
+{
+    return !m_updated || a_width != m_width || a_height != m_height || a_params != m_params;
+}
+
+void afCubeSource::update(cCamera* a_camera, const CameraParams &a_params, int a_width, int a_height, const float* a_directionMap)
+{
+    m_params = a_params;
+    m_width = a_width;
+    m_height = a_height;
+    m_updated = true;
+
+    m_footprint = camdistort::analyzeDirectionMap(a_directionMap, a_width, a_height, a_params.aberr_scale);
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (maxTextureSize <= 0){
+        maxTextureSize = 4096;
+    }
+    double stretch = m_maxTexelStretch > 0.0 ? m_maxTexelStretch : 1.0;
+
+    cerr << "[INFO!] Cube faces for [" << a_width << "x" << a_height << "]:";
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        afCubeFace &face = m_faces[f];
+        const camdistort::SourceFootprint &bounds = m_footprint.faces[f];
+        // Also faces only an aberrated channel reaches
+        face.m_active = bounds.uvMin[0] <= bounds.uvMax[0] && bounds.uvMin[1] <= bounds.uvMax[1];
+        if (!face.m_active){
+            continue;
+        }
+
+        // Resolution of the full face for which no texel is stretched beyond the target
+        double resolution = bounds.minScale > 0.0f ? 1.0 / (stretch * bounds.minScale) : m_maxFaceSize;
+        resolution = min((double)m_maxFaceSize, resolution);
+
+        // Two face texels of margin for the bilinear footprint
+        int size[2];
+        for (int i = 0 ; i < 2 ; i++){
+            double margin = 2.0 / resolution;
+            double lower = max(0.0, bounds.uvMin[i] - margin);
+            double upper = min(1.0, bounds.uvMax[i] + margin);
+            size[i] = static_cast<int>(ceil(resolution * (upper - lower)));
+            size[i] = max(16, min(maxTextureSize, size[i]));
+            face.m_rect[i] = static_cast<float>(lower);
+            face.m_rect[2 + i] = static_cast<float>(1.0 / (upper - lower));
+        }
+
+        if (!face.m_frameBuffer){
+            face.m_frameBuffer = cFrameBuffer::create();
+            face.m_frameBuffer->setup(a_camera, size[0], size[1], true, true, GL_RGBA);
+        }
+        else if (size[0] != face.m_width || size[1] != face.m_height){
+            face.m_frameBuffer->setSize(size[0], size[1]);
+        }
+        face.m_width = size[0];
+        face.m_height = size[1];
+        cerr << " " << f << " [" << face.m_width << "x" << face.m_height << "]";
+    }
+    cerr << endl;
+
+    // Faces the lens no longer sees give their memory back
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        if (!m_faces[f].m_active){
+            m_faces[f].m_frameBuffer.reset();
+            m_faces[f].m_width = 0;
+            m_faces[f].m_height = 0;
+        }
+    }
+}
+
+void afCubeSource::render(cCamera* a_camera)
+{
+    const cVector3d localPos = a_camera->getLocalPos();
+    const cMatrix3d localRot = a_camera->getLocalRot();
+    const cVector3d globalPos = a_camera->getGlobalPos();
+    const cMatrix3d globalRot = a_camera->getGlobalRot();
+    const bool useCustomProjection = a_camera->m_useCustomProjectionMatrix;
+    const cTransform projection = a_camera->m_projectionMatrix;
+
+    // Pose of the parent, so that the faces can be placed without walking the scene graph
+    cMatrix3d parentRot = globalRot * localRot.getTranspose();
+    cVector3d parentPos = globalPos - parentRot * localPos;
+
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        afCubeFace &face = m_faces[f];
+        if (!face.m_active){
+            continue;
+        }
+        a_camera->setLocalRot(localRot * face.m_rotation);
+        a_camera->computeGlobalPositions(true, parentPos, parentRot);
+
+        double p[4][4];
+        afPerspectiveProjection(M_PI / 2.0, 1.0, a_camera->getNearClippingPlane(), a_camera->getFarClippingPlane(), p);
+        afCropProjection(face.m_rect, p);
+        afSetProjectionMatrix(p, a_camera->m_projectionMatrix);
+        a_camera->m_useCustomProjectionMatrix = true;
+        face.m_frameBuffer->renderView();
+    }
+
+    a_camera->setLocalRot(localRot);
+    a_camera->computeGlobalPositions(true, parentPos, parentRot);
+    a_camera->m_useCustomProjectionMatrix = useCustomProjection;
+    a_camera->m_projectionMatrix = projection;
+}
+
+void afCubeSource::bind(GLenum a_firstUnit)
+{
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        glActiveTexture(a_firstUnit + f);
+        glBindTexture(GL_TEXTURE_2D, m_faces[f].m_active ? m_faces[f].m_frameBuffer->m_imageBuffer->getTextureId() : 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void afCubeSource::destroy()
+{
+    for (int f = 0 ; f < camdistort::CUBE_FACE_COUNT ; f++){
+        m_faces[f].m_frameBuffer.reset();
+        m_faces[f].m_active = false;
+    }
+    m_updated = false;
+}
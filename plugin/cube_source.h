@@ -0,0 +1,117 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef CUBE_SOURCE_H
+#define CUBE_SOURCE_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include "cube_map.h"
+#include "source_frustum.h"
+
+using namespace std;
+using namespace ambf;
+
+// Scene source for lenses past what a single perspective image can cover. The scene
+// is rendered from the camera position into up to six 90 degree faces of a cube.
+// The faces are plain 2D framebuffers rather than a GL cube map so that every face
+// can be cropped to the region the lens samples and get its own resolution; faces
+// the lens never sees are not rendered at all.
+class afCubeSource{
+public:
+    afCubeSource();
+
+    // Largest number of output pixels a face texel may cover
+    void setMaxTexelStretch(double a_stretch) { m_maxTexelStretch = a_stretch; }
+
+    // Upper bound on the resolution of a full face
+    void setMaxFaceSize(int a_size) { m_maxFaceSize = a_size; }
+
+    // True if update() has not run yet for these params and output size
+    bool isStale(const CameraParams &a_params, int a_width, int a_height) const;
+
+    // Crop and size the faces from the a_width x a_height direction map, see
+    // camdistort::buildDirectionMap()
+    void update(cCamera* a_camera, const CameraParams &a_params, int a_width, int a_height, const float* a_directionMap);
+
+    // Scene pass of every sampled face, the camera pose and projection are restored after
+    void render(cCamera* a_camera);
+
+    // Face textures on a_firstUnit .. a_firstUnit + 5
+    void bind(GLenum a_firstUnit);
+
+    // (u0, v0, 1 / (u1 - u0), 1 / (v1 - v0)) of a face, maps face texture coordinates
+    // to its cropped framebuffer
+    const float* getRect(int a_face) const { return m_faces[a_face].m_rect; }
+
+    bool isActive(int a_face) const { return m_faces[a_face].m_active; }
+
+    void destroy();
+
+protected:
+    struct afCubeFace{
+        bool m_active;
+        float m_rect[4];
+        int m_width;
+        int m_height;
+        // Camera local rotation of the face, relative to the camera
+        cMatrix3d m_rotation;
+        cFrameBufferPtr m_frameBuffer;
+    };
+
+    double m_maxTexelStretch;
+    int m_maxFaceSize;
+
+    CameraParams m_params;
+    int m_width;
+    int m_height;
+    bool m_updated;
+
+    camdistort::CubeFootprint m_footprint;
+    afCubeFace m_faces[camdistort::CUBE_FACE_COUNT];
+};
+
+#endif
@@ -0,0 +1,225 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "file_watcher.h"
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+// Modification time and size, -1 if the file does not exist (e.g. between the
+// unlink and the rename of an editor's save)
+static long long fileStamp(const string &a_path)
+{
+    struct stat info;
+    if (stat(a_path.c_str(), &info) != 0){
+        return -1;
+    }
+#ifdef __linux__
+    long long time = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#else
+    long long time = (long long)info.st_mtime * 1000000000LL;
+#endif
+    return time * 31 + (long long)info.st_size;
+}
+
+static string parentDirectory(const string &a_path)
+{
+    size_t slash = a_path.rfind('/');
+    if (slash == string::npos){
+        return ".";
+    }
+    return slash == 0 ? "/" : a_path.substr(0, slash);
+}
+
+afFileWatcher::afFileWatcher()
+{
+    m_debounce = 0.2;
+    m_running = false;
+    m_stop = false;
+    m_notifyFd = -1;
+    m_wakeFds[0] = -1;
+    m_wakeFds[1] = -1;
+}
+
+afFileWatcher::~afFileWatcher()
+{
+    stop();
+}
+
+bool afFileWatcher::start(const vector<string> &a_files, Callback a_callback, double a_debounce)
+{
+    if (m_running){
+        stop();
+    }
+    m_files = a_files;
+    m_callback = a_callback;
+    m_debounce = a_debounce;
+    m_modified.clear();
+    for (size_t i = 0 ; i < m_files.size() ; i++){
+        m_modified[m_files[i]] = fileStamp(m_files[i]);
+    }
+
+#ifdef __linux__
+    m_notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_notifyFd < 0 || pipe(m_wakeFds) != 0){
+        cerr << "ERROR! Could not set up inotify to watch the distortion files" << endl;
+        if (m_notifyFd >= 0){
+            close(m_notifyFd);
+            m_notifyFd = -1;
+        }
+        return false;
+    }
+    set<string> directories;
+    for (size_t i = 0 ; i < m_files.size() ; i++){
+        directories.insert(parentDirectory(m_files[i]));
+    }
+    for (set<string>::iterator it = directories.begin() ; it != directories.end() ; ++it){
+        if (inotify_add_watch(m_notifyFd, it->c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0){
+            cerr << "WARNING! Could not watch directory " << *it << " for changes" << endl;
+        }
+    }
+#endif
+
+    m_stop = false;
+    m_running = true;
+    m_thread = thread(&afFileWatcher::run, this);
+    return true;
+}
+
+void afFileWatcher::stop()
+{
+    if (!m_running){
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    if (m_wakeFds[1] >= 0){
+        char byte = 0;
+        ssize_t written = write(m_wakeFds[1], &byte, 1);
+        (void)written;
+    }
+    m_thread.join();
+    m_running = false;
+
+    for (int i = 0 ; i < 2 ; i++){
+        if (m_wakeFds[i] >= 0){
+            close(m_wakeFds[i]);
+            m_wakeFds[i] = -1;
+        }
+    }
+    if (m_notifyFd >= 0){
+        close(m_notifyFd);
+        m_notifyFd = -1;
+    }
+}
+
+vector<string> afFileWatcher::pollModified()
+{
+    vector<string> changed;
+    for (size_t i = 0 ; i < m_files.size() ; i++){
+        long long stamp = fileStamp(m_files[i]);
+        if (stamp != -1 && stamp != m_modified[m_files[i]]){
+            m_modified[m_files[i]] = stamp;
+            changed.push_back(m_files[i]);
+        }
+    }
+    return changed;
+}
+
+void afFileWatcher::run()
+{
+    set<string> pending;
+    chrono::steady_clock::time_point lastChange;
+    while (true){
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_stop){
+                return;
+            }
+        }
+
+        // Sleep until something happens in the watched directories, or until the
+        // debounce time of the pending changes ran out
+        int timeoutMs = pending.empty() ? 500 : static_cast<int>(m_debounce * 1000.0 / 4.0) + 1;
+#ifdef __linux__
+        struct pollfd fds[2];
+        fds[0].fd = m_notifyFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_wakeFds[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, pending.empty() ? -1 : timeoutMs) > 0 && (fds[0].revents & POLLIN)){
+            // The events only wake us up, the stamps tell which of our files changed
+            char buffer[4096];
+            while (read(m_notifyFd, buffer, sizeof(buffer)) > 0){
+            }
+        }
+#else
+        this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+#endif
+
+        vector<string> changed = pollModified();
+        if (!changed.empty()){
+            pending.insert(changed.begin(), changed.end());
+            lastChange = chrono::steady_clock::now();
+            continue;
+        }
+        if (!pending.empty() &&
+                chrono::duration<double>(chrono::steady_clock::now() - lastChange).count() >= m_debounce){
+            vector<string> files(pending.begin(), pending.end());
+            pending.clear();
+            m_callback(files);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Watches a set of files on a worker thread and reports changes to a callback, run
+// on that same thread. On Linux the parent directories are watched with inotify, so
+// files replaced by a rename (as most editors save) are seen as well; elsewhere the
+// modification times are polled. Bursts of events are merged: the callback runs
+// once the files stopped changing for the debounce time.
+class afFileWatcher{
+public:
+    typedef function<void(const vector<string> &a_changedFiles)> Callback;
+
+    afFileWatcher();
+    ~afFileWatcher();
+
+    bool start(const vector<string> &a_files, Callback a_callback, double a_debounce = 0.2);
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+protected:
+    void run();
+
+    // Files of m_files whose modification time changed since the last call
+    vector<string> pollModified();
+
+    vector<string> m_files;
+    map<string, long long> m_modified;
+    Callback m_callback;
+    double m_debounce;
+
+    thread m_thread;
+    mutex m_mutex;
+    bool m_running;
+    bool m_stop;
+    // inotify descriptor and the pipe that wakes the worker up on stop()
+    int m_notifyFd;
+    int m_wakeFds[2];
+};
+
+#endif
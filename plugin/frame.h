@@ -0,0 +1,88 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <cstdint>
+#include <vector>
+
+// One distorted frame read back from the GPU
+struct afFrame {
+    unsigned long m_index;
+    int m_width;
+    int m_height;
+    // Simulation time of the rendered world
+    double m_simTime;
+    // cameraParamsHash() of the calibration the frame was rendered with
+    uint64_t m_paramsHash;
+    // Wall time (glfwGetTime) when the readback was issued and when the data was mapped
+    double m_renderTime;
+    double m_readyTime;
+    // RGBA8, OpenGL row order
+    std::vector<unsigned char> m_rgba;
+    // Distance along the optical axis in world units, 0 where nothing was rendered.
+    // Empty unless depth capture is enabled
+    std::vector<float> m_depth;
+    // The mapped readback buffers, only valid during the frame callback. m_rgba and
+    // m_depth stay empty until retain() copies them for consumers that keep the frame.
+    const unsigned char* m_mappedRgba = nullptr;
+    const float* m_mappedDepth = nullptr;
+
+    void retain()
+    {
+        const size_t numPixels = (size_t)m_width * (size_t)m_height;
+        if (m_mappedRgba){
+            m_rgba.assign(m_mappedRgba, m_mappedRgba + numPixels * 4);
+        }
+        if (m_mappedDepth){
+            m_depth.assign(m_mappedDepth, m_mappedDepth + numPixels);
+        }
+        m_mappedRgba = nullptr;
+        m_mappedDepth = nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,149 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "frame_writer.h"
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+afFrameWriter::afFrameWriter()
+{
+    m_queueSize = 8;
+    m_running = false;
+    m_stop = false;
+    m_written = 0;
+}
+
+afFrameWriter::~afFrameWriter()
+{
+    stop();
+}
+
+bool afFrameWriter::start(const string &a_directory, const string &a_prefix, const string &a_extension, int a_queueSize)
+{
+    if (m_running){
+        return true;
+    }
+
+    try {
+        boost::filesystem::create_directories(a_directory);
+    } catch (const boost::filesystem::filesystem_error &e) {
+        cerr << "ERROR! Can't create output directory " << a_directory << ": " << e.what() << endl;
+        return false;
+    }
+
+    m_directory = a_directory;
+    m_prefix = a_prefix;
+    m_extension = a_extension;
+    m_queueSize = a_queueSize > 0 ? a_queueSize : 1;
+    m_stop = false;
+    m_running = true;
+    m_thread = thread(&afFrameWriter::run, this);
+    return true;
+}
+
+void afFrameWriter::stop()
+{
+    if (!m_running){
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+    m_thread.join();
+    m_running = false;
+}
+
+void afFrameWriter::write(afFrame &&a_frame)
+{
+    if (!m_running){
+        return;
+    }
+    unique_lock<mutex> lock(m_mutex);
+    m_notFull.wait(lock, [&]{ return m_stop || m_queue.size() < m_queueSize; });
+    if (m_stop){
+        return;
+    }
+    m_queue.push_back(std::move(a_frame));
+    lock.unlock();
+    m_notEmpty.notify_one();
+}
+
+void afFrameWriter::run()
+{
+    while (true){
+        afFrame frame;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [&]{ return m_stop || !m_queue.empty(); });
+            // flush what is queued before leaving
+            if (m_queue.empty()){
+                return;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_notFull.notify_one();
+
+        cImagePtr image = cImage::create();
+        image->allocate(frame.m_width, frame.m_height, GL_RGBA, GL_UNSIGNED_BYTE);
+        memcpy(image->getData(), frame.m_rgba.data(), frame.m_rgba.size());
+
+        char index[32];
+        snprintf(index, sizeof(index), "%06lu", frame.m_index);
+        string filename = m_directory + "/" + m_prefix + "_" + index + "." + m_extension;
+        if (!image->saveToFile(filename)){
+            cerr << "ERROR! Failed to write " << filename << endl;
+        }
+        else{
+            m_written++;
+        }
+    }
+}
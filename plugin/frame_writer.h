@@ -0,0 +1,97 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame.h"
+
+using namespace std;
+using namespace ambf;
+
+// Writes frames to disk on a worker thread so that encoding never runs on the
+// render thread. When the queue is full write() blocks, frames are never dropped.
+class afFrameWriter{
+public:
+    afFrameWriter();
+    ~afFrameWriter();
+
+    // Files are written as <a_directory>/<a_prefix>_<index>.<a_extension>
+    bool start(const string &a_directory, const string &a_prefix, const string &a_extension = "png", int a_queueSize = 8);
+    void stop();
+
+    void write(afFrame &&a_frame);
+
+    bool isRunning() const { return m_running; }
+    unsigned long getWrittenCount() const { return m_written; }
+
+protected:
+    void run();
+
+    string m_directory;
+    string m_prefix;
+    string m_extension;
+    size_t m_queueSize;
+
+    deque<afFrame> m_queue;
+    mutex m_mutex;
+    condition_variable m_notEmpty;
+    condition_variable m_notFull;
+    thread m_thread;
+    bool m_running;
+    bool m_stop;
+    atomic<unsigned long> m_written;
+};
+
+#endif
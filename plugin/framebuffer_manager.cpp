@@ -0,0 +1,188 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "framebuffer_manager.h"
+
+using namespace std;
+
+afFrameBufferManager::afFrameBufferManager()
+{
+    m_active.m_width = 0;
+    m_active.m_height = 0;
+    m_camera = nullptr;
+    m_imageBuffer = true;
+    m_depthBuffer = true;
+    m_format = GL_RGBA;
+    m_pendingWidth = 0;
+    m_pendingHeight = 0;
+    m_failedWidth = 0;
+    m_failedHeight = 0;
+    m_debounceTime = 0.2;
+    m_poolSize = 2;
+    m_allocationCount = 0;
+}
+
+bool afFrameBufferManager::setup(cCamera *a_camera, int a_width, int a_height, bool a_imageBuffer, bool a_depthBuffer, GLint a_format)
+{
+    m_camera = a_camera;
+    m_imageBuffer = a_imageBuffer;
+    m_depthBuffer = a_depthBuffer;
+    m_format = a_format;
+
+    m_active.m_frameBuffer = cFrameBuffer::create();
+    m_active.m_width = a_width;
+    m_active.m_height = a_height;
+    m_pendingWidth = a_width;
+    m_pendingHeight = a_height;
+    m_allocationCount++;
+    return m_active.m_frameBuffer->setup(m_camera, a_width, a_height, m_imageBuffer, m_depthBuffer, m_format);
+}
+
+bool afFrameBufferManager::update(int a_width, int a_height)
+{
+    if (a_width <= 0 || a_height <= 0){
+        // minimized window, keep whatever we have
+        return false;
+    }
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+    if (a_width == m_active.m_width && a_height == m_active.m_height){
+        m_pendingWidth = a_width;
+        m_pendingHeight = a_height;
+        return false;
+    }
+
+    // A new size restarts the debounce timer
+    if (a_width != m_pendingWidth || a_height != m_pendingHeight){
+        m_pendingWidth = a_width;
+        m_pendingHeight = a_height;
+        m_pendingSince = now;
+        m_failedWidth = 0;
+        m_failedHeight = 0;
+        if (m_debounceTime > 0.0){
+            return false;
+        }
+    }
+
+    if (chrono::duration<double>(now - m_pendingSince).count() < m_debounceTime){
+        return false;
+    }
+
+    // Do not retry a size that failed until another one is requested
+    if (a_width == m_failedWidth && a_height == m_failedHeight){
+        return false;
+    }
+
+    // The size settled, look for a pooled framebuffer of that size first
+    afPooledFrameBuffer next;
+    bool found = false;
+    for (list<afPooledFrameBuffer>::iterator it = m_pool.begin() ; it != m_pool.end() ; ++it){
+        if (it->m_width == a_width && it->m_height == a_height){
+            next = *it;
+            m_pool.erase(it);
+            found = true;
+            break;
+        }
+    }
+
+    if (!found){
+        next.m_frameBuffer = cFrameBuffer::create();
+        next.m_width = a_width;
+        next.m_height = a_height;
+        if (!next.m_frameBuffer->setup(m_camera, a_width, a_height, m_imageBuffer, m_depthBuffer, m_format)){
+            cerr << "ERROR! Framebuffer allocation failed for [" << a_width << "x" << a_height << "], keeping ["
+                 << m_active.m_width << "x" << m_active.m_height << "]" << endl;
+            m_failedWidth = a_width;
+            m_failedHeight = a_height;
+            return false;
+        }
+        m_allocationCount++;
+    }
+
+    // Most recently used first, drop the least recently used beyond the pool size
+    m_pool.push_front(m_active);
+    while ((int)m_pool.size() > m_poolSize){
+        m_pool.pop_back();
+    }
+    m_active = next;
+
+    cerr << "[INFO!] Framebuffer " << (found ? "reused" : "allocated") << " for [" << a_width << "x" << a_height << "]"
+         << " (allocations: " << m_allocationCount << ", held: " << getBytesHeld() / (1024 * 1024) << " MB)" << endl;
+
+    return true;
+}
+
+void afFrameBufferManager::setPoolSize(int a_size)
+{
+    m_poolSize = a_size < 0 ? 0 : a_size;
+    while ((int)m_pool.size() > m_poolSize){
+        m_pool.pop_back();
+    }
+}
+
+size_t afFrameBufferManager::bytesFor(int a_width, int a_height) const
+{
+    // RGBA8 color and 32 bit depth attachments
+    size_t pixels = (size_t)a_width * (size_t)a_height;
+    return pixels * ((m_imageBuffer ? 4 : 0) + (m_depthBuffer ? 4 : 0));
+}
+
+size_t afFrameBufferManager::getBytesHeld() const
+{
+    size_t bytes = m_active.m_frameBuffer ? bytesFor(m_active.m_width, m_active.m_height) : 0;
+    for (list<afPooledFrameBuffer>::const_iterator it = m_pool.begin() ; it != m_pool.end() ; ++it){
+        bytes += bytesFor(it->m_width, it->m_height);
+    }
+    return bytes;
+}
+
+void afFrameBufferManager::clear()
+{
+    m_pool.clear();
+    m_active.m_frameBuffer.reset();
+    m_active.m_width = 0;
+    m_active.m_height = 0;
+}
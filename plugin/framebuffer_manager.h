@@ -0,0 +1,121 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef FRAMEBUFFER_MANAGER_H
+#define FRAMEBUFFER_MANAGER_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <chrono>
+#include <list>
+
+using namespace std;
+using namespace ambf;
+
+struct afPooledFrameBuffer {
+    cFrameBufferPtr m_frameBuffer;
+    int m_width;
+    int m_height;
+};
+
+// Owns the scene framebuffer of a camera and resizes it lazily. A new size is only
+// applied once it has been requested unchanged for the debounce period, so that an
+// interactive window resize does not reallocate the attachments for every
+// intermediate size. Previously allocated sizes are kept in a small LRU pool and
+// reused when the window returns to them (e.g. when moved between monitors).
+class afFrameBufferManager{
+public:
+    afFrameBufferManager();
+
+    // Allocate the initial framebuffer, same arguments as cFrameBuffer::setup
+    bool setup(cCamera* a_camera, int a_width, int a_height, bool a_imageBuffer = true, bool a_depthBuffer = true, GLint a_format = GL_RGBA);
+
+    // Request a size. Returns true if the active framebuffer object changed
+    // (the caller must then re-bind its texture). If the framebuffer of the new
+    // size can not be created the current one stays active.
+    bool update(int a_width, int a_height);
+
+    cFrameBufferPtr getFrameBuffer() const { return m_active.m_frameBuffer; }
+    int getWidth() const { return m_active.m_width; }
+    int getHeight() const { return m_active.m_height; }
+
+    // Seconds a requested size has to be stable before it is applied
+    void setDebounceTime(double a_seconds) { m_debounceTime = a_seconds; }
+
+    // Number of inactive framebuffers kept for reuse
+    void setPoolSize(int a_size);
+
+    // Number of framebuffer allocations since setup (including the first one)
+    int getAllocationCount() const { return m_allocationCount; }
+
+    // Estimated GPU memory held by the active and the pooled framebuffers
+    size_t getBytesHeld() const;
+
+    void clear();
+
+protected:
+    size_t bytesFor(int a_width, int a_height) const;
+
+    afPooledFrameBuffer m_active;
+    list<afPooledFrameBuffer> m_pool;
+    cCamera* m_camera;
+    bool m_imageBuffer;
+    bool m_depthBuffer;
+    GLint m_format;
+
+    int m_pendingWidth;
+    int m_pendingHeight;
+    chrono::steady_clock::time_point m_pendingSince;
+    // Size whose framebuffer could not be created, 0 if none
+    int m_failedWidth;
+    int m_failedHeight;
+
+    double m_debounceTime;
+    int m_poolSize;
+    int m_allocationCount;
+};
+
+#endif
@@ -0,0 +1,262 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "hidden_area_mask.h"
+#include <algorithm>
+
+using namespace std;
+
+afCellGrid::afCellGrid()
+{
+    m_cellsX = 0;
+    m_cellsY = 0;
+}
+
+void afCellGrid::resize(int a_cellsX, int a_cellsY)
+{
+    m_cellsX = max(1, a_cellsX);
+    m_cellsY = max(1, a_cellsY);
+    m_cells.assign((size_t)m_cellsX * m_cellsY, 0);
+}
+
+void afCellGrid::mark(float a_u, float a_v)
+{
+    int i = min(m_cellsX - 1, max(0, static_cast<int>(a_u * m_cellsX)));
+    int j = min(m_cellsY - 1, max(0, static_cast<int>(a_v * m_cellsY)));
+    set(i, j);
+}
+
+void afCellGrid::dilate()
+{
+    vector<unsigned char> grown(m_cells);
+    for (int j = 0 ; j < m_cellsY ; j++){
+        for (int i = 0 ; i < m_cellsX ; i++){
+            if (!get(i, j)){
+                continue;
+            }
+            for (int nj = max(0, j - 1) ; nj <= min(m_cellsY - 1, j + 1) ; nj++){
+                for (int ni = max(0, i - 1) ; ni <= min(m_cellsX - 1, i + 1) ; ni++){
+                    grown[nj * m_cellsX + ni] = 1;
+                }
+            }
+        }
+    }
+    m_cells.swap(grown);
+}
+
+double afCellGrid::getCoverage() const
+{
+    if (m_cells.empty()){
+        return 0.0;
+    }
+    size_t count = 0;
+    for (size_t i = 0 ; i < m_cells.size() ; i++){
+        count += m_cells[i] != 0;
+    }
+    return static_cast<double>(count) / m_cells.size();
+}
+
+// Calls a_quad(i0, i1, j) for every horizontal run [i0, i1) of cells equal to a_value
+template <class F>
+static void forEachRun(const afCellGrid &a_cells, bool a_value, F a_quad)
+{
+    for (int j = 0 ; j < a_cells.getCellsY() ; j++){
+        int i = 0;
+        while (i < a_cells.getCellsX()){
+            if (a_cells.get(i, j) != a_value){
+                i++;
+                continue;
+            }
+            int start = i;
+            while (i < a_cells.getCellsX() && a_cells.get(i, j) == a_value){
+                i++;
+            }
+            a_quad(start, i, j);
+        }
+    }
+}
+
+cMesh* afCreateCoverageMesh(const afCellGrid &a_cells)
+{
+    cMesh* mesh = new cMesh();
+    const double cellsX = a_cells.getCellsX(), cellsY = a_cells.getCellsY();
+    forEachRun(a_cells, true, [&](int i0, int i1, int j){
+        double u0 = i0 / cellsX, u1 = i1 / cellsX;
+        double v0 = j / cellsY, v1 = (j + 1) / cellsY;
+        unsigned v00 = mesh->newVertex(cVector3d(2.0 * u0 - 1.0, 2.0 * v0 - 1.0, 0.0));
+        unsigned v10 = mesh->newVertex(cVector3d(2.0 * u1 - 1.0, 2.0 * v0 - 1.0, 0.0));
+        unsigned v11 = mesh->newVertex(cVector3d(2.0 * u1 - 1.0, 2.0 * v1 - 1.0, 0.0));
+        unsigned v01 = mesh->newVertex(cVector3d(2.0 * u0 - 1.0, 2.0 * v1 - 1.0, 0.0));
+        mesh->m_vertices->setTexCoord(v00, u0, v0, 1.0);
+        mesh->m_vertices->setTexCoord(v10, u1, v0, 1.0);
+        mesh->m_vertices->setTexCoord(v11, u1, v1, 1.0);
+        mesh->m_vertices->setTexCoord(v01, u0, v1, 1.0);
+        mesh->newTriangle(v00, v10, v11);
+        mesh->newTriangle(v00, v11, v01);
+    });
+    mesh->computeAllNormals();
+    mesh->setUseTexture(true);
+    mesh->setShowEnabled(true);
+    return mesh;
+}
+
+afHiddenAreaMask::afHiddenAreaMask(int a_numViews)
+{
+    m_world = nullptr;
+    m_numViews = max(1, a_numViews);
+    m_frameWidth = 0;
+    m_triangles.resize(m_numViews);
+}
+
+double afHiddenAreaMask::build(int a_view, const afCellGrid &a_keep)
+{
+    vector<float> &triangles = m_triangles[a_view];
+    triangles.clear();
+    int masked = 0;
+    const float cellsX = static_cast<float>(a_keep.getCellsX()), cellsY = static_cast<float>(a_keep.getCellsY());
+    forEachRun(a_keep, false, [&](int i0, int i1, int j){
+        masked += i1 - i0;
+        float x0 = 2.0f * i0 / cellsX - 1.0f, x1 = 2.0f * i1 / cellsX - 1.0f;
+        float y0 = 2.0f * j / cellsY - 1.0f, y1 = 2.0f * (j + 1) / cellsY - 1.0f;
+        const float quad[12] = {x0, y0, x1, y0, x1, y1, x0, y0, x1, y1, x0, y1};
+        triangles.insert(triangles.end(), quad, quad + 12);
+    });
+    return static_cast<double>(masked) / (cellsX * cellsY);
+}
+
+bool afHiddenAreaMask::isEmpty() const
+{
+    for (int view = 0 ; view < m_numViews ; view++){
+        if (!m_triangles[view].empty()){
+            return false;
+        }
+    }
+    return true;
+}
+
+void afHiddenAreaMask::attach(cWorld* a_world)
+{
+    detach();
+    // Objects added later are appended behind the mask
+    vector<cGenericObject*> children;
+    for (unsigned int i = 0 ; i < a_world->getNumChildren() ; i++){
+        children.push_back(a_world->getChild(i));
+    }
+    for (size_t i = 0 ; i < children.size() ; i++){
+        a_world->removeChild(children[i]);
+    }
+    a_world->addChild(this);
+    for (size_t i = 0 ; i < children.size() ; i++){
+        a_world->addChild(children[i]);
+    }
+    m_world = a_world;
+}
+
+void afHiddenAreaMask::detach()
+{
+    if (m_world){
+        m_world->removeChild(this);
+        m_world = nullptr;
+    }
+}
+
+void afHiddenAreaMask::render(cRenderOptions& a_options)
+{
+    // Once per view, ahead of the opaque objects, and never into the shadow maps
+    if (a_options.m_creating_shadow_map || !(a_options.m_single_pass_only || a_options.m_render_opaque_objects_only)){
+        return;
+    }
+
+    // The world is rendered once per view viewport in passive stereo, or once over
+    // all views
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const bool singleView = m_numViews > 1 && viewport[2] < m_frameWidth;
+    const int viewportView = m_frameWidth > 0 ? min(m_numViews - 1, viewport[0] * m_numViews / m_frameWidth) : 0;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glUseProgram(0);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_ALWAYS);
+    glDepthMask(GL_TRUE);
+    glDepthRange(0.0, 0.0);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (int view = 0 ; view < m_numViews ; view++){
+        if (singleView && view != viewportView){
+            continue;
+        }
+        glPushMatrix();
+        if (!singleView && m_numViews > 1){
+            // all views in one viewport, side by side
+            float width = 2.0f / m_numViews;
+            glTranslatef(-1.0f + width * (view + 0.5f), 0.0f, 0.0f);
+            glScalef(1.0f / m_numViews, 1.0f, 1.0f);
+        }
+        if (!m_triangles[view].empty()){
+            glVertexPointer(2, GL_FLOAT, 0, m_triangles[view].data());
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_triangles[view].size() / 2));
+        }
+        glPopMatrix();
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glPopAttrib();
+}
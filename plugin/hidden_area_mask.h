@@ -0,0 +1,124 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef HIDDEN_AREA_MASK_H
+#define HIDDEN_AREA_MASK_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <vector>
+
+using namespace std;
+using namespace ambf;
+
+// Coarse boolean grid over an image or texture, rows bottom-up like GL textures
+class afCellGrid{
+public:
+    afCellGrid();
+
+    void resize(int a_cellsX, int a_cellsY);
+
+    // Set the cell containing texture coordinate (a_u, a_v), clamped to the grid
+    void mark(float a_u, float a_v);
+
+    void set(int a_i, int a_j) { m_cells[a_j * m_cellsX + a_i] = 1; }
+    bool get(int a_i, int a_j) const { return m_cells[a_j * m_cellsX + a_i] != 0; }
+
+    // Grow the set cells by one cell in every direction
+    void dilate();
+
+    // Fraction of the cells that are set
+    double getCoverage() const;
+
+    int getCellsX() const { return m_cellsX; }
+    int getCellsY() const { return m_cellsY; }
+
+protected:
+    int m_cellsX;
+    int m_cellsY;
+    vector<unsigned char> m_cells;
+};
+
+// Quad mesh of the set cells, for a full screen pass that should not shade the rest.
+// Same vertex layout as the full screen quad: positions in normalized device
+// coordinates and texture coordinates (u, v, 1) over the screen.
+cMesh* afCreateCoverageMesh(const afCellGrid &a_cells);
+
+// Early depth mask of a scene pass. Rendered as the first object of the world, it
+// writes the near plane into the depth buffer over the cells that are not kept, so
+// the scene fragments there fail the depth test before shading. The back layer would
+// not do: the camera clears the depth buffer between it and the world. Other cameras
+// render the same world, so the mask is only shown around the scene pass.
+class afHiddenAreaMask: public cGenericObject{
+public:
+    // a_numViews side by side views, 2 for passive stereo
+    afHiddenAreaMask(int a_numViews = 1);
+
+    // Triangulate the cells of a view that are not set in a_keep. Returns the
+    // fraction of the view that is masked.
+    double build(int a_view, const afCellGrid &a_keep);
+
+    // Width of the scene framebuffer, to tell per-view viewports from a full one
+    void setFrameWidth(int a_width) { m_frameWidth = a_width; }
+
+    // True if no cell is masked
+    bool isEmpty() const;
+
+    // Insert the mask ahead of the children of a_world, which are rendered in order
+    void attach(cWorld* a_world);
+    void detach();
+
+protected:
+    virtual void render(cRenderOptions& a_options) override;
+
+    cWorld* m_world;
+    int m_numViews;
+    int m_frameWidth;
+    // x, y pairs in the normalized device coordinates of each view
+    vector<vector<float> > m_triangles;
+};
+
+#endif
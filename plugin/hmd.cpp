@@ -62,6 +62,12 @@ afCameraHMD::afCameraHMD()
     m_width = 2880;
     m_height = 1600;
     m_alias_scaling = 1.0;
+    m_quadWorld.m_world = nullptr;
+    m_quadWorld.m_quadMesh = nullptr;
+    m_emptyWorld = nullptr;
+    m_useDistortionMesh = true;
+    m_meshWorld = nullptr;
+    m_hiddenAreaMask = nullptr;
 }
 
 int afCameraHMD::init(const afBaseObjectPtr a_afObjectPtr, const afBaseObjectAttribsPtr a_objectAttribs)
@@ -71,23 +77,72 @@ int afCameraHMD::init(const afBaseObjectPtr a_afObjectPtr, const afBaseObjectAtt
 
     m_camera->getInternalCamera()->m_stereoOffsetW = 0.1;
 
+    // Per-stage CPU/GPU timings, off unless requested in the plugin block
+    m_stages.scene = m_profiler.addStage("scene");
+    m_stages.params = m_profiler.addStage("params");
+    m_stages.distortion = m_profiler.addStage("distortion");
+    YAML::Node specificationDataNode = YAML::Load(a_objectAttribs->getSpecificationData().m_rawData);
+    YAML::Node pluginNode = specificationDataNode["plugins"][0];
+    if (pluginNode["profile"] && pluginNode["profile"].as<bool>()){
+        string profileFile;
+        double profilePeriod = 5.0;
+        if (pluginNode["profile_file"]){
+            profileFile = pluginNode["profile_file"].as<string>();
+        }
+        if (pluginNode["profile_period"]){
+            profilePeriod = pluginNode["profile_period"].as<double>();
+        }
+        m_profiler.enable(profileFile, profilePeriod);
+    }
+
+    // Tessellated warp and hidden-area mask, both sized from the lens
+    int meshResolution = 128;
+    float lensRadius = 0.0f;
+    if (pluginNode["distortion_mesh"]){
+        m_useDistortionMesh = pluginNode["distortion_mesh"].as<bool>();
+    }
+    if (pluginNode["mesh_resolution"]){
+        meshResolution = pluginNode["mesh_resolution"].as<int>();
+    }
+    if (pluginNode["lens_radius"]){
+        lensRadius = pluginNode["lens_radius"].as<float>();
+    }
+    // Without a lens circle the warp samples nearly all of the scene texture, so the
+    // mask is only on by default with one
+    bool useHiddenAreaMask = lensRadius > 0.0f;
+    if (pluginNode["hidden_area_mask"]){
+        useHiddenAreaMask = pluginNode["hidden_area_mask"].as<bool>();
+    }
+
     m_frameBuffer = cFrameBuffer::create();
     m_frameBuffer->setup(m_camera->getInternalCamera(), m_width * m_alias_scaling, m_height * m_alias_scaling, true, true, GL_RGBA);
 
     string file_path = __FILE__;
     g_current_filepath = file_path.substr(0, file_path.rfind("/"));
 
-    afShaderAttributes shaderAttribs;
-    shaderAttribs.m_shaderDefined = true;
-    shaderAttribs.m_vtxFilepath = "example/shaders/hmd_distortion.vs";
-    shaderAttribs.m_fragFilepath = "example/shaders/hmd_distortion.fs";
-
-    m_shaderPgm = afShaderUtils::createFromAttribs(&shaderAttribs, "TEST", "VR_CAM");
+    // Shared with other HMD cameras, see afResourceCache
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    if (m_useDistortionMesh){
+        m_shaderPgm = resourceCache.acquireProgram("example/shaders/hmd_distortion_mesh.vs", "example/shaders/hmd_distortion_mesh.fs", "VR_CAM_MESH");
+    }
+    else{
+        m_shaderPgm = resourceCache.acquireProgram("example/shaders/hmd_distortion.vs", "example/shaders/hmd_distortion.fs", "VR_CAM");
+    }
     if (!m_shaderPgm){
         cerr << "ERROR! FAILED TO LOAD SHADER PGM \n";
         return -1;
     }
 
+    // Resolve the uniform locations once for this program
+    m_uniforms.warpTexture = m_shaderParams.addUniform("warpTexture", afUniformType::INT);
+    m_uniforms.viewportScale = m_shaderParams.addUniform("ViewportScale", afUniformType::VEC2);
+    m_uniforms.aberr = m_shaderParams.addUniform("aberr", afUniformType::VEC3);
+    m_uniforms.warpScale = m_shaderParams.addUniform("WarpScale", afUniformType::FLOAT);
+    m_uniforms.hmdWarpParam = m_shaderParams.addUniform("HmdWarpParam", afUniformType::VEC4);
+    m_uniforms.lensCenterLeft = m_shaderParams.addUniform("LensCenterLeft", afUniformType::VEC2);
+    m_uniforms.lensCenterRight = m_shaderParams.addUniform("LensCenterRight", afUniformType::VEC2);
+    m_shaderParams.setProgram(m_shaderPgm->getId());
+
     m_viewport_scale[0] = 0.122822f;
     m_viewport_scale[0] /= 2.0;
     m_viewport_scale[1] = 0.068234f;
@@ -113,40 +168,46 @@ int afCameraHMD::init(const afBaseObjectPtr a_afObjectPtr, const afBaseObjectAtt
     m_warp_scale = (m_left_lens_center[0] > m_right_lens_center[0]) ? m_left_lens_center[0] : m_right_lens_center[0];
     m_warp_adj = 1.0;
 
-    m_quadMesh = new cMesh();
-    float quad[] = {
-        // positions
-         -1.0f,  1.0f, 0.0f,
-         -1.0f, -1.0f, 0.0f,
-          1.0f, -1.0f, 0.0f,
-         -1.0f,  1.0f, 0.0f,
-          1.0f, -1.0f, 0.0f,
-          1.0f,  1.0f, 0.0f,
-    };
-
-    for (int vI = 0 ; vI < 2 ; vI++){
-        int off = vI * 9;
-        cVector3d v0(quad[off + 0], quad[off + 1], quad[off + 2]);
-        cVector3d v1(quad[off + 3], quad[off + 4], quad[off + 5]);
-        cVector3d v2(quad[off + 6], quad[off + 7], quad[off + 8]);
-        m_quadMesh->newTriangle(v0, v1, v2);
-    }
-    m_quadMesh->m_vertices->setTexCoord(1, 0.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(2, 1.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(0, 0.0, 1.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(3, 0.0, 1.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(4, 1.0, 0.0, 1.0);
-    m_quadMesh->m_vertices->setTexCoord(5, 1.0, 1.0, 1.0);
-
-    m_quadMesh->computeAllNormals();
-    m_quadMesh->m_texture = m_frameBuffer->m_imageBuffer;
-    m_quadMesh->setUseTexture(true);
-
-    m_quadMesh->setShaderProgram(m_shaderPgm);
-    m_quadMesh->setShowEnabled(true);
-
-    m_vrWorld = new cWorld();
-    m_vrWorld->addChild(m_quadMesh);
+    afHMDLens eyes[2];
+    getLenses(eyes);
+    if (m_useDistortionMesh){
+        // Depends on the lens parameters, so not shared through the cache
+        m_quadMesh = afCreateHMDDistortionMesh(eyes, meshResolution, lensRadius);
+        m_quadMesh->setShaderProgram(m_shaderPgm);
+        m_meshWorld = new cWorld();
+        m_meshWorld->addChild(m_quadMesh);
+        m_vrWorld = m_meshWorld;
+    }
+    else{
+        m_quadWorld = resourceCache.acquireQuadWorld(m_shaderPgm);
+        m_quadMesh = m_quadWorld.m_quadMesh;
+        m_vrWorld = m_quadWorld.m_world;
+    }
+    m_emptyWorld = resourceCache.acquireEmptyWorld();
+
+    if (useHiddenAreaMask){
+        m_hiddenAreaMask = new afHiddenAreaMask(2);
+        double masked = 0.0;
+        for (int eye = 0 ; eye < 2 ; eye++){
+            // One cell of margin for the bilinear footprint
+            afCellGrid sampled;
+            sampled.resize(meshResolution, meshResolution);
+            afMarkHMDSampledCells(eyes[eye], lensRadius, sampled);
+            sampled.dilate();
+            masked += 0.5 * m_hiddenAreaMask->build(eye, sampled);
+        }
+        cerr << "INFO! HIDDEN AREA MASK COVERS " << static_cast<int>(100.0 * masked + 0.5) << "% OF THE SCENE \n";
+        if (m_hiddenAreaMask->isEmpty()){
+            delete m_hiddenAreaMask;
+            m_hiddenAreaMask = nullptr;
+        }
+        else{
+            // Drawn in the world pass, the camera clears the depth after the back layer
+            m_hiddenAreaMask->setFrameWidth(m_width * m_alias_scaling);
+            m_hiddenAreaMask->setShowEnabled(false);
+            m_hiddenAreaMask->attach(m_camera->getInternalCamera()->getParentWorld());
+        }
+    }
 
     cerr << "INFO! LOADING VR PLUGIN \n";
 
@@ -161,18 +222,33 @@ void afCameraHMD::graphicsUpdate()
         first_time = false;
     }
     glfwMakeContextCurrent(m_camera->m_window);
+    m_profiler.beginFrame();
+
+    m_profiler.begin(m_stages.scene);
+    if (m_hiddenAreaMask){
+        m_hiddenAreaMask->setShowEnabled(true);
+    }
     m_frameBuffer->renderView();
+    if (m_hiddenAreaMask){
+        m_hiddenAreaMask->setShowEnabled(false);
+    }
+    m_profiler.end(m_stages.scene);
+
+    m_profiler.begin(m_stages.params);
+    m_quadMesh->m_texture = m_frameBuffer->m_imageBuffer;
     updateHMDParams();
+    m_profiler.end(m_stages.params);
     afRenderOptions ro;
     ro.m_updateLabels = true;
 
     cWorld* cachedWorld = m_camera->getInternalCamera()->getParentWorld();
     m_camera->getInternalCamera()->setStereoMode(C_STEREO_DISABLED);
     m_camera->getInternalCamera()->setParentWorld(m_vrWorld);
-    static cWorld* ew = new cWorld();
     cWorld* fl = m_camera->getInternalCamera()->m_frontLayer;
-    m_camera->getInternalCamera()->m_frontLayer = ew;
+    m_camera->getInternalCamera()->m_frontLayer = m_emptyWorld;
+    m_profiler.begin(m_stages.distortion);
     m_camera->render(ro);
+    m_profiler.end(m_stages.distortion);
     m_camera->getInternalCamera()->m_frontLayer = fl;
     m_camera->getInternalCamera()->setStereoMode(C_STEREO_PASSIVE_LEFT_RIGHT);
     m_camera->getInternalCamera()->setParentWorld(cachedWorld);
@@ -189,21 +265,62 @@ void afCameraHMD::reset(){
 
 bool afCameraHMD::close()
 {
+    glfwMakeContextCurrent(m_camera->m_window);
+    m_profiler.disable();
+
+    afResourceCache& resourceCache = afResourceCache::getInstance();
+    if (m_hiddenAreaMask){
+        m_hiddenAreaMask->detach();
+        delete m_hiddenAreaMask;
+        m_hiddenAreaMask = nullptr;
+    }
+    if (m_meshWorld){
+        // The world deletes the mesh
+        delete m_meshWorld;
+        m_meshWorld = nullptr;
+    }
+    else{
+        resourceCache.releaseQuadWorld(m_quadWorld);
+    }
+    if (m_emptyWorld){
+        resourceCache.releaseEmptyWorld();
+        m_emptyWorld = nullptr;
+    }
+    resourceCache.releaseProgram(m_shaderPgm);
     return true;
 }
 
 void afCameraHMD::updateHMDParams()
 {
-    GLint id = m_shaderPgm->getId();
-       cerr << "INFO! Shader ID " << id << endl;
-    glUseProgram(id);
-    glUniform1i(glGetUniformLocation(id, "warpTexture"), 2);
-    glUniform2fv(glGetUniformLocation(id, "ViewportScale"), 1, m_viewport_scale);
-    glUniform3fv(glGetUniformLocation(id, "aberr"), 1, m_aberr_scale);
-    glUniform1f(glGetUniformLocation(id, "WarpScale"), m_warp_scale*m_warp_adj);
-    glUniform4fv(glGetUniformLocation(id, "HmdWarpParam"), 1, m_distortion_coeffs);
-    glUniform2fv(glGetUniformLocation(id, "LensCenterLeft"), 1, m_left_lens_center);
-    glUniform2fv(glGetUniformLocation(id, "LensCenterRight"), 1, m_right_lens_center);
+    // Only the values that changed since the last frame are sent to the driver
+    m_shaderParams.setInt(m_uniforms.warpTexture, 2);
+    m_shaderParams.setVec(m_uniforms.viewportScale, m_viewport_scale);
+    m_shaderParams.setVec(m_uniforms.aberr, m_aberr_scale);
+    m_shaderParams.setFloat(m_uniforms.warpScale, m_warp_scale*m_warp_adj);
+    m_shaderParams.setVec(m_uniforms.hmdWarpParam, m_distortion_coeffs);
+    m_shaderParams.setVec(m_uniforms.lensCenterLeft, m_left_lens_center);
+    m_shaderParams.setVec(m_uniforms.lensCenterRight, m_right_lens_center);
+    m_shaderParams.upload();
+}
+
+void afCameraHMD::getLenses(afHMDLens a_eyes[2])
+{
+    for (int eye = 0 ; eye < 2 ; eye++){
+        afHMDLens &lens = a_eyes[eye];
+        const float* lensCenter = eye == 0 ? m_left_lens_center : m_right_lens_center;
+        for (int i = 0 ; i < 2 ; i++){
+            lens.m_viewportScale[i] = m_viewport_scale[i];
+            lens.m_lensCenter[i] = lensCenter[i];
+        }
+        lens.m_warpScale = m_warp_scale * m_warp_adj;
+        for (int i = 0 ; i < 4 ; i++){
+            lens.m_warpParam[i] = m_distortion_coeffs[i];
+        }
+        for (int i = 0 ; i < 3 ; i++){
+            lens.m_aberr[i] = m_aberr_scale[i];
+        }
+        lens.m_offset = eye == 0 ? 0.0f : 0.5f;
+    }
 }
 
 void afCameraHMD::makeFullScreen()
@@ -43,6 +43,11 @@
 // To silence warnings on MacOS
 #define GL_SILENCE_DEPRECATION
 #include <afFramework.h>
+#include <yaml-cpp/yaml.h>
+#include "shader_params.h"
+#include "pass_profiler.h"
+#include "resource_cache.h"
+#include "hmd_mesh.h"
 
 using namespace std;
 using namespace ambf;
@@ -59,18 +64,34 @@ public:
 
     void updateHMDParams();
 
+    // Lens warp of both eyes from the current parameters
+    void getLenses(afHMDLens a_eyes[2]);
+
     void makeFullScreen();
 
+    // Rolling per-stage statistics, see afPassProfiler::getStats()
+    afPassProfiler& getProfiler() { return m_profiler; }
+
 protected:
     afCameraPtr m_camera;
     cFrameBufferPtr m_frameBuffer;
+    // Shared with the other HMD cameras through afResourceCache
+    afQuadWorld m_quadWorld;
     cWorld* m_vrWorld;
+    cWorld* m_emptyWorld;
     cMesh* m_quadMesh;
     int m_width;
     int m_height;
     int m_alias_scaling;
     cShaderProgramPtr m_shaderPgm;
 
+    // Per-vertex warp instead of the per-fragment PanoTools model, in a world of its own
+    bool m_useDistortionMesh;
+    cWorld* m_meshWorld;
+
+    // Scene texels the warp never samples, depth-masked in the camera's back layer
+    afHiddenAreaMask* m_hiddenAreaMask;
+
 protected:
     float m_viewport_scale[2];
     float m_distortion_coeffs[4];
@@ -81,6 +102,19 @@ protected:
     float m_warp_scale;
     float m_warp_adj;
     float m_vpos;
+
+    // Cached uniform locations and values of the HMD program
+    afShaderParamBlock m_shaderParams;
+    struct {
+        int warpTexture, viewportScale, aberr, warpScale, hmdWarpParam;
+        int lensCenterLeft, lensCenterRight;
+    } m_uniforms;
+
+    // Stage timings of graphicsUpdate()
+    afPassProfiler m_profiler;
+    struct {
+        int scene, params, distortion;
+    } m_stages;
 };
 
 
@@ -0,0 +1,150 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <pkunjam1@jhu.edu>
+    \author    Punit Kunjam
+*/
+//==============================================================================
+
+#include "hmd_mesh.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+bool afHMDWarp(const afHMDLens &a_lens, const float a_output[2], float a_tc[3][2], float &a_radius)
+{
+    // Same steps as hmd_distortion.fs
+    float r[2];
+    r[0] = (((a_output[0] - a_lens.m_offset) * 2.0f) * a_lens.m_viewportScale[0] - a_lens.m_lensCenter[0]) / a_lens.m_warpScale;
+    r[1] = (a_output[1] * a_lens.m_viewportScale[1] - a_lens.m_lensCenter[1]) / a_lens.m_warpScale;
+    float rMag = sqrt(r[0] * r[0] + r[1] * r[1]);
+    const float* k = a_lens.m_warpParam;
+    float factor = (k[3] + k[2] * rMag + k[1] * rMag * rMag + k[0] * rMag * rMag * rMag) * a_lens.m_warpScale;
+    for (int c = 0 ; c < 3 ; c++){
+        for (int i = 0 ; i < 2 ; i++){
+            a_tc[c][i] = (a_lens.m_lensCenter[i] + a_lens.m_aberr[c] * r[i] * factor) / a_lens.m_viewportScale[i];
+        }
+        a_tc[c][0] = a_tc[c][0] / 2.0f + a_lens.m_offset;
+    }
+    a_radius = rMag;
+    return a_tc[1][0] - a_lens.m_offset >= 0.0f && a_tc[1][0] - a_lens.m_offset <= 0.5f &&
+           a_tc[1][1] >= 0.0f && a_tc[1][1] <= 1.0f;
+}
+
+// Window position of the grid vertex (i, j) of an eye, and whether the lens shows it
+static bool evalGridVertex(const afHMDLens &a_lens, int a_i, int a_j, int a_resolution, float a_lensRadius,
+                           float a_output[2], float a_tc[3][2], float &a_radius)
+{
+    a_output[0] = a_lens.m_offset + 0.5f * a_i / a_resolution;
+    a_output[1] = static_cast<float>(a_j) / a_resolution;
+    bool valid = afHMDWarp(a_lens, a_output, a_tc, a_radius);
+    return valid && (a_lensRadius <= 0.0f || a_radius <= a_lensRadius);
+}
+
+cMesh* afCreateHMDDistortionMesh(const afHMDLens a_eyes[2], int a_resolution, float a_lensRadius)
+{
+    cMesh* mesh = new cMesh();
+    const int n = max(1, a_resolution);
+    const int stride = n + 1;
+    int cells = 0;
+    for (int eye = 0 ; eye < 2 ; eye++){
+        const afHMDLens &lens = a_eyes[eye];
+        vector<unsigned> indices(stride * stride);
+        vector<char> visible(stride * stride);
+        for (int j = 0 ; j <= n ; j++){
+            for (int i = 0 ; i <= n ; i++){
+                float output[2], tc[3][2], radius;
+                visible[j * stride + i] = evalGridVertex(lens, i, j, n, a_lensRadius, output, tc, radius);
+
+                // the quad is drawn with identity matrices, see hmd_distortion_mesh.vs
+                unsigned index = mesh->newVertex(cVector3d(2.0 * output[0] - 1.0, 2.0 * output[1] - 1.0, 0.0));
+                mesh->m_vertices->setTexCoord(index, tc[1][0], tc[1][1], a_lensRadius > 0.0f ? radius / a_lensRadius : 0.0);
+                mesh->m_vertices->setTangent(index, cVector3d(tc[0][0], tc[0][1], lens.m_offset));
+                mesh->m_vertices->setBitangent(index, cVector3d(tc[2][0], tc[2][1], 0.0));
+                indices[j * stride + i] = index;
+            }
+        }
+
+        // A cell is kept when a vertex around it is visible, the fragment stage
+        // clips the boundary exactly
+        for (int j = 0 ; j < n ; j++){
+            for (int i = 0 ; i < n ; i++){
+                bool keep = false;
+                for (int vj = max(0, j - 1) ; vj <= min(n, j + 2) && !keep ; vj++){
+                    for (int vi = max(0, i - 1) ; vi <= min(n, i + 2) && !keep ; vi++){
+                        keep = visible[vj * stride + vi] != 0;
+                    }
+                }
+                if (!keep){
+                    continue;
+                }
+                unsigned v00 = indices[j * stride + i], v10 = indices[j * stride + i + 1];
+                unsigned v01 = indices[(j + 1) * stride + i], v11 = indices[(j + 1) * stride + i + 1];
+                mesh->newTriangle(v00, v10, v11);
+                mesh->newTriangle(v00, v11, v01);
+                cells++;
+            }
+        }
+    }
+    cerr << "[INFO!] HMD distortion mesh: " << cells << " of " << 2 * n * n << " cells shaded" << endl;
+
+    mesh->setUseTexture(true);
+    mesh->setShowEnabled(true);
+    return mesh;
+}
+
+void afMarkHMDSampledCells(const afHMDLens &a_lens, float a_lensRadius, afCellGrid &a_cells)
+{
+    // Several window samples per texture cell so that no sampled cell is missed
+    const int samples = 4 * max(a_cells.getCellsX(), a_cells.getCellsY());
+    for (int j = 0 ; j <= samples ; j++){
+        for (int i = 0 ; i <= samples ; i++){
+            float output[2], tc[3][2], radius;
+            if (!evalGridVertex(a_lens, i, j, samples, a_lensRadius, output, tc, radius)){
+                continue;
+            }
+            for (int c = 0 ; c < 3 ; c++){
+                // Texture coordinates of the eye's viewport, clamped like the sampler
+                a_cells.mark((tc[c][0] - a_lens.m_offset) * 2.0f, tc[c][1]);
+            }
+        }
+    }
+}
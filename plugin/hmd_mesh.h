@@ -0,0 +1,86 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <pkunjam1@jhu.edu>
+    \author    Punit Kunjam
+*/
+//==============================================================================
+
+#ifndef HMD_MESH_H
+#define HMD_MESH_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <vector>
+#include "hidden_area_mask.h"
+
+using namespace std;
+using namespace ambf;
+
+// PanoTools lens warp of one eye, the parameters of example/shaders/hmd_distortion.fs.
+// The eyes are side by side: the left eye covers u in [0, 0.5] of the window and of
+// the scene texture, the right eye [0.5, 1].
+struct afHMDLens{
+    float m_viewportScale[2];
+    float m_lensCenter[2];
+    float m_warpScale;
+    float m_warpParam[4];
+    float m_aberr[3];
+    // 0 for the left eye, 0.5 for the right eye
+    float m_offset;
+};
+
+// Scene texture coordinates of the three color channels seen at window coordinate
+// a_output, and the lens radius there in units of the warp scale. Returns false
+// where the green channel falls off the eye's half of the texture.
+bool afHMDWarp(const afHMDLens &a_lens, const float a_output[2], float a_tc[3][2], float &a_radius);
+
+// Tessellated distortion pass. Every vertex carries the texture coordinates of the
+// three channels, computed on the CPU, so the fragment stage only fetches. Cells
+// the lens never shows are left out of the mesh. a_lensRadius (in units of the
+// warp scale, 0 for no limit) additionally drops everything outside the lens circle.
+cMesh* afCreateHMDDistortionMesh(const afHMDLens a_eyes[2], int a_resolution, float a_lensRadius);
+
+// Mark the cells of a_cells (over the eye's half of the scene texture) that the
+// visible part of the lens samples
+void afMarkHMDSampledCells(const afHMDLens &a_lens, float a_lensRadius, afCellGrid &a_cells);
+
+#endif
@@ -0,0 +1,205 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "offscreen_target.h"
+#include <algorithm>
+
+using namespace std;
+
+afOffscreenTarget::afOffscreenTarget()
+{
+    m_fbo = 0;
+    m_depthBuffer = 0;
+    m_width = 0;
+    m_height = 0;
+    m_previousFbo = 0;
+    for (int i = 0 ; i < 4 ; i++){
+        m_previousViewport[i] = 0;
+    }
+}
+
+afOffscreenTarget::~afOffscreenTarget()
+{
+    // GL objects are released in destroy(), which needs a current context
+}
+
+// Pixel transfer format matching an internal format, for allocating the storage
+static void transferFormat(GLint a_internalFormat, GLenum &a_format, GLenum &a_type)
+{
+    switch (a_internalFormat) {
+    case GL_R32F:
+        a_format = GL_RED;
+        a_type = GL_FLOAT;
+        break;
+    case GL_RG32F:
+        a_format = GL_RG;
+        a_type = GL_FLOAT;
+        break;
+    case GL_RGBA32F:
+    case GL_RGBA16F:
+        a_format = GL_RGBA;
+        a_type = GL_FLOAT;
+        break;
+    default:
+        a_format = GL_RGBA;
+        a_type = GL_UNSIGNED_BYTE;
+        break;
+    }
+}
+
+bool afOffscreenTarget::setup(int a_width, int a_height, const vector<GLint> &a_colorFormats)
+{
+    if (m_fbo != 0 && a_width == m_width && a_height == m_height && a_colorFormats == m_colorFormats){
+        return true;
+    }
+    destroy();
+
+    m_width = a_width;
+    m_height = a_height;
+    m_colorFormats = a_colorFormats;
+
+    GLint previousFbo;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+    m_colorTextures.resize(m_colorFormats.size(), 0);
+    for (size_t i = 0 ; i < m_colorFormats.size() ; i++){
+        GLenum format, type;
+        transferFormat(m_colorFormats[i], format, type);
+        glGenTextures(1, &m_colorTextures[i]);
+        glBindTexture(GL_TEXTURE_2D, m_colorTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, m_colorFormats[i], m_width, m_height, 0, format, type, nullptr);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, m_colorTextures[i], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE){
+        cerr << "ERROR! OFFSCREEN FRAMEBUFFER INCOMPLETE (0x" << hex << status << dec << ")" << endl;
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void afOffscreenTarget::bind()
+{
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_previousFbo);
+    glGetIntegerv(GL_VIEWPORT, m_previousViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    vector<GLenum> drawBuffers(m_colorTextures.size());
+    for (size_t i = 0 ; i < drawBuffers.size() ; i++){
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + (GLenum)i;
+    }
+    glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+    glViewport(0, 0, m_width, m_height);
+}
+
+void afOffscreenTarget::unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_previousFbo);
+    glViewport(m_previousViewport[0], m_previousViewport[1], m_previousViewport[2], m_previousViewport[3]);
+}
+
+void afOffscreenTarget::blitToWindow(int a_width, int a_height)
+{
+    if (m_fbo == 0 || a_width <= 0 || a_height <= 0){
+        return;
+    }
+    double scale = min(static_cast<double>(a_width) / m_width, static_cast<double>(a_height) / m_height);
+    int width = static_cast<int>(m_width * scale + 0.5);
+    int height = static_cast<int>(m_height * scale + 0.5);
+    int x = (a_width - width) / 2;
+    int y = (a_height - height) / 2;
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glDrawBuffer(GL_BACK);
+    glViewport(0, 0, a_width, a_height);
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    // Pixel for pixel when the window matches, no filtering needed
+    GLenum filter = (width == m_width && height == m_height) ? GL_NEAREST : GL_LINEAR;
+    glBlitFramebuffer(0, 0, m_width, m_height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, filter);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void afOffscreenTarget::destroy()
+{
+    if (!m_colorTextures.empty()){
+        glDeleteTextures((GLsizei)m_colorTextures.size(), m_colorTextures.data());
+        m_colorTextures.clear();
+    }
+    if (m_depthBuffer != 0){
+        glDeleteRenderbuffers(1, &m_depthBuffer);
+        m_depthBuffer = 0;
+    }
+    if (m_fbo != 0){
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+    }
+    m_width = 0;
+    m_height = 0;
+}
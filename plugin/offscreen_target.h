@@ -0,0 +1,97 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef OFFSCREEN_TARGET_H
+#define OFFSCREEN_TARGET_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <vector>
+
+using namespace std;
+
+// Framebuffer object with one or more color textures and a depth renderbuffer, used
+// to run the distortion pass without drawing into the window
+class afOffscreenTarget{
+public:
+    afOffscreenTarget();
+    ~afOffscreenTarget();
+
+    // (Re)allocate for the given size. a_colorFormats lists the internal format of
+    // each color attachment, e.g. {GL_RGBA8} or {GL_RGBA8, GL_R32F}
+    bool setup(int a_width, int a_height, const vector<GLint> &a_colorFormats);
+
+    // Bind for drawing, enable all color attachments and set the viewport
+    void bind();
+    void unbind();
+
+    // Scale color attachment 0 into the back buffer of the window, a_width x a_height
+    // pixels, letterboxed to keep the aspect ratio
+    void blitToWindow(int a_width, int a_height);
+
+    // Release the GL objects, needs the owning context to be current
+    void destroy();
+
+    bool isValid() const { return m_fbo != 0; }
+    GLuint getFbo() const { return m_fbo; }
+    GLuint getColorTexture(int a_index) const { return m_colorTextures[a_index]; }
+    int getNumColorAttachments() const { return static_cast<int>(m_colorTextures.size()); }
+    GLint getColorFormat(int a_index) const { return m_colorFormats[a_index]; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+protected:
+    GLuint m_fbo;
+    GLuint m_depthBuffer;
+    vector<GLuint> m_colorTextures;
+    vector<GLint> m_colorFormats;
+    int m_width;
+    int m_height;
+    GLint m_previousFbo;
+    GLint m_previousViewport[4];
+};
+
+#endif
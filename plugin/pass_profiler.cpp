@@ -0,0 +1,315 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "pass_profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+static const size_t RING_SIZE = 4096;
+
+afPassProfiler::afPassProfiler()
+{
+    m_enabled = false;
+    m_latency = 4;
+    m_frameSlot = 0;
+    m_frame = 0;
+    m_head = 0;
+    m_tail = 0;
+    m_dropped = 0;
+    m_reportPeriod = 5.0;
+    m_window = 512;
+    m_stop = false;
+}
+
+afPassProfiler::~afPassProfiler()
+{
+    // The queries are released in disable(), which needs a current context
+    stopReporter();
+}
+
+int afPassProfiler::addStage(const string &a_name)
+{
+    m_stages.push_back(a_name);
+    return static_cast<int>(m_stages.size()) - 1;
+}
+
+void afPassProfiler::enable(const string &a_reportFile, double a_reportPeriod, int a_latency, int a_window)
+{
+    if (m_enabled || m_stages.empty()){
+        return;
+    }
+    int numStages = static_cast<int>(m_stages.size());
+    m_latency = max(a_latency, 2);
+    m_frameSlot = 0;
+    m_frame = 0;
+    m_records.assign(m_latency * numStages, afStageRecord());
+    for (size_t i = 0 ; i < m_records.size() ; i++){
+        m_records[i].m_used = false;
+    }
+    // Timestamp pairs are created on first use, when the context is current
+
+    m_ring.assign(RING_SIZE, afStageSample());
+    m_head = 0;
+    m_tail = 0;
+    m_dropped = 0;
+
+    m_reportFile = a_reportFile;
+    m_reportPeriod = a_reportPeriod > 0.0 ? a_reportPeriod : 5.0;
+    m_window = a_window > 0 ? a_window : 512;
+    m_cpuWindow.assign(numStages, vector<float>());
+    m_gpuWindow.assign(numStages, vector<float>());
+    m_windowPos.assign(numStages, 0);
+    m_sampleCount.assign(numStages, 0);
+
+    if (!m_reportFile.empty()){
+        ofstream file(m_reportFile.c_str(), ios::trunc);
+        file << "# time stage samples cpu_p50_ms cpu_p95_ms cpu_p99_ms gpu_p50_ms gpu_p95_ms gpu_p99_ms" << endl;
+    }
+
+    m_stop = false;
+    m_thread = thread(&afPassProfiler::run, this);
+    m_enabled = true;
+}
+
+void afPassProfiler::disable()
+{
+    if (!m_enabled){
+        return;
+    }
+    stopReporter();
+    if (!m_queries.empty()){
+        glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+        m_queries.clear();
+    }
+}
+
+void afPassProfiler::stopReporter()
+{
+    if (!m_thread.joinable()){
+        return;
+    }
+    m_enabled = false;
+    {
+        lock_guard<mutex> lock(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void afPassProfiler::beginFrame()
+{
+    if (!m_enabled){
+        return;
+    }
+    if (m_queries.empty()){
+        m_queries.resize(m_records.size() * 2);
+        glGenQueries((GLsizei)m_queries.size(), m_queries.data());
+    }
+    m_frame++;
+    m_frameSlot = static_cast<int>(m_frame % m_latency);
+    // This slot was last written m_latency frames ago, its queries are done by now
+    collect(m_frameSlot);
+}
+
+void afPassProfiler::begin(int a_stage)
+{
+    if (!m_enabled || m_queries.empty()){
+        return;
+    }
+    size_t index = m_frameSlot * m_stages.size() + a_stage;
+    afStageRecord &record = m_records[index];
+    record.m_used = true;
+    record.m_start = chrono::steady_clock::now();
+    glQueryCounter(m_queries[index * 2], GL_TIMESTAMP);
+}
+
+void afPassProfiler::end(int a_stage)
+{
+    if (!m_enabled || m_queries.empty()){
+        return;
+    }
+    size_t index = m_frameSlot * m_stages.size() + a_stage;
+    afStageRecord &record = m_records[index];
+    glQueryCounter(m_queries[index * 2 + 1], GL_TIMESTAMP);
+    record.m_cpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - record.m_start).count();
+}
+
+void afPassProfiler::collect(int a_frameSlot)
+{
+    for (size_t stage = 0 ; stage < m_stages.size() ; stage++){
+        size_t index = a_frameSlot * m_stages.size() + stage;
+        afStageRecord &record = m_records[index];
+        if (!record.m_used){
+            continue;
+        }
+        record.m_used = false;
+
+        afStageSample sample;
+        sample.m_stage = static_cast<int>(stage);
+        sample.m_cpuMs = static_cast<float>(record.m_cpuMs);
+        sample.m_gpuMs = -1.0f;
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[index * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available){
+            GLuint64 start = 0, stop = 0;
+            glGetQueryObjectui64v(m_queries[index * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(m_queries[index * 2 + 1], GL_QUERY_RESULT, &stop);
+            sample.m_gpuMs = static_cast<float>((stop - start) * 1e-6);
+        }
+        push(sample);
+    }
+}
+
+void afPassProfiler::push(const afStageSample &a_sample)
+{
+    size_t head = m_head.load(memory_order_relaxed);
+    if (head - m_tail.load(memory_order_acquire) >= m_ring.size()){
+        m_dropped++;
+        return;
+    }
+    m_ring[head % m_ring.size()] = a_sample;
+    m_head.store(head + 1, memory_order_release);
+}
+
+void afPassProfiler::run()
+{
+    chrono::steady_clock::time_point lastReport = chrono::steady_clock::now();
+    unique_lock<mutex> wakeLock(m_wakeMutex);
+    while (!m_stop){
+        m_wake.wait_for(wakeLock, chrono::milliseconds(100));
+
+        // Drain the ring into the rolling windows
+        size_t tail = m_tail.load(memory_order_relaxed);
+        size_t head = m_head.load(memory_order_acquire);
+        {
+            lock_guard<mutex> lock(m_statsMutex);
+            for ( ; tail != head ; tail++){
+                const afStageSample &sample = m_ring[tail % m_ring.size()];
+                int stage = sample.m_stage;
+                if (m_cpuWindow[stage].size() < m_window){
+                    m_cpuWindow[stage].push_back(sample.m_cpuMs);
+                    m_gpuWindow[stage].push_back(sample.m_gpuMs);
+                }
+                else{
+                    m_cpuWindow[stage][m_windowPos[stage]] = sample.m_cpuMs;
+                    m_gpuWindow[stage][m_windowPos[stage]] = sample.m_gpuMs;
+                }
+                m_windowPos[stage] = (m_windowPos[stage] + 1) % m_window;
+                m_sampleCount[stage]++;
+            }
+        }
+        m_tail.store(tail, memory_order_release);
+
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (!m_reportFile.empty() && chrono::duration<double>(now - lastReport).count() >= m_reportPeriod){
+            writeReport();
+            lastReport = now;
+        }
+    }
+}
+
+static double percentile(vector<float> &a_values, double a_fraction)
+{
+    if (a_values.empty()){
+        return -1.0;
+    }
+    size_t index = min(a_values.size() - 1, (size_t)(a_fraction * (a_values.size() - 1) + 0.5));
+    nth_element(a_values.begin(), a_values.begin() + index, a_values.end());
+    return a_values[index];
+}
+
+afStageStats afPassProfiler::computeStats(int a_stage)
+{
+    afStageStats stats;
+    stats.m_name = m_stages[a_stage];
+    stats.m_samples = m_sampleCount.empty() ? 0 : m_sampleCount[a_stage];
+
+    vector<float> cpu, gpu;
+    if (!m_cpuWindow.empty()){
+        cpu = m_cpuWindow[a_stage];
+        for (size_t i = 0 ; i < m_gpuWindow[a_stage].size() ; i++){
+            if (m_gpuWindow[a_stage][i] >= 0.0f){
+                gpu.push_back(m_gpuWindow[a_stage][i]);
+            }
+        }
+    }
+    stats.m_cpuP50 = percentile(cpu, 0.50);
+    stats.m_cpuP95 = percentile(cpu, 0.95);
+    stats.m_cpuP99 = percentile(cpu, 0.99);
+    stats.m_gpuP50 = percentile(gpu, 0.50);
+    stats.m_gpuP95 = percentile(gpu, 0.95);
+    stats.m_gpuP99 = percentile(gpu, 0.99);
+    return stats;
+}
+
+vector<afStageStats> afPassProfiler::getStats()
+{
+    lock_guard<mutex> lock(m_statsMutex);
+    vector<afStageStats> stats;
+    for (size_t stage = 0 ; stage < m_stages.size() ; stage++){
+        stats.push_back(computeStats(static_cast<int>(stage)));
+    }
+    return stats;
+}
+
+void afPassProfiler::writeReport()
+{
+    vector<afStageStats> stats = getStats();
+    double time = chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+    ofstream file(m_reportFile.c_str(), ios::app);
+    if (!file){
+        return;
+    }
+    file << fixed;
+    for (size_t i = 0 ; i < stats.size() ; i++){
+        file << setprecision(3) << time << " " << stats[i].m_name << " " << stats[i].m_samples << setprecision(4)
+             << " " << stats[i].m_cpuP50 << " " << stats[i].m_cpuP95 << " " << stats[i].m_cpuP99
+             << " " << stats[i].m_gpuP50 << " " << stats[i].m_gpuP95 << " " << stats[i].m_gpuP99 << endl;
+    }
+}
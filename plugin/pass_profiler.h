@@ -0,0 +1,164 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef PASS_PROFILER_H
+#define PASS_PROFILER_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct afStageStats {
+    string m_name;
+    unsigned long m_samples;
+    // Milliseconds over the rolling window, GPU values are -1 without timer queries
+    double m_cpuP50, m_cpuP95, m_cpuP99;
+    double m_gpuP50, m_gpuP95, m_gpuP99;
+};
+
+// Per-stage timing of a render loop. Every stage records a CPU steady-clock span
+// and a pair of GPU timestamp queries. The queries of a frame are read back
+// a_latency frames later so that the render thread never waits on them, and the
+// samples go through a fixed-size single-producer ring to a reporter thread that
+// keeps rolling p50/p95/p99 and periodically writes them to a file.
+// Disabled (the default), begin()/end() return right away.
+class afPassProfiler{
+public:
+    afPassProfiler();
+    ~afPassProfiler();
+
+    // Stages are registered before enable(), the index is passed to begin()/end()
+    int addStage(const string &a_name);
+
+    // a_reportFile may be empty, the statistics are then only available through getStats()
+    void enable(const string &a_reportFile = "", double a_reportPeriod = 5.0, int a_latency = 4, int a_window = 512);
+    void disable();
+    bool isEnabled() const { return m_enabled; }
+
+    // Call once per graphicsUpdate before the first stage, with the context current
+    void beginFrame();
+    // A stage is timed at most once per frame, a second span replaces the first
+    void begin(int a_stage);
+    void end(int a_stage);
+
+    // Snapshot of the rolling statistics, safe to call from any thread
+    vector<afStageStats> getStats();
+
+    // Samples lost because the reporter fell behind
+    unsigned long getDroppedSamples() const { return m_dropped; }
+
+protected:
+    struct afStageSample{
+        int m_stage;
+        float m_cpuMs;
+        float m_gpuMs;
+    };
+
+    // CPU span and GPU queries of one stage in one frame of the latency ring
+    struct afStageRecord{
+        bool m_used;
+        chrono::steady_clock::time_point m_start;
+        double m_cpuMs;
+    };
+
+    void collect(int a_frameSlot);
+    void push(const afStageSample &a_sample);
+    void run();
+    void stopReporter();
+    void writeReport();
+    afStageStats computeStats(int a_stage);
+
+    bool m_enabled;
+    vector<string> m_stages;
+
+    // Render thread side
+    int m_latency;
+    int m_frameSlot;
+    unsigned long m_frame;
+    vector<GLuint> m_queries;
+    vector<afStageRecord> m_records;
+
+    // Single-producer single-consumer sample ring
+    vector<afStageSample> m_ring;
+    atomic<size_t> m_head;
+    atomic<size_t> m_tail;
+    atomic<unsigned long> m_dropped;
+
+    // Reporter thread side
+    string m_reportFile;
+    double m_reportPeriod;
+    size_t m_window;
+    vector<vector<float> > m_cpuWindow;
+    vector<vector<float> > m_gpuWindow;
+    vector<size_t> m_windowPos;
+    vector<unsigned long> m_sampleCount;
+    mutex m_statsMutex;
+    mutex m_wakeMutex;
+    condition_variable m_wake;
+    thread m_thread;
+    bool m_stop;
+};
+
+// Times a stage for the duration of a scope
+class afProfileScope{
+public:
+    afProfileScope(afPassProfiler &a_profiler, int a_stage): m_profiler(a_profiler), m_stage(a_stage) { m_profiler.begin(m_stage); }
+    ~afProfileScope() { m_profiler.end(m_stage); }
+
+protected:
+    afPassProfiler &m_profiler;
+    int m_stage;
+};
+
+#endif
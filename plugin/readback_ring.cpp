@@ -0,0 +1,222 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "readback_ring.h"
+#include <cstring>
+
+using namespace std;
+
+afReadbackRing::afReadbackRing()
+{
+    m_head = 0;
+    m_pending = 0;
+    m_captureDepth = false;
+    m_delivered = 0;
+    m_stalls = 0;
+}
+
+afReadbackRing::~afReadbackRing()
+{
+    // GL objects are released in destroy(), which needs a current context
+}
+
+void afReadbackRing::setup(int a_numSlots, bool a_captureDepth)
+{
+    destroy();
+    afReadbackSlot empty;
+    memset(&empty, 0, sizeof(empty));
+    m_slots.assign(a_numSlots > 1 ? a_numSlots : 2, empty);
+    m_captureDepth = a_captureDepth;
+}
+
+void afReadbackRing::readback(int a_width, int a_height, unsigned long a_index, double a_simTime, uint64_t a_paramsHash)
+{
+    if (m_slots.empty()){
+        return;
+    }
+
+    // The oldest frame occupies the slot we are about to write, it has to go out first
+    if (m_pending == static_cast<int>(m_slots.size())){
+        int oldest = (m_head - m_pending + (int)m_slots.size()) % (int)m_slots.size();
+        if (!isReady(m_slots[oldest])){
+            m_stalls++;
+        }
+        deliver(m_slots[oldest]);
+        m_pending--;
+    }
+
+    afReadbackSlot &slot = m_slots[m_head];
+    size_t numPixels = (size_t)a_width * (size_t)a_height;
+    if (slot.m_colorPbo == 0){
+        glGenBuffers(1, &slot.m_colorPbo);
+    }
+    if (m_captureDepth && slot.m_depthPbo == 0){
+        glGenBuffers(1, &slot.m_depthPbo);
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.m_colorPbo);
+    if (a_width != slot.m_width || a_height != slot.m_height){
+        glBufferData(GL_PIXEL_PACK_BUFFER, numPixels * 4, nullptr, GL_STREAM_READ);
+    }
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, a_width, a_height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    if (m_captureDepth){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.m_depthPbo);
+        if (a_width != slot.m_width || a_height != slot.m_height){
+            glBufferData(GL_PIXEL_PACK_BUFFER, numPixels * sizeof(float), nullptr, GL_STREAM_READ);
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glReadPixels(0, 0, a_width, a_height, GL_RED, GL_FLOAT, 0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.m_width = a_width;
+    slot.m_height = a_height;
+    slot.m_index = a_index;
+    slot.m_simTime = a_simTime;
+    slot.m_renderTime = glfwGetTime();
+    slot.m_paramsHash = a_paramsHash;
+
+    m_head = (m_head + 1) % (int)m_slots.size();
+    m_pending++;
+
+    // Hand out whatever the GPU already finished, oldest first to keep the order
+    while (m_pending > 1){
+        int oldest = (m_head - m_pending + (int)m_slots.size()) % (int)m_slots.size();
+        if (!isReady(m_slots[oldest])){
+            break;
+        }
+        deliver(m_slots[oldest]);
+        m_pending--;
+    }
+}
+
+void afReadbackRing::flush()
+{
+    while (m_pending > 0){
+        int oldest = (m_head - m_pending + (int)m_slots.size()) % (int)m_slots.size();
+        deliver(m_slots[oldest]);
+        m_pending--;
+    }
+}
+
+void afReadbackRing::destroy()
+{
+    for (size_t i = 0 ; i < m_slots.size() ; i++){
+        afReadbackSlot &slot = m_slots[i];
+        if (slot.m_fence){
+            glDeleteSync(slot.m_fence);
+        }
+        if (slot.m_colorPbo){
+            glDeleteBuffers(1, &slot.m_colorPbo);
+        }
+        if (slot.m_depthPbo){
+            glDeleteBuffers(1, &slot.m_depthPbo);
+        }
+        memset(&slot, 0, sizeof(slot));
+    }
+    m_head = 0;
+    m_pending = 0;
+}
+
+bool afReadbackRing::isReady(afReadbackSlot &a_slot)
+{
+    if (!a_slot.m_fence){
+        return true;
+    }
+    GLenum status = glClientWaitSync(a_slot.m_fence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+void afReadbackRing::deliver(afReadbackSlot &a_slot)
+{
+    if (a_slot.m_fence){
+        // Returns at once if the copy is already done
+        glClientWaitSync(a_slot.m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(a_slot.m_fence);
+        a_slot.m_fence = 0;
+    }
+
+    afFrame frame;
+    frame.m_index = a_slot.m_index;
+    frame.m_width = a_slot.m_width;
+    frame.m_height = a_slot.m_height;
+    frame.m_simTime = a_slot.m_simTime;
+    frame.m_renderTime = a_slot.m_renderTime;
+    frame.m_paramsHash = a_slot.m_paramsHash;
+    size_t numPixels = (size_t)a_slot.m_width * (size_t)a_slot.m_height;
+
+    // Both stay mapped for the callback, which copies only what it keeps
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, a_slot.m_colorPbo);
+    const unsigned char* color = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, numPixels * 4, GL_MAP_READ_BIT);
+    const float* depth = nullptr;
+    if (m_captureDepth && a_slot.m_depthPbo){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, a_slot.m_depthPbo);
+        depth = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, numPixels * sizeof(float), GL_MAP_READ_BIT);
+    }
+    frame.m_mappedRgba = color;
+    frame.m_mappedDepth = depth;
+
+    frame.m_readyTime = glfwGetTime();
+    m_delivered++;
+    if (m_callback && color){
+        m_callback(frame);
+    }
+
+    if (depth){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, a_slot.m_depthPbo);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    if (color){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, a_slot.m_colorPbo);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,116 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef READBACK_RING_H
+#define READBACK_RING_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <functional>
+#include <vector>
+#include "frame.h"
+
+using namespace std;
+
+// The frame points into the mapped buffers, see afFrame::retain()
+typedef function<void(afFrame &a_frame)> afFrameCallback;
+
+// Ring of pixel buffer objects for reading frames back without stalling the render
+// thread. readback() only queues the copy on the GPU; the frame is mapped and handed
+// to the callback once its fence has signaled, at the latest when its slot is needed
+// again a_numSlots frames later.
+class afReadbackRing{
+public:
+    afReadbackRing();
+    ~afReadbackRing();
+
+    void setup(int a_numSlots, bool a_captureDepth);
+    void setCallback(const afFrameCallback &a_callback) { m_callback = a_callback; }
+
+    // Queue a read of color attachment 0 (and the linear depth in attachment 1) of the
+    // bound read framebuffer. The metadata describes the frame as it is rendered now,
+    // it is delivered with the pixels.
+    void readback(int a_width, int a_height, unsigned long a_index, double a_simTime, uint64_t a_paramsHash);
+
+    // Deliver the frames still in flight, blocks until the GPU is done
+    void flush();
+
+    // Release the GL objects, needs the owning context to be current
+    void destroy();
+
+    int getNumSlots() const { return static_cast<int>(m_slots.size()); }
+    bool getCaptureDepth() const { return m_captureDepth; }
+    unsigned long getDeliveredCount() const { return m_delivered; }
+    // Number of times a frame was not finished on the GPU when its slot was reused
+    unsigned long getStallCount() const { return m_stalls; }
+
+protected:
+    struct afReadbackSlot{
+        GLuint m_colorPbo;
+        GLuint m_depthPbo;
+        GLsync m_fence;
+        int m_width;
+        int m_height;
+        unsigned long m_index;
+        double m_simTime;
+        double m_renderTime;
+        uint64_t m_paramsHash;
+    };
+
+    bool isReady(afReadbackSlot &a_slot);
+    void deliver(afReadbackSlot &a_slot);
+
+    vector<afReadbackSlot> m_slots;
+    // Next slot to write and number of slots waiting to be delivered
+    int m_head;
+    int m_pending;
+    bool m_captureDepth;
+    afFrameCallback m_callback;
+    unsigned long m_delivered;
+    unsigned long m_stalls;
+};
+
+#endif
@@ -0,0 +1,369 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "resource_cache.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+afResourceCache& afResourceCache::getInstance()
+{
+    static afResourceCache cache;
+    return cache;
+}
+
+afResourceCache::afResourceCache()
+{
+    m_emptyWorld.m_resource = nullptr;
+    m_emptyWorld.m_refs = 0;
+    m_warpMapRetention = 0;
+}
+
+cShaderProgramPtr afResourceCache::acquireProgram(const string &a_vertexShader, const string &a_fragmentShader, const string &a_name,
+                                                  const string &a_defines)
+{
+    lock_guard<mutex> lock(m_mutex);
+    string key = a_vertexShader + "|" + a_fragmentShader + "|" + a_defines;
+    map<string, afCacheEntry<cShaderProgramPtr> >::iterator it = m_programs.find(key);
+    if (it != m_programs.end()){
+        it->second.m_refs++;
+        return it->second.m_resource;
+    }
+
+    cShaderProgramPtr program = createProgram(a_vertexShader, a_fragmentShader, a_name, a_defines);
+    if (!program){
+        return program;
+    }
+    afCacheEntry<cShaderProgramPtr> entry = {program, 1};
+    m_programs[key] = entry;
+    return program;
+}
+
+cShaderProgramPtr afResourceCache::createProgram(const string &a_vertexShader, const string &a_fragmentShader, const string &a_name,
+                                                 const string &a_defines)
+{
+    if (a_defines.empty()){
+        afShaderAttributes shaderAttribs;
+        shaderAttribs.m_shaderDefined = true;
+        shaderAttribs.m_vtxFilepath = a_vertexShader;
+        shaderAttribs.m_fragFilepath = a_fragmentShader;
+        return afShaderUtils::createFromAttribs(&shaderAttribs, a_name, a_name);
+    }
+
+    // afShaderUtils only takes file names, variants are compiled from the edited sources
+    cShaderPtr vertexShader = compileShader(C_VERTEX_SHADER, a_vertexShader, a_defines);
+    cShaderPtr fragmentShader = compileShader(C_FRAGMENT_SHADER, a_fragmentShader, a_defines);
+    if (!vertexShader || !fragmentShader){
+        cerr << "ERROR! Failed to build the shader variant " << a_name << " with" << endl << a_defines;
+        return nullptr;
+    }
+    cShaderProgramPtr program = cShaderProgram::create();
+    program->attachShader(vertexShader);
+    program->attachShader(fragmentShader);
+    program->linkProgram();
+    if (!program->isLinked()){
+        cerr << "ERROR! Failed to link the shader variant " << a_name << " with" << endl << a_defines;
+        return nullptr;
+    }
+    return program;
+}
+
+cShaderPtr afResourceCache::compileShader(cShaderType a_type, const string &a_filename, const string &a_defines)
+{
+    ifstream file(a_filename.c_str());
+    if (!file){
+        cerr << "ERROR! Can't open " << a_filename << endl;
+        return nullptr;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string source = buffer.str();
+
+    // #version has to stay the first statement
+    size_t insertAt = 0;
+    size_t version = source.find("#version");
+    if (version != string::npos && source.find_first_not_of(" \t\r\n", 0) == version){
+        insertAt = source.find('\n', version);
+        insertAt = insertAt == string::npos ? source.size() : insertAt + 1;
+    }
+    source.insert(insertAt, a_defines);
+
+    cShaderPtr shader = cShader::create(a_type);
+    shader->loadSourceCode(source);
+    if (!shader->compile()){
+        cerr << "ERROR! Compiling " << a_filename << ": " << shader->getLog() << endl;
+        return nullptr;
+    }
+    return shader;
+}
+
+cShaderProgramPtr afResourceCache::reloadProgram(const cShaderProgramPtr &a_program, const string &a_vertexShader,
+                                                 const string &a_fragmentShader, const string &a_name, const string &a_defines)
+{
+    cShaderProgramPtr program = createProgram(a_vertexShader, a_fragmentShader, a_name, a_defines);
+    if (!program || !program->isLinked()){
+        return nullptr;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    string key = a_vertexShader + "|" + a_fragmentShader + "|" + a_defines;
+    map<string, afCacheEntry<cShaderProgramPtr> >::iterator it = m_programs.find(key);
+    if (it != m_programs.end() && it->second.m_resource == a_program){
+        // Other holders keep the old program under a key of its own, releaseProgram()
+        // finds entries by program
+        if (--it->second.m_refs > 0){
+            stringstream staleKey;
+            staleKey << key << "#" << a_program->getId();
+            m_programs[staleKey.str()] = it->second;
+        }
+        m_programs.erase(key);
+    }
+    else{
+        for (it = m_programs.begin() ; it != m_programs.end() ; ++it){
+            if (it->second.m_resource == a_program){
+                if (--it->second.m_refs == 0){
+                    m_programs.erase(it);
+                }
+                break;
+            }
+        }
+    }
+    afCacheEntry<cShaderProgramPtr> entry = {program, 1};
+    if (m_programs.count(key)){
+        // Another camera already reloaded the same files, share its program
+        m_programs[key].m_refs++;
+        return m_programs[key].m_resource;
+    }
+    m_programs[key] = entry;
+    return program;
+}
+
+void afResourceCache::releaseProgram(const cShaderProgramPtr &a_program)
+{
+    lock_guard<mutex> lock(m_mutex);
+    for (map<string, afCacheEntry<cShaderProgramPtr> >::iterator it = m_programs.begin() ; it != m_programs.end() ; ++it){
+        if (it->second.m_resource == a_program){
+            if (--it->second.m_refs == 0){
+                m_programs.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+cMesh* afResourceCache::createQuadMesh()
+{
+    // Set two sets of trinangles
+    cMesh* quadMesh = new cMesh();
+    float quad[] = {
+        // positions
+         -1.0f,  1.0f, 0.0f,
+         -1.0f, -1.0f, 0.0f,
+          1.0f, -1.0f, 0.0f,
+         -1.0f,  1.0f, 0.0f,
+          1.0f, -1.0f, 0.0f,
+          1.0f,  1.0f, 0.0f,
+    };
+
+    // Create triangles to set Texture coordinate
+    for (int vI = 0 ; vI < 2 ; vI++){
+        int off = vI * 9;
+        cVector3d v0(quad[off + 0], quad[off + 1], quad[off + 2]);
+        cVector3d v1(quad[off + 3], quad[off + 4], quad[off + 5]);
+        cVector3d v2(quad[off + 6], quad[off + 7], quad[off + 8]);
+        quadMesh->newTriangle(v0, v1, v2);
+    }
+
+    quadMesh->m_vertices->setTexCoord(1, 0.0, 0.0, 1.0);
+    quadMesh->m_vertices->setTexCoord(2, 1.0, 0.0, 1.0);
+    quadMesh->m_vertices->setTexCoord(0, 0.0, 1.0, 1.0);
+    quadMesh->m_vertices->setTexCoord(3, 0.0, 1.0, 1.0);
+    quadMesh->m_vertices->setTexCoord(4, 1.0, 0.0, 1.0);
+    quadMesh->m_vertices->setTexCoord(5, 1.0, 1.0, 1.0);
+
+    quadMesh->computeAllNormals();
+    quadMesh->setUseTexture(true);
+    quadMesh->setShowEnabled(true);
+    return quadMesh;
+}
+
+afQuadWorld afResourceCache::acquireQuadWorld(const cShaderProgramPtr &a_program)
+{
+    lock_guard<mutex> lock(m_mutex);
+    GLuint key = a_program->getId();
+    map<GLuint, afCacheEntry<afQuadWorld> >::iterator it = m_quadWorlds.find(key);
+    if (it != m_quadWorlds.end()){
+        it->second.m_refs++;
+        return it->second.m_resource;
+    }
+
+    afQuadWorld quadWorld;
+    quadWorld.m_quadMesh = createQuadMesh();
+    quadWorld.m_quadMesh->setShaderProgram(a_program);
+    quadWorld.m_world = new cWorld();
+    quadWorld.m_world->addChild(quadWorld.m_quadMesh);
+    afCacheEntry<afQuadWorld> entry = {quadWorld, 1};
+    m_quadWorlds[key] = entry;
+    return quadWorld;
+}
+
+void afResourceCache::releaseQuadWorld(const afQuadWorld &a_quadWorld)
+{
+    lock_guard<mutex> lock(m_mutex);
+    for (map<GLuint, afCacheEntry<afQuadWorld> >::iterator it = m_quadWorlds.begin() ; it != m_quadWorlds.end() ; ++it){
+        if (it->second.m_resource.m_world == a_quadWorld.m_world){
+            if (--it->second.m_refs == 0){
+                // The world deletes its children
+                delete it->second.m_resource.m_world;
+                m_quadWorlds.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+cWorld* afResourceCache::acquireEmptyWorld()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_emptyWorld.m_refs++ == 0){
+        m_emptyWorld.m_resource = new cWorld();
+    }
+    return m_emptyWorld.m_resource;
+}
+
+void afResourceCache::releaseEmptyWorld()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_emptyWorld.m_refs > 0 && --m_emptyWorld.m_refs == 0){
+        delete m_emptyWorld.m_resource;
+        m_emptyWorld.m_resource = nullptr;
+    }
+}
+
+string afResourceCache::warpMapKey(const CameraParams &a_params, int a_width, int a_height, afWarpMapType a_type)
+{
+    // A remap is shared by every output size
+    if (a_type == afWarpMapType::REMAP){
+        a_width = 0;
+        a_height = 0;
+    }
+    stringstream key;
+    key << hex << cameraParamsHash(a_params) << dec << "_" << a_width << "x" << a_height << "_" << static_cast<int>(a_type);
+    return key.str();
+}
+
+shared_ptr<afWarpMap> afResourceCache::acquireWarpMap(const CameraParams &a_params, int a_width, int a_height,
+                                                      afWarpMapType a_type, const shared_ptr<afWarpMap> &a_prebuilt)
+{
+    lock_guard<mutex> lock(m_mutex);
+    string key = warpMapKey(a_params, a_width, a_height, a_type);
+    map<string, afCacheEntry<shared_ptr<afWarpMap> > >::iterator it = m_warpMaps.find(key);
+    // The hash only selects the entry, the params are compared in full
+    if (it != m_warpMaps.end() && !it->second.m_resource->isStale(a_params, a_width, a_height, a_type)){
+        if (it->second.m_refs == 0){
+            m_unusedWarpMaps.remove(key);
+        }
+        it->second.m_refs++;
+        return it->second.m_resource;
+    }
+
+    shared_ptr<afWarpMap> warpMap = a_prebuilt;
+    if (!warpMap || warpMap->isStale(a_params, a_width, a_height, a_type)){
+        warpMap = make_shared<afWarpMap>();
+        if (!warpMap->build(a_params, a_width, a_height, a_type)){
+            return nullptr;
+        }
+    }
+    warpMap->upload();
+    if (it == m_warpMaps.end()){
+        afCacheEntry<shared_ptr<afWarpMap> > entry = {warpMap, 1};
+        m_warpMaps[key] = entry;
+    }
+    return warpMap;
+}
+
+void afResourceCache::releaseWarpMap(const shared_ptr<afWarpMap> &a_warpMap)
+{
+    if (!a_warpMap){
+        return;
+    }
+    lock_guard<mutex> lock(m_mutex);
+    for (map<string, afCacheEntry<shared_ptr<afWarpMap> > >::iterator it = m_warpMaps.begin() ; it != m_warpMaps.end() ; ++it){
+        if (it->second.m_resource == a_warpMap){
+            if (--it->second.m_refs == 0){
+                m_unusedWarpMaps.push_front(it->first);
+                evictUnusedWarpMaps();
+            }
+            return;
+        }
+    }
+    // Built on a hash collision and never cached
+    a_warpMap->destroy();
+}
+
+void afResourceCache::retainUnusedWarpMaps(int a_count)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_warpMapRetention += a_count;
+}
+
+void afResourceCache::releaseUnusedWarpMaps(int a_count)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_warpMapRetention = max(0, m_warpMapRetention - a_count);
+    evictUnusedWarpMaps();
+}
+
+void afResourceCache::evictUnusedWarpMaps()
+{
+    while (static_cast<int>(m_unusedWarpMaps.size()) > m_warpMapRetention){
+        map<string, afCacheEntry<shared_ptr<afWarpMap> > >::iterator it = m_warpMaps.find(m_unusedWarpMaps.back());
+        it->second.m_resource->destroy();
+        m_warpMaps.erase(it);
+        m_unusedWarpMaps.pop_back();
+    }
+}
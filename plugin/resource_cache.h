@@ -0,0 +1,151 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "camera_params.h"
+#include "warp_map.h"
+
+using namespace std;
+using namespace ambf;
+
+// Quad mesh with the distortion program, in its own world
+struct afQuadWorld {
+    cWorld* m_world;
+    cMesh* m_quadMesh;
+};
+
+// Process-wide, reference counted GPU resources of the distortion plugins. Cameras
+// with the same shaders share one program and one quad world, cameras with the
+// same calibration and output size share one warp map. AMBF creates the camera
+// windows with a shared context, so textures, buffers and programs are visible to
+// every camera; framebuffers are not shareable and stay per camera. Every acquire
+// is paired with a release in the plugin's close(), the last release frees the
+// resource (warp maps may be retained, see retainUnusedWarpMaps()) and needs a
+// current context.
+class afResourceCache{
+public:
+    static afResourceCache& getInstance();
+
+    // Program built from the two shader files, compiled once per (vertex, fragment,
+    // defines). a_defines are preprocessor lines (e.g. "#define CHROMATIC 0\n")
+    // inserted after the #version line of both sources, to build specialized variants.
+    cShaderProgramPtr acquireProgram(const string &a_vertexShader, const string &a_fragmentShader, const string &a_name,
+                                     const string &a_defines = "");
+    void releaseProgram(const cShaderProgramPtr &a_program);
+
+    // Recompile the pair of shader files of a_program, e.g. after they were edited.
+    // On success the new program replaces a_program for this caller and for later
+    // acquires, cameras still holding a_program keep it until they release it. On
+    // failure nullptr is returned and a_program stays valid.
+    cShaderProgramPtr reloadProgram(const cShaderProgramPtr &a_program, const string &a_vertexShader,
+                                    const string &a_fragmentShader, const string &a_name, const string &a_defines = "");
+
+    // Full screen quad using a_program. The texture is per camera, callers assign
+    // m_quadMesh->m_texture before every render
+    afQuadWorld acquireQuadWorld(const cShaderProgramPtr &a_program);
+    void releaseQuadWorld(const afQuadWorld &a_quadWorld);
+
+    // Empty world swapped in as the front layer of the distortion pass
+    cWorld* acquireEmptyWorld();
+    void releaseEmptyWorld();
+
+    // Built and uploaded on the first acquire of a (params, size, type). a_prebuilt,
+    // a map built off the render thread, is used instead of building one if it matches.
+    // Null, and nothing is cached, if the map can not be built.
+    shared_ptr<afWarpMap> acquireWarpMap(const CameraParams &a_params, int a_width, int a_height,
+                                         afWarpMapType a_type = afWarpMapType::UV,
+                                         const shared_ptr<afWarpMap> &a_prebuilt = nullptr);
+    void releaseWarpMap(const shared_ptr<afWarpMap> &a_warpMap);
+
+    // Keep up to a_count more warp maps alive after their last release, least
+    // recently used first out, so that a camera moving through a set of parameters
+    // (e.g. zoom settings) and back acquires them again without a rebuild. Every
+    // retain is paired with a release of the same count.
+    void retainUnusedWarpMaps(int a_count);
+    void releaseUnusedWarpMaps(int a_count);
+
+    int getNumPrograms() const { return static_cast<int>(m_programs.size()); }
+    int getNumQuadWorlds() const { return static_cast<int>(m_quadWorlds.size()); }
+    int getNumWarpMaps() const { return static_cast<int>(m_warpMaps.size()); }
+
+protected:
+    afResourceCache();
+
+    template <class T>
+    struct afCacheEntry {
+        T m_resource;
+        int m_refs;
+    };
+
+    // Destroy the least recently released warp maps past m_warpMapRetention
+    void evictUnusedWarpMaps();
+
+    static string warpMapKey(const CameraParams &a_params, int a_width, int a_height, afWarpMapType a_type);
+    static cMesh* createQuadMesh();
+    static cShaderProgramPtr createProgram(const string &a_vertexShader, const string &a_fragmentShader, const string &a_name,
+                                           const string &a_defines);
+    static cShaderPtr compileShader(cShaderType a_type, const string &a_filename, const string &a_defines);
+
+    mutex m_mutex;
+    map<string, afCacheEntry<cShaderProgramPtr> > m_programs;
+    map<GLuint, afCacheEntry<afQuadWorld> > m_quadWorlds;
+    map<string, afCacheEntry<shared_ptr<afWarpMap> > > m_warpMaps;
+    // Keys of the warp maps without references, most recently released first
+    list<string> m_unusedWarpMaps;
+    int m_warpMapRetention;
+    afCacheEntry<cWorld*> m_emptyWorld;
+};
+
+#endif
@@ -0,0 +1,116 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "rolling_shutter.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Longer frame intervals are treated as cuts rather than motion
+static const double MAX_FRAME_INTERVAL = 0.5;
+
+// Most poses averaged per row, as MAX_SHUTTER_SAMPLES in the shader
+static const int MAX_SHUTTER_SAMPLES = 16;
+
+// Camera frame of Chai3D (x forward, y left, z up) to the one of the lens models
+static void toLensFrame(const cVector3d &a_v, float a_out[3])
+{
+    a_out[0] = static_cast<float>(-a_v.y());
+    a_out[1] = static_cast<float>(-a_v.z());
+    a_out[2] = static_cast<float>(a_v.x());
+}
+
+afRollingShutter::afRollingShutter()
+{
+    m_readoutTime = 0.0;
+    m_exposureTime = 0.0;
+    m_samples = 1;
+    m_hasPose = false;
+    m_time = 0.0;
+    for (int i = 0 ; i < 3 ; i++){
+        m_linearVelocity[i] = 0.0f;
+        m_angularVelocity[i] = 0.0f;
+    }
+}
+
+void afRollingShutter::setExposureTime(double a_time, int a_samples)
+{
+    m_exposureTime = max(a_time, 0.0);
+    // A single pose when the exposure is instantaneous
+    m_samples = m_exposureTime > 0.0 ? min(max(a_samples, 1), MAX_SHUTTER_SAMPLES) : 1;
+}
+
+void afRollingShutter::update(cCamera* a_camera, double a_time)
+{
+    const cVector3d pos = a_camera->getGlobalPos();
+    const cMatrix3d rot = a_camera->getGlobalRot();
+    const double dt = a_time - m_time;
+
+    cVector3d linear, angular;
+    if (m_hasPose && dt > 0.0 && dt <= MAX_FRAME_INTERVAL){
+        // Last pose in the current camera frame, X_cur = delta * X_last + offset
+        const cMatrix3d rotT = rot.getTranspose();
+        const cMatrix3d delta = rotT * m_rot;
+        const cVector3d offset = rotT * (m_pos - pos);
+
+        // Rotation vector of delta
+        double c = (delta(0, 0) + delta(1, 1) + delta(2, 2) - 1.0) / 2.0;
+        double theta = acos(max(-1.0, min(1.0, c)));
+        double k = theta < 1e-9 ? 0.5 : theta / (2.0 * sin(theta));
+        cVector3d w((delta(2, 1) - delta(1, 2)) * k, (delta(0, 2) - delta(2, 0)) * k, (delta(1, 0) - delta(0, 1)) * k);
+
+        // Constant velocity that lands on the last pose dt seconds ago
+        linear = offset * (-1.0 / dt);
+        angular = w * (-1.0 / dt);
+    }
+    toLensFrame(linear, m_linearVelocity);
+    toLensFrame(angular, m_angularVelocity);
+
+    m_pos = pos;
+    m_rot = rot;
+    m_time = a_time;
+    m_hasPose = true;
+}
@@ -0,0 +1,100 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef ROLLING_SHUTTER_H
+#define ROLLING_SHUTTER_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+
+using namespace std;
+using namespace ambf;
+
+// Rolling shutter and motion blur of the distortion pass. Rather than rendering the
+// scene once per readout time, the camera velocity is estimated from its pose in the
+// last two frames and the shader reprojects every output row, through the scene depth,
+// to the pose of the camera when that row was exposed (see sampleSensor() in the
+// distortion shader). The scene pass is taken as the pose at the middle of the readout.
+class afRollingShutter{
+public:
+    afRollingShutter();
+
+    // Seconds between the readout of the first and the last row
+    void setReadoutTime(double a_time) { m_readoutTime = a_time; }
+    // Seconds every row integrates light, averaged over a_samples poses
+    void setExposureTime(double a_time, int a_samples);
+
+    bool isEnabled() const { return m_readoutTime > 0.0 || m_exposureTime > 0.0; }
+    float getReadoutTime() const { return static_cast<float>(m_readoutTime); }
+    float getExposureTime() const { return static_cast<float>(m_exposureTime); }
+    int getSamples() const { return m_samples; }
+
+    // Estimate the velocity from the pose of a_camera at a_time and the one of the last
+    // call. Nothing moves on the first call, when the time does not advance or after a gap.
+    void update(cCamera* a_camera, double a_time);
+
+    // Forget the last pose, e.g. when the camera was teleported
+    void reset() { m_hasPose = false; }
+
+    // Per second, in the camera frame of the lens models (x right, y down, z along the view)
+    const float* getLinearVelocity() const { return m_linearVelocity; }
+    const float* getAngularVelocity() const { return m_angularVelocity; }
+
+protected:
+    double m_readoutTime;
+    double m_exposureTime;
+    int m_samples;
+
+    bool m_hasPose;
+    cVector3d m_pos;
+    cMatrix3d m_rot;
+    double m_time;
+
+    float m_linearVelocity[3];
+    float m_angularVelocity[3];
+};
+
+#endif
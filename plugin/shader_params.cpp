@@ -0,0 +1,220 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "shader_params.h"
+
+using namespace std;
+
+afShaderParamBlock::afShaderParamBlock()
+{
+    m_programId = 0;
+    m_dirty = false;
+    m_version = 0;
+    m_skippedUploads = 0;
+    m_skippedUniformWrites = 0;
+}
+
+afShaderParamBlock::~afShaderParamBlock()
+{
+    map<GLuint, const afShaderParamBlock*>& writers = lastWriters();
+    for (map<GLuint, const afShaderParamBlock*>::iterator it = writers.begin() ; it != writers.end() ; ){
+        if (it->second == this){
+            it = writers.erase(it);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+map<GLuint, const afShaderParamBlock*>& afShaderParamBlock::lastWriters()
+{
+    static map<GLuint, const afShaderParamBlock*> writers;
+    return writers;
+}
+
+int afShaderParamBlock::componentCount(afUniformType type)
+{
+    switch (type) {
+    case afUniformType::VEC2:
+        return 2;
+    case afUniformType::VEC3:
+        return 3;
+    case afUniformType::VEC4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+int afShaderParamBlock::addUniform(const string &name, afUniformType type)
+{
+    afUniformEntry entry;
+    entry.m_name = name;
+    entry.m_type = type;
+    entry.m_location = m_programId ? glGetUniformLocation(m_programId, name.c_str()) : -1;
+    for (int i = 0 ; i < 4 ; i++){
+        entry.m_values[i] = 0.0f;
+    }
+    entry.m_intValue = 0;
+    entry.m_dirty = true;
+    m_uniforms.push_back(entry);
+    m_dirty = true;
+    return static_cast<int>(m_uniforms.size()) - 1;
+}
+
+void afShaderParamBlock::setProgram(GLuint programId)
+{
+    m_programId = programId;
+    for (size_t i = 0 ; i < m_uniforms.size() ; i++){
+        m_uniforms[i].m_location = glGetUniformLocation(m_programId, m_uniforms[i].m_name.c_str());
+        // A new program has default values, everything has to be written again
+        m_uniforms[i].m_dirty = true;
+    }
+    m_dirty = true;
+    m_version++;
+}
+
+void afShaderParamBlock::setInt(int handle, int value)
+{
+    afUniformEntry& entry = m_uniforms[handle];
+    if (!entry.m_dirty && entry.m_intValue == value){
+        m_skippedUniformWrites++;
+        return;
+    }
+    if (entry.m_intValue != value){
+        m_version++;
+    }
+    entry.m_intValue = value;
+    entry.m_dirty = true;
+    m_dirty = true;
+}
+
+void afShaderParamBlock::setFloat(int handle, float value)
+{
+    setVec(handle, &value);
+}
+
+void afShaderParamBlock::setVec2(int handle, float x, float y)
+{
+    float values[2] = {x, y};
+    setVec(handle, values);
+}
+
+void afShaderParamBlock::setVec(int handle, const float* values)
+{
+    afUniformEntry& entry = m_uniforms[handle];
+    int n = componentCount(entry.m_type);
+    bool changed = false;
+    for (int i = 0 ; i < n ; i++){
+        if (entry.m_values[i] != values[i]){
+            changed = true;
+        }
+    }
+    if (!changed){
+        if (!entry.m_dirty){
+            m_skippedUniformWrites++;
+        }
+        return;
+    }
+    for (int i = 0 ; i < n ; i++){
+        entry.m_values[i] = values[i];
+    }
+    entry.m_dirty = true;
+    m_dirty = true;
+    m_version++;
+}
+
+int afShaderParamBlock::upload()
+{
+    // Another block changed the uniforms of the shared program, restore ours
+    const afShaderParamBlock*& lastWriter = lastWriters()[m_programId];
+    if (lastWriter != this){
+        for (size_t i = 0 ; i < m_uniforms.size() ; i++){
+            m_uniforms[i].m_dirty = true;
+        }
+        m_dirty = true;
+        lastWriter = this;
+    }
+
+    if (!m_dirty || m_programId == 0){
+        m_skippedUploads++;
+        return 0;
+    }
+
+    int written = 0;
+    glUseProgram(m_programId);
+    for (size_t i = 0 ; i < m_uniforms.size() ; i++){
+        afUniformEntry& entry = m_uniforms[i];
+        if (!entry.m_dirty){
+            continue;
+        }
+        entry.m_dirty = false;
+        // Uniforms optimized out of the program have no location
+        if (entry.m_location < 0){
+            continue;
+        }
+        switch (entry.m_type) {
+        case afUniformType::INT:
+            glUniform1i(entry.m_location, entry.m_intValue);
+            break;
+        case afUniformType::FLOAT:
+            glUniform1f(entry.m_location, entry.m_values[0]);
+            break;
+        case afUniformType::VEC2:
+            glUniform2fv(entry.m_location, 1, entry.m_values);
+            break;
+        case afUniformType::VEC3:
+            glUniform3fv(entry.m_location, 1, entry.m_values);
+            break;
+        case afUniformType::VEC4:
+            glUniform4fv(entry.m_location, 1, entry.m_values);
+            break;
+        }
+        written++;
+    }
+    m_dirty = false;
+    return written;
+}
@@ -0,0 +1,126 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef SHADER_PARAMS_H
+#define SHADER_PARAMS_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class afUniformType {
+    INT,
+    FLOAT,
+    VEC2,
+    VEC3,
+    VEC4,
+};
+
+// Cached uniform: the location is resolved once per program link and the last
+// uploaded value is kept to detect changes
+struct afUniformEntry {
+    string m_name;
+    afUniformType m_type;
+    GLint m_location;
+    float m_values[4];
+    int m_intValue;
+    bool m_dirty;
+};
+
+// Change-tracked set of shader parameters shared by the distortion plugins.
+// Setting a value equal to the current one is a no-op, and upload() only issues
+// GL calls for the uniforms that changed since the last upload. The shaders are
+// GLSL 1.10/1.20 (GL 2.1), so uniform blocks are not available and the values are
+// written through cached uniform locations. Several blocks may drive the same
+// (shared) program; a block then re-uploads everything when another block wrote
+// the program since its own last upload.
+class afShaderParamBlock{
+public:
+    afShaderParamBlock();
+    ~afShaderParamBlock();
+
+    // Declare a uniform and get the handle used by the setters
+    int addUniform(const string &name, afUniformType type);
+
+    // Resolve all locations for a (re)linked program, marks every uniform dirty
+    void setProgram(GLuint programId);
+
+    void setInt(int handle, int value);
+    void setFloat(int handle, float value);
+    void setVec(int handle, const float* values);
+    void setVec2(int handle, float x, float y);
+
+    // Upload the dirty uniforms. Returns the number of uniforms written
+    int upload();
+
+    // Incremented every time any value changes
+    unsigned long getVersion() const { return m_version; }
+
+    // Number of upload() calls that had nothing to write
+    unsigned long getSkippedUploads() const { return m_skippedUploads; }
+
+    // Number of individual uniform writes avoided because the value was unchanged
+    unsigned long getSkippedUniformWrites() const { return m_skippedUniformWrites; }
+
+protected:
+    static int componentCount(afUniformType type);
+
+    // Block that last uploaded to each program
+    static map<GLuint, const afShaderParamBlock*>& lastWriters();
+
+    vector<afUniformEntry> m_uniforms;
+    GLuint m_programId;
+    bool m_dirty;
+    unsigned long m_version;
+    unsigned long m_skippedUploads;
+    unsigned long m_skippedUniformWrites;
+};
+
+#endif
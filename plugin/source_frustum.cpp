@@ -0,0 +1,198 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "source_frustum.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void afPerspectiveProjection(double a_fovY, double a_aspect, double a_near, double a_far, double a_projection[4][4])
+{
+    double f = 1.0 / tan(a_fovY / 2.0);
+    for (int r = 0 ; r < 4 ; r++){
+        for (int c = 0 ; c < 4 ; c++){
+            a_projection[r][c] = 0.0;
+        }
+    }
+    a_projection[0][0] = f / a_aspect;
+    a_projection[1][1] = f;
+    a_projection[2][2] = (a_far + a_near) / (a_near - a_far);
+    a_projection[2][3] = 2.0 * a_far * a_near / (a_near - a_far);
+    a_projection[3][2] = -1.0;
+}
+
+void afCropProjection(const float a_rect[4], double a_projection[4][4])
+{
+    // [2 u0 - 1, 2 u1 - 1] onto [-1, 1]
+    for (int i = 0 ; i < 2 ; i++){
+        double halfExtent = 1.0 / a_rect[2 + i];
+        double center = 2.0 * a_rect[i] + halfExtent - 1.0;
+        for (int c = 0 ; c < 4 ; c++){
+            a_projection[i][c] = (a_projection[i][c] - center * a_projection[3][c]) / halfExtent;
+        }
+    }
+}
+
+void afSetProjectionMatrix(const double a_projection[4][4], cTransform &a_transform)
+{
+    for (int r = 0 ; r < 4 ; r++){
+        for (int c = 0 ; c < 4 ; c++){
+            a_transform.m[c][r] = a_projection[r][c];
+        }
+    }
+}
+
+afSourceFrustum::afSourceFrustum()
+{
+    m_maxTexelStretch = 0.0;
+    m_maxSourceScale = 2.0;
+    m_width = 0;
+    m_height = 0;
+    m_updated = false;
+    m_sourceWidth = 0;
+    m_sourceHeight = 0;
+    const float fullFrame[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    for (int i = 0 ; i < 4 ; i++){
+        m_rect[i] = fullFrame[i];
+        m_appliedRect[i] = fullFrame[i];
+    }
+    m_savedUseCustomProjection = false;
+}
+
+bool afSourceFrustum::isStale(const CameraParams &a_params, int a_width, int a_height) const
+{
+    return !m_updated || a_width != m_width || a_height != m_height || a_params != m_params;
+}
+
+void afSourceFrustum::update(const CameraParams &a_params, int a_width, int a_height, const float* a_warpMap)
+{
+    m_params = a_params;
+    m_width = a_width;
+    m_height = a_height;
+    m_updated = true;
+
+    m_footprint = camdistort::analyzeWarpMap(a_warpMap, a_width, a_height, a_params.aberr_scale);
+    if (m_footprint.validPixels == 0){
+        // nothing is sampled, keep the full frame rather than an empty one
+        m_rect[0] = 0.0f; m_rect[1] = 0.0f; m_rect[2] = 1.0f; m_rect[3] = 1.0f;
+        m_sourceWidth = a_width;
+        m_sourceHeight = a_height;
+        return;
+    }
+
+    // The smallest uniform scale of the output resolution that keeps the stretch of
+    // the most magnified texel below the target
+    double scale = 1.0;
+    if (m_maxTexelStretch > 0.0){
+        scale = m_footprint.minScale > 0.0f ? 1.0 / (m_maxTexelStretch * m_footprint.minScale) : m_maxSourceScale;
+    }
+    scale = min(m_maxSourceScale, scale);
+
+    // Two source texels of margin for the bilinear footprint
+    double lower[2], upper[2];
+    const int size[2] = {a_width, a_height};
+    for (int i = 0 ; i < 2 ; i++){
+        double margin = 2.0 / (scale * size[i]);
+        lower[i] = max(0.0, m_footprint.uvMin[i] - margin);
+        upper[i] = min(1.0, m_footprint.uvMax[i] + margin);
+    }
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (maxTextureSize <= 0){
+        maxTextureSize = 4096;
+    }
+    int sourceSize[2];
+    for (int i = 0 ; i < 2 ; i++){
+        sourceSize[i] = static_cast<int>(ceil(scale * (upper[i] - lower[i]) * size[i]));
+        sourceSize[i] = max(16, min(maxTextureSize, sourceSize[i]));
+        m_rect[i] = static_cast<float>(lower[i]);
+        m_rect[2 + i] = static_cast<float>(1.0 / (upper[i] - lower[i]));
+    }
+    m_sourceWidth = sourceSize[0];
+    m_sourceHeight = sourceSize[1];
+
+    double fraction = (double)m_sourceWidth * m_sourceHeight / ((double)a_width * a_height);
+    cerr << "[INFO!] Source region u [" << lower[0] << ", " << upper[0] << "] v [" << lower[1] << ", " << upper[1]
+         << "], max stretch " << (m_footprint.minScale > 0.0f ? 1.0 / m_footprint.minScale : 0.0)
+         << " px/texel at output size, source framebuffer [" << m_sourceWidth << "x" << m_sourceHeight << "] ("
+         << static_cast<int>(100.0 * fraction + 0.5) << "% of the output pixels)" << endl;
+}
+
+void afSourceFrustum::begin(cCamera* a_camera)
+{
+    m_savedUseCustomProjection = a_camera->m_useCustomProjectionMatrix;
+    m_savedProjection = a_camera->m_projectionMatrix;
+    for (int i = 0 ; i < 4 ; i++){
+        m_appliedRect[i] = m_rect[i];
+    }
+    if (m_rect[0] == 0.0f && m_rect[1] == 0.0f && m_rect[2] == 1.0f && m_rect[3] == 1.0f){
+        return;
+    }
+
+    // Full frame projection, row major
+    double p[4][4];
+    if (m_savedUseCustomProjection){
+        for (int r = 0 ; r < 4 ; r++){
+            for (int c = 0 ; c < 4 ; c++){
+                p[r][c] = m_savedProjection.m[c][r];
+            }
+        }
+    }
+    else{
+        afPerspectiveProjection(a_camera->getFieldViewAngleRad(), (double)m_width / (double)m_height,
+                                a_camera->getNearClippingPlane(), a_camera->getFarClippingPlane(), p);
+    }
+    afCropProjection(m_rect, p);
+    afSetProjectionMatrix(p, a_camera->m_projectionMatrix);
+    a_camera->m_useCustomProjectionMatrix = true;
+}
+
+void afSourceFrustum::end(cCamera* a_camera)
+{
+    a_camera->m_useCustomProjectionMatrix = m_savedUseCustomProjection;
+    a_camera->m_projectionMatrix = m_savedProjection;
+}
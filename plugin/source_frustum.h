@@ -0,0 +1,126 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef SOURCE_FRUSTUM_H
+#define SOURCE_FRUSTUM_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include "camdistort.h"
+
+using namespace std;
+using namespace ambf;
+
+// Row-major perspective projection, as cCamera::renderView() sets up with gluPerspective()
+void afPerspectiveProjection(double a_fovY, double a_aspect, double a_near, double a_far, double a_projection[4][4]);
+
+// Restrict a row-major projection to the region a_rect = (u0, v0, 1 / width, 1 / height)
+// of its image: the NDC range of the region is mapped onto [-1, 1]
+void afCropProjection(const float a_rect[4], double a_projection[4][4]);
+
+// Column-major copy of a row-major projection, as cCamera::m_projectionMatrix expects it
+void afSetProjectionMatrix(const double a_projection[4][4], cTransform &a_transform);
+
+// Restricts the scene pass to the part of the camera image the distortion actually
+// samples. The sampled region and the densest magnification are taken from the warp
+// map of the output. The scene is then rendered with an off-axis projection covering
+// only that region, into the smallest source framebuffer for which no source texel
+// is stretched over more than the configured number of output pixels.
+class afSourceFrustum{
+public:
+    afSourceFrustum();
+
+    // Largest number of output pixels a source texel may cover (1 keeps full detail).
+    // 0, the default, keeps the texel density of a full frame at the output size.
+    void setMaxTexelStretch(double a_stretch) { m_maxTexelStretch = a_stretch; }
+
+    // Upper bound on the source resolution, relative to the output resolution
+    void setMaxSourceScale(double a_scale) { m_maxSourceScale = a_scale; }
+
+    // True if update() has not run yet for these params and output size
+    bool isStale(const CameraParams &a_params, int a_width, int a_height) const;
+
+    // Derive the region and the source size from the a_width x a_height warp map
+    void update(const CameraParams &a_params, int a_width, int a_height, const float* a_warpMap);
+
+    // Swap in the off-axis projection for the scene pass, end() restores the camera.
+    // The full frame aspect ratio is the one of the output.
+    void begin(cCamera* a_camera);
+    void end(cCamera* a_camera);
+
+    int getSourceWidth() const { return m_sourceWidth; }
+    int getSourceHeight() const { return m_sourceHeight; }
+
+    // (u0, v0, 1 / (u1 - u0), 1 / (v1 - v0)) of the last begin(), maps full frame
+    // texture coordinates to the source texture
+    const float* getRect() const { return m_appliedRect; }
+
+    // Rect the next begin() applies
+    const float* getNextRect() const { return m_rect; }
+
+    const camdistort::SourceFootprint& getFootprint() const { return m_footprint; }
+
+protected:
+    double m_maxTexelStretch;
+    double m_maxSourceScale;
+
+    CameraParams m_params;
+    int m_width;
+    int m_height;
+    bool m_updated;
+
+    camdistort::SourceFootprint m_footprint;
+    float m_rect[4];
+    float m_appliedRect[4];
+    int m_sourceWidth;
+    int m_sourceHeight;
+
+    // Camera state replaced between begin() and end()
+    bool m_savedUseCustomProjection;
+    cTransform m_savedProjection;
+};
+
+#endif
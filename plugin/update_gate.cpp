@@ -0,0 +1,157 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "update_gate.h"
+
+using namespace std;
+
+// FNV-1a, over the bytes of the values
+static const uint64_t HASH_BASIS = 14695981039346656037ULL;
+static const uint64_t HASH_PRIME = 1099511628211ULL;
+
+static void hashBytes(const void* a_data, size_t a_size, uint64_t &a_hash)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(a_data);
+    for (size_t i = 0 ; i < a_size ; i++){
+        a_hash = (a_hash ^ bytes[i]) * HASH_PRIME;
+    }
+}
+
+static void hashPose(const cVector3d &a_pos, const cMatrix3d &a_rot, uint64_t &a_hash)
+{
+    double values[12] = {a_pos.x(), a_pos.y(), a_pos.z()};
+    for (int r = 0 ; r < 3 ; r++){
+        for (int c = 0 ; c < 3 ; c++){
+            values[3 + 3 * r + c] = a_rot(r, c);
+        }
+    }
+    hashBytes(values, sizeof(values), a_hash);
+}
+
+static void hashObject(cGenericObject* a_object, uint64_t &a_hash)
+{
+    hashPose(a_object->getLocalPos(), a_object->getLocalRot(), a_hash);
+    const unsigned char show = a_object->getShowEnabled() ? 1 : 0;
+    const unsigned int children = a_object->getNumChildren();
+    hashBytes(&show, sizeof(show), a_hash);
+    // Objects added or removed change the layout of the hashed values
+    hashBytes(&children, sizeof(children), a_hash);
+    for (unsigned int i = 0 ; i < children ; i++){
+        hashObject(a_object->getChild(i), a_hash);
+    }
+}
+
+afUpdateGate::afUpdateGate()
+{
+    m_period = 0.0;
+    m_skipStatic = false;
+    m_hasFrame = false;
+    m_nextTime = 0.0;
+    m_sceneHash = 0;
+    m_version = 0;
+    m_renderedFrames = 0;
+    m_skippedFrames = 0;
+}
+
+void afUpdateGate::setRate(double a_hz)
+{
+    m_period = a_hz > 0.0 ? 1.0 / a_hz : 0.0;
+}
+
+bool afUpdateGate::update(cCamera* a_camera, double a_time, unsigned long a_version)
+{
+    // The simulation time went back, e.g. the world was reset
+    if (m_hasFrame && a_time + m_period < m_nextTime){
+        m_hasFrame = false;
+    }
+
+    bool render = !m_hasFrame || a_time >= m_nextTime;
+    uint64_t sceneHash = m_sceneHash;
+    if (render && m_hasFrame && m_skipStatic){
+        // Only hashed once the period elapsed, a static scene waits for the next period
+        // rather than being hashed again at every tick
+        sceneHash = hashScene(a_camera);
+        render = sceneHash != m_sceneHash || a_version != m_version;
+        if (!render){
+            advance(a_time);
+        }
+    }
+    if (!render){
+        m_skippedFrames++;
+        return false;
+    }
+
+    if (m_skipStatic && !m_hasFrame){
+        sceneHash = hashScene(a_camera);
+    }
+    advance(a_time);
+    m_hasFrame = true;
+    m_sceneHash = sceneHash;
+    m_version = a_version;
+    m_renderedFrames++;
+    return true;
+}
+
+void afUpdateGate::advance(double a_time)
+{
+    // On the period grid, unless the ticks are too far apart to keep up with it
+    if (m_period > 0.0 && m_hasFrame && a_time < m_nextTime + m_period){
+        m_nextTime += m_period;
+    }
+    else{
+        m_nextTime = a_time + m_period;
+    }
+}
+
+uint64_t afUpdateGate::hashScene(cCamera* a_camera) const
+{
+    uint64_t hash = HASH_BASIS;
+    hashPose(a_camera->getGlobalPos(), a_camera->getGlobalRot(), hash);
+    cWorld* world = a_camera->getParentWorld();
+    if (world){
+        hashObject(world, hash);
+    }
+    return hash;
+}
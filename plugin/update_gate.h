@@ -0,0 +1,105 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef UPDATE_GATE_H
+#define UPDATE_GATE_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <cstdint>
+
+using namespace std;
+using namespace ambf;
+
+// Decides at every graphics tick whether the camera renders a new frame or keeps its
+// last one. With a rate, frames are rendered at most once per period of simulation
+// time, like the sensor being modeled. With skip_static, a frame is only rendered when
+// the camera pose, the parameter version or a transform of the scene changed since the
+// last one. Changes that are not transforms (deformable meshes, materials, lights) are
+// not seen by the latter.
+class afUpdateGate{
+public:
+    afUpdateGate();
+
+    // Frames per second of simulation time, 0 renders at every tick
+    void setRate(double a_hz);
+    void setSkipStatic(bool a_skip) { m_skipStatic = a_skip; }
+
+    bool isEnabled() const { return m_period > 0.0 || m_skipStatic; }
+    double getRate() const { return m_period > 0.0 ? 1.0 / m_period : 0.0; }
+    bool getSkipStatic() const { return m_skipStatic; }
+
+    // True if a_camera renders at a_time. a_version changes with whatever else the
+    // frame depends on (calibration, output size, shaders). Counts the frame either way.
+    bool update(cCamera* a_camera, double a_time, unsigned long a_version);
+
+    // Render at the next tick whatever changed, e.g. after a reset
+    void invalidate() { m_hasFrame = false; }
+
+    unsigned long getRenderedFrames() const { return m_renderedFrames; }
+    unsigned long getSkippedFrames() const { return m_skippedFrames; }
+
+protected:
+    // Hash of the camera pose and the local transform and visibility of every object of
+    // its world
+    uint64_t hashScene(cCamera* a_camera) const;
+
+    // Move m_nextTime to the next period after a_time
+    void advance(double a_time);
+
+    double m_period;
+    bool m_skipStatic;
+
+    bool m_hasFrame;
+    double m_nextTime;
+    uint64_t m_sceneHash;
+    unsigned long m_version;
+
+    unsigned long m_renderedFrames;
+    unsigned long m_skippedFrames;
+};
+
+#endif
@@ -0,0 +1,207 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#include "warp_map.h"
+
+using namespace std;
+
+afWarpMap::afWarpMap()
+{
+    m_textureId = 0;
+    m_width = 0;
+    m_height = 0;
+    m_type = afWarpMapType::UV;
+    m_textureWidth = 0;
+    m_textureHeight = 0;
+    m_built = false;
+    m_remapFormat = camdistort::RemapFormat::FLOAT32;
+    m_remapSource[0] = 0;
+    m_remapSource[1] = 0;
+}
+
+afWarpMap::~afWarpMap()
+{
+    // The GL texture is released in destroy(), which needs a current context
+}
+
+bool afWarpMap::isStale(const CameraParams &params, int width, int height, afWarpMapType type) const
+{
+    if (type == afWarpMapType::REMAP){
+        return !m_built || type != m_type || params != m_params;
+    }
+    return !m_built || width != m_width || height != m_height || type != m_type || params != m_params;
+}
+
+bool afWarpMap::build(const CameraParams &params, int width, int height, afWarpMapType type, camdistort::ThreadPool* pool)
+{
+    m_params = params;
+    m_width = width;
+    m_height = height;
+    m_type = type;
+    m_built = true;
+
+    // Nothing to compute, the file is uploaded as is
+    if (type == afWarpMapType::REMAP){
+        vector<float>().swap(m_data);
+        m_report = camdistort::WarpMapReport();
+        m_remapFile.reset(new camdistort::RemapFile());
+        // Left unbuilt, a 0x0 map would have the shader divide by a zero RemapSourceSize
+        if (!m_remapFile->open(params.remap_file)){
+            m_remapFile.reset();
+            m_width = 0;
+            m_height = 0;
+            m_remapSource[0] = 0;
+            m_remapSource[1] = 0;
+            m_built = false;
+            return false;
+        }
+        m_width = m_remapFile->getWidth();
+        m_height = m_remapFile->getHeight();
+        m_remapFormat = m_remapFile->getFormat();
+        m_remapSource[0] = m_remapFile->getSourceWidth();
+        m_remapSource[1] = m_remapFile->getSourceHeight();
+        return true;
+    }
+    m_data.resize(4 * (size_t)width * (size_t)height);
+
+    // Vectorized and tile-parallel evaluation of the same model as the shader, or
+    // its exact inverse solved per pixel
+    camdistort::WarpMapOptions options;
+    options.pool = pool;
+    bool inverse = params.inverse || type == afWarpMapType::DIRECTION;
+    if (inverse){
+        options.direction = camdistort::WarpDirection::INVERSE;
+        options.iterations = params.inverse_iterations;
+        options.tolerance = params.inverse_tolerance;
+    }
+    if (type == afWarpMapType::DIRECTION){
+        camdistort::buildDirectionMap(params, width, height, m_data.data(), options, &m_report);
+    }
+    else{
+        camdistort::buildWarpMap(params, width, height, m_data.data(), options, &m_report);
+    }
+
+    if (inverse){
+        cerr << "[INFO!] " << (type == afWarpMapType::DIRECTION ? "Direction" : "Inverse warp") << " map [" << width << "x" << height << "]: max residual "
+             << m_report.maxResidual << " px, " << m_report.nonConverged << " of "
+             << m_report.solvedPixels << " pixels did not converge" << endl;
+        if (m_report.nonConverged > 0){
+            cerr << "WARNING! Non-converged pixels have no inverse within "
+                 << params.inverse_tolerance << " px and are rendered black" << endl;
+        }
+    }
+    return true;
+}
+
+void afWarpMap::upload()
+{
+    if (!m_built){
+        return;
+    }
+
+    if (m_textureId == 0){
+        glGenTextures(1, &m_textureId);
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+        // The map has one texel per output pixel, so no filtering is needed. A remap
+        // has the resolution of the file and is interpolated to the output.
+        GLint filter = m_type == afWarpMapType::REMAP ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    else{
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+    }
+
+    // Straight from the page cache, half floats stay half floats on the GPU
+    if (m_type == afWarpMapType::REMAP){
+        if (m_remapFile){
+            bool half = m_remapFormat == camdistort::RemapFormat::FLOAT16_OFFSET;
+            // Rows of the file are 4 byte aligned, the alignment chai3d left set is restored after
+            GLint alignment;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexImage2D(GL_TEXTURE_2D, 0, half ? GL_RG16F : GL_RG32F, m_width, m_height, 0, GL_RG,
+                         half ? GL_HALF_FLOAT : GL_FLOAT, m_remapFile->getData());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+            m_textureWidth = m_width;
+            m_textureHeight = m_height;
+            m_remapFile.reset();
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return;
+    }
+
+    // Only reallocate the storage when the size changed
+    if (m_textureWidth != m_width || m_textureHeight != m_height){
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, m_data.data());
+        m_textureWidth = m_width;
+        m_textureHeight = m_height;
+    }
+    else{
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_FLOAT, m_data.data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void afWarpMap::bind(GLenum textureUnit) const
+{
+    glActiveTexture(textureUnit);
+    glBindTexture(GL_TEXTURE_2D, m_textureId);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void afWarpMap::destroy()
+{
+    if (m_textureId != 0){
+        glDeleteTextures(1, &m_textureId);
+        m_textureId = 0;
+    }
+    m_textureWidth = 0;
+    m_textureHeight = 0;
+    m_remapFile.reset();
+    m_built = false;
+}
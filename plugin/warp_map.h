@@ -0,0 +1,133 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+#ifndef WARP_MAP_H
+#define WARP_MAP_H
+
+// To silence warnings on MacOS
+#define GL_SILENCE_DEPRECATION
+#include <afFramework.h>
+#include <vector>
+#include "camdistort.h"
+#include "cube_map.h"
+#include "remap_file.h"
+
+using namespace std;
+
+// What the texels of an afWarpMap hold
+enum class afWarpMapType {
+    // (u_g, v_g, d_u, d_v) into a planar scene texture
+    UV,
+    // (x, y, z, valid) ray direction into the cube faces, see camdistort::buildDirectionMap()
+    DIRECTION,
+    // (x, y) source pixels of a type: remap calibration at the resolution of the
+    // file, uploaded from the mapped file as stored and sampled with linear filtering
+    REMAP,
+};
+
+// Per-pixel lookup table of source texture coordinates for the distortion pass.
+// Each texel stores (u_g, v_g, d_u, d_v): the green-channel source coordinate and the
+// normalized lens displacement, so that the red/blue coordinates are recovered as
+// tc_g + (aberr_c - aberr_g) * d. Texels outside the image or the blackout circle are
+// written as (-1, -1, 0, 0) and rendered black.
+class afWarpMap{
+public:
+    afWarpMap();
+    ~afWarpMap();
+
+    // True if the map was not built yet or was built for different params / output size / type.
+    // A REMAP map does not depend on the output size.
+    bool isStale(const CameraParams &params, int width, int height, afWarpMapType type = afWarpMapType::UV) const;
+
+    // Evaluate the distortion model on the CPU for every output pixel, solving the
+    // inverse when params.inverse is set. DIRECTION maps always solve the inverse.
+    // REMAP maps only map params.remap_file, the size is the one of the file.
+    // Only touches CPU memory, so it may run on any thread; pool defaults to the
+    // process-wide camdistort pool. False, and the map stays unbuilt, if the remap
+    // file can not be opened.
+    bool build(const CameraParams &params, int width, int height, afWarpMapType type = afWarpMapType::UV,
+               camdistort::ThreadPool* pool = nullptr);
+
+    // Create (if needed) and fill the float texture from the CPU map, or from the
+    // mapped file for REMAP, which is unmapped afterwards
+    void upload();
+
+    // Bind the map texture to the given texture unit (e.g. GL_TEXTURE3)
+    void bind(GLenum textureUnit) const;
+
+    void destroy();
+
+    GLuint getTextureId() const { return m_textureId; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    afWarpMapType getType() const { return m_type; }
+    // Empty for REMAP, see camdistort::buildWarpMap() for its CPU lookup
+    const vector<float>& getData() const { return m_data; }
+
+    // Storage of a REMAP map and the size of the image its coordinates point into
+    camdistort::RemapFormat getRemapFormat() const { return m_remapFormat; }
+    int getRemapSourceWidth() const { return m_remapSource[0]; }
+    int getRemapSourceHeight() const { return m_remapSource[1]; }
+
+    // Convergence of the last inverse build, zero for the forward model
+    const camdistort::WarpMapReport& getReport() const { return m_report; }
+
+protected:
+    vector<float> m_data;
+    CameraParams m_params;
+    afWarpMapType m_type;
+    camdistort::WarpMapReport m_report;
+    unique_ptr<camdistort::RemapFile> m_remapFile;
+    camdistort::RemapFormat m_remapFormat;
+    int m_remapSource[2];
+    GLuint m_textureId;
+    int m_width;
+    int m_height;
+    int m_textureWidth;
+    int m_textureHeight;
+    bool m_built;
+};
+
+#endif
@@ -0,0 +1,479 @@
+//==============================================================================
+/*
+    Software License Agreement (BSD License)
+    Copyright (c) 2019-2022, AMBF
+    (https://github.com/WPI-AIM/ambf)
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following
+    disclaimer in the documentation and/or other materials provided
+    with the distribution.
+
+    * Neither the name of authors nor the names of its contributors may
+    be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+    \author    <amunawar@wpi.edu>
+    \author    Adnan Munawar
+
+    \author    <hishida3@jhu.edu>
+    \author    Hisashi Ishida
+*/
+//==============================================================================
+
+// Vector kernels of libcamdistort against the scalar references: buildWarpMap() for
+// every lens model, both directions and every instruction set of the build and the
+// CPU. remapRGBA8() and remapDepth() with both filters are checked against the plain
+// samplers below rather than the library references, which share the generic kernel
+// code with the instruction sets that have no vector remap. Also the lens schedule
+// of a zoom calibration and the keyframe lists it rejects, and remap files written,
+// reopened and turned into warp maps. Exits non-zero on a mismatch.
+//
+//   camdistort_tests [config dir]
+
+#include "camdistort.h"
+#include "camera_params_yaml.h"
+#include "remap_file.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace camdistort;
+using namespace std;
+
+// Map coordinates in output pixels, in the bench units
+static const double MAP_TOLERANCE_PX = 1e-3;
+// Pixels whose validity may flip on the border of the image or the blackout circle,
+// where the single precision kernels and the reference round differently
+static const double MAX_VALIDITY_MISMATCH = 1e-4;
+static const int REMAP_TOLERANCE_LSB = 1;
+static const float DEPTH_TOLERANCE = 1e-4f;
+
+static const int WIDTH = 320;
+static const int HEIGHT = 240;
+
+static int g_failures = 0;
+
+static void check(bool ok, const string &name, const string &detail)
+{
+    printf("%-4s %s %s\n", ok ? "ok" : "FAIL", name.c_str(), detail.c_str());
+    if (!ok){
+        g_failures++;
+    }
+}
+
+static vector<Isa> getIsas()
+{
+    vector<Isa> isas;
+    for (int i = 0 ; i <= static_cast<int>(getBestIsa()) ; i++){
+        isas.push_back(static_cast<Isa>(i));
+    }
+    return isas;
+}
+
+static bool isValid(const float* texel)
+{
+    return texel[0] >= 0.0f;
+}
+
+static void testWarpMap(const string &name, const CameraParams &params, WarpDirection direction, Isa isa,
+                        const vector<float> &reference)
+{
+    vector<float> map(4 * WIDTH * HEIGHT);
+    WarpMapOptions options;
+    options.direction = direction;
+    options.isa = isa;
+    options.iterations = params.inverse_iterations;
+    options.tolerance = params.inverse_tolerance;
+    buildWarpMap(params, WIDTH, HEIGHT, map.data(), options);
+
+    double maxError = 0.0;
+    int mismatches = 0;
+    for (int i = 0 ; i < WIDTH * HEIGHT ; i++){
+        const float* a = &map[4 * i];
+        const float* b = &reference[4 * i];
+        if (isValid(a) != isValid(b)){
+            mismatches++;
+            continue;
+        }
+        if (!isValid(a)){
+            continue;
+        }
+        maxError = max(maxError, fabs((double)a[0] - b[0]) * WIDTH);
+        maxError = max(maxError, fabs((double)a[1] - b[1]) * HEIGHT);
+        maxError = max(maxError, fabs((double)a[2] - b[2]) * WIDTH);
+        maxError = max(maxError, fabs((double)a[3] - b[3]) * HEIGHT);
+    }
+    char detail[128];
+    snprintf(detail, sizeof(detail), "max error %.2e px, validity mismatches %d", maxError, mismatches);
+    string testName = "warp_map " + name + (direction == WarpDirection::INVERSE ? " inverse " : " forward ") + getIsaName(isa);
+    check(maxError <= MAP_TOLERANCE_PX && mismatches <= MAX_VALIDITY_MISMATCH * WIDTH * HEIGHT, testName, detail);
+}
+
+// Texel centers at (i + 0.5) / size, indices clamped to the image
+static double bilinearIndices(float coord, int size, int &i0, int &i1)
+{
+    const double p = (double)(coord * size) - 0.5;
+    const int i = (int)floor(p);
+    i0 = min(max(i, 0), size - 1);
+    i1 = min(max(i + 1, 0), size - 1);
+    return p - i;
+}
+
+static int nearestIndex(float coord, int size)
+{
+    return min(max((int)floor(coord * size), 0), size - 1);
+}
+
+static void sampleRGBA8(const vector<uint8_t> &src, int srcWidth, int srcHeight, const vector<float> &map,
+                        const float aberr[3], vector<uint8_t> &dst)
+{
+    for (int i = 0 ; i < WIDTH * HEIGHT ; i++){
+        const float* texel = &map[4 * i];
+        uint8_t* out = &dst[4 * i];
+        out[3] = 255;
+        if (!isValid(texel)){
+            out[0] = out[1] = out[2] = 0;
+            continue;
+        }
+        for (int c = 0 ; c < 3 ; c++){
+            // The green channel follows the map, red and blue are offset along its derivative
+            const float s = aberr[c] - aberr[1];
+            int x0, x1, y0, y1;
+            const double fx = bilinearIndices(texel[0] + s * texel[2], srcWidth, x0, x1);
+            const double fy = bilinearIndices(texel[1] + s * texel[3], srcHeight, y0, y1);
+            const double top = src[4 * (y0 * srcWidth + x0) + c] * (1.0 - fx) + src[4 * (y0 * srcWidth + x1) + c] * fx;
+            const double bottom = src[4 * (y1 * srcWidth + x0) + c] * (1.0 - fx) + src[4 * (y1 * srcWidth + x1) + c] * fx;
+            const double value = floor(top * (1.0 - fy) + bottom * fy + 0.5);
+            out[c] = static_cast<uint8_t>(min(max(value, 0.0), 255.0));
+        }
+    }
+}
+
+static void sampleDepth(const vector<float> &src, int srcWidth, int srcHeight, const vector<float> &map,
+                        RemapFilter filter, vector<float> &dst)
+{
+    for (int i = 0 ; i < WIDTH * HEIGHT ; i++){
+        const float* texel = &map[4 * i];
+        if (!isValid(texel)){
+            dst[i] = 0.0f;
+        }
+        else if (filter == RemapFilter::NEAREST){
+            dst[i] = src[nearestIndex(texel[1], srcHeight) * srcWidth + nearestIndex(texel[0], srcWidth)];
+        }
+        else{
+            int x0, x1, y0, y1;
+            const double fx = bilinearIndices(texel[0], srcWidth, x0, x1);
+            const double fy = bilinearIndices(texel[1], srcHeight, y0, y1);
+            const double top = src[y0 * srcWidth + x0] * (1.0 - fx) + src[y0 * srcWidth + x1] * fx;
+            const double bottom = src[y1 * srcWidth + x0] * (1.0 - fx) + src[y1 * srcWidth + x1] * fx;
+            dst[i] = static_cast<float>(top * (1.0 - fy) + bottom * fy);
+        }
+    }
+}
+
+static void testRemap(const string &name, const CameraParams &params, const vector<float> &map, Isa isa)
+{
+    // Smooth gradients with some texture, so that the interpolation weights matter
+    const int srcWidth = WIDTH + 37;
+    const int srcHeight = HEIGHT + 21;
+    vector<uint8_t> rgba(4 * srcWidth * srcHeight);
+    vector<float> depth(srcWidth * srcHeight);
+    for (int y = 0 ; y < srcHeight ; y++){
+        for (int x = 0 ; x < srcWidth ; x++){
+            uint8_t* texel = &rgba[4 * (y * srcWidth + x)];
+            texel[0] = static_cast<uint8_t>(x * 255 / srcWidth);
+            texel[1] = static_cast<uint8_t>(y * 255 / srcHeight);
+            texel[2] = static_cast<uint8_t>((x * 7 + y * 13) & 255);
+            texel[3] = 255;
+            depth[y * srcWidth + x] = 0.5f + 0.25f * sinf(0.05f * x) * cosf(0.07f * y);
+        }
+    }
+
+    vector<uint8_t> dst(4 * WIDTH * HEIGHT), dstReference(4 * WIDTH * HEIGHT);
+    RemapOptions options;
+    options.isa = isa;
+    remapRGBA8(rgba.data(), srcWidth, srcHeight, map.data(), WIDTH, HEIGHT, params.aberr_scale, dst.data(), options);
+    sampleRGBA8(rgba, srcWidth, srcHeight, map, params.aberr_scale, dstReference);
+    int maxError = 0;
+    for (size_t i = 0 ; i < dst.size() ; i++){
+        maxError = max(maxError, abs((int)dst[i] - (int)dstReference[i]));
+    }
+    char detail[128];
+    snprintf(detail, sizeof(detail), "max error %d LSB", maxError);
+    check(maxError <= REMAP_TOLERANCE_LSB, "remap_rgba8 " + name + " " + getIsaName(isa), detail);
+
+    const RemapFilter filters[2] = {RemapFilter::BILINEAR, RemapFilter::NEAREST};
+    for (int f = 0 ; f < 2 ; f++){
+        vector<float> out(WIDTH * HEIGHT), outReference(WIDTH * HEIGHT);
+        options.filter = filters[f];
+        remapDepth(depth.data(), srcWidth, srcHeight, map.data(), WIDTH, HEIGHT, out.data(), options);
+        sampleDepth(depth, srcWidth, srcHeight, map, filters[f], outReference);
+        float maxDepthError = 0.0f;
+        for (size_t i = 0 ; i < out.size() ; i++){
+            maxDepthError = max(maxDepthError, fabsf(out[i] - outReference[i]));
+        }
+        snprintf(detail, sizeof(detail), "max error %.2e", maxDepthError);
+        check(maxDepthError <= DEPTH_TOLERANCE, string("remap_depth ") + (f == 0 ? "bilinear " : "nearest ") + name + " " + getIsaName(isa), detail);
+    }
+}
+
+static bool near(float a, float b)
+{
+    return fabsf(a - b) <= 1e-4f * max(1.0f, fabsf(b));
+}
+
+static void testLensSchedule(const string &configDir)
+{
+    const string file = configDir + "/example_zoom.yaml";
+    CameraParams base = CameraParams();
+    LensSchedule schedule;
+    if (!readCameraParams(file, base) || !readLensSchedule(file, base, schedule)){
+        check(false, "lens_schedule read example_zoom.yaml", "");
+        return;
+    }
+    check(schedule.size() == 3, "lens_schedule keyframes", to_string(schedule.size()));
+
+    // Zoom 1, 2 and 3 calibrated, fx 400, 800 and 1200, cx only overridden at zoom 3
+    struct Sample { float zoom; int steps; float fx; float cx; float k1; };
+    const Sample samples[6] = {{1.0f, 0, 400.0f, 320.0f, -0.30f},
+                               {2.0f, 0, 800.0f, 320.0f, -0.15f},
+                               {1.5f, 0, 600.0f, 320.0f, -0.225f},
+                               {2.5f, 0, 1000.0f, 321.0f, -0.115f},
+                               {5.0f, 0, 1200.0f, 322.0f, -0.08f},
+                               {1.26f, 4, 500.0f, 320.0f, -0.2625f}};
+    for (int i = 0 ; i < 6 ; i++){
+        const Sample &sample = samples[i];
+        CameraParams params = schedule.evaluate(sample.zoom, 0.0f, sample.steps);
+        char detail[128];
+        snprintf(detail, sizeof(detail), "zoom %.2f steps %d: fx %g cx %g k1 %g", sample.zoom, sample.steps,
+                 params.fx, params.cx, params.radial_distortion_coeffs[0]);
+        check(near(params.fx, sample.fx) && near(params.fy, sample.fx) && near(params.cx, sample.cx) &&
+              near(params.radial_distortion_coeffs[0], sample.k1), "lens_schedule evaluate", detail);
+    }
+
+    // Every coefficient list of a keyframe must have its full length
+    const char* shortLists[6] = {"radial_distortion_coeffs: [-0.1, 0.01]",
+                                 "tangential_distortion_coeffs: [0.001]",
+                                 "chromatic_distortion: [1.0, 1.0]",
+                                 "rational_distortion_coeffs: [0.05]",
+                                 "thin_prism_coeffs: [0.001, 0.0, 0.0]",
+                                 "tilt: [0.01]"};
+    const string shortFile = "camdistort_tests_keyframes.yaml";
+    for (int i = 0 ; i < 6 ; i++){
+        {
+            ofstream out(shortFile.c_str());
+            out << "type: pinhole\n"
+                << "image_size: [640, 480]\n"
+                << "intrinsic: {fx: 400.0, fy: 400.0, cx: 320.0, cy: 240.0}\n"
+                << "radial_distortion_coeffs: [-0.3, 0.1, 0.0, 0.0]\n"
+                << "tangential_distortion_coeffs: [0.0, 0.0]\n"
+                << "keyframes:\n"
+                << "  - zoom: 1.0\n"
+                << "  - zoom: 2.0\n"
+                << "    " << shortLists[i] << "\n";
+        }
+        CameraParams params = CameraParams();
+        bool rejected = readCameraParams(shortFile, params) && !readLensSchedule(shortFile, params, schedule);
+        check(rejected, "lens_schedule rejects", shortLists[i]);
+    }
+    remove(shortFile.c_str());
+}
+
+static void testRemapFile()
+{
+    // A map into a larger source image, scaled and bent so the offsets are not constant
+    const int sourceWidth = 400;
+    const int sourceHeight = 300;
+    vector<float> mapX(WIDTH * HEIGHT), mapY(WIDTH * HEIGHT);
+    for (int y = 0 ; y < HEIGHT ; y++){
+        for (int x = 0 ; x < WIDTH ; x++){
+            mapX[y * WIDTH + x] = (x + 0.5f) * sourceWidth / WIDTH - 0.5f + 3.0f * sinf(0.04f * y);
+            mapY[y * WIDTH + x] = (y + 0.5f) * sourceHeight / HEIGHT - 0.5f + 2.0f * cosf(0.03f * x);
+        }
+    }
+
+    CameraParams params = CameraParams();
+    params.distortion_type = DistortionType::REMAP;
+    params.width = WIDTH;
+    params.height = HEIGHT;
+    params.fx = params.fy = WIDTH;
+    params.cx = WIDTH / 2.0f;
+    params.cy = HEIGHT / 2.0f;
+    params.blackout = false;
+    for (int c = 0 ; c < 3 ; c++){
+        params.aberr_scale[c] = 1.0f;
+    }
+
+    const RemapFormat formats[2] = {RemapFormat::FLOAT32, RemapFormat::FLOAT16_OFFSET};
+    // In source pixels, see RemapFormat
+    const double tolerances[2] = {1e-3, 1.0 / 16.0};
+    for (int f = 0 ; f < 2 ; f++){
+        const string name = f == 0 ? "float" : "half";
+        params.remap_file = "camdistort_tests_" + name + ".remap";
+        RemapFile file;
+        if (!writeRemapFile(params.remap_file, WIDTH, HEIGHT, mapX.data(), mapY.data(), sourceWidth, sourceHeight, formats[f]) ||
+            !file.open(params.remap_file)){
+            check(false, "remap_file write and open " + name, "");
+            continue;
+        }
+        check(file.getWidth() == WIDTH && file.getHeight() == HEIGHT && file.getSourceWidth() == sourceWidth &&
+              file.getSourceHeight() == sourceHeight && file.getFormat() == formats[f], "remap_file header " + name, "");
+        file.close();
+
+        // The output window matches the map, output row y reads map row HEIGHT - 1 - y as
+        // the warp map rows run bottom up
+        vector<float> map(4 * WIDTH * HEIGHT);
+        buildWarpMap(params, WIDTH, HEIGHT, map.data());
+        double maxError = 0.0;
+        int mismatches = 0;
+        for (int y = 0 ; y < HEIGHT ; y++){
+            for (int x = 0 ; x < WIDTH ; x++){
+                const int i = (HEIGHT - 1 - y) * WIDTH + x;
+                const double u = (mapX[i] + 0.5) / sourceWidth;
+                const double v = 1.0 - (mapY[i] + 0.5) / sourceHeight;
+                const float* texel = &map[4 * (y * WIDTH + x)];
+                // Leave the pixels whose validity the half rounding may flip
+                const double margin = tolerances[f] / sourceWidth;
+                const bool inside = u >= margin && u <= 1.0 - margin && v >= margin && v <= 1.0 - margin;
+                const bool outside = u < -margin || u > 1.0 + margin || v < -margin || v > 1.0 + margin;
+                if ((inside && !isValid(texel)) || (outside && isValid(texel))){
+                    mismatches++;
+                }
+                else if (inside){
+                    maxError = max(maxError, fabs(texel[0] - u) * sourceWidth);
+                    maxError = max(maxError, fabs(texel[1] - v) * sourceHeight);
+                }
+            }
+        }
+        char detail[128];
+        snprintf(detail, sizeof(detail), "max error %.2e px, validity mismatches %d", maxError, mismatches);
+        check(maxError <= tolerances[f] && mismatches == 0, "remap_file warp_map " + name, detail);
+        remove(params.remap_file.c_str());
+    }
+
+    // Exact in half precision, including a subnormal and the largest finite value
+    const float halves[6] = {0.0f, 1.0f, -2.5f, 0.0625f, 65504.0f, 1.0f / 65536.0f};
+    bool exact = true;
+    for (int i = 0 ; i < 6 ; i++){
+        exact = exact && halfToFloat(floatToHalf(halves[i])) == halves[i];
+    }
+    check(exact, "remap_file half conversion", "");
+
+    // A header cut short and a header whose pixels are missing
+    const string valid = "camdistort_tests_valid.remap";
+    const string truncated = "camdistort_tests_truncated.remap";
+    writeRemapFile(valid, WIDTH, HEIGHT, mapX.data(), mapY.data(), sourceWidth, sourceHeight);
+    const size_t lengths[2] = {sizeof(RemapFileHeader) / 2, sizeof(RemapFileHeader) + 64};
+    for (int t = 0 ; t < 2 ; t++){
+        {
+            ifstream in(valid.c_str(), ios::binary);
+            vector<char> bytes(lengths[t]);
+            in.read(bytes.data(), bytes.size());
+            ofstream out(truncated.c_str(), ios::binary);
+            out.write(bytes.data(), bytes.size());
+        }
+        RemapFile file;
+        check(!file.open(truncated), "remap_file rejects", t == 0 ? "truncated header" : "truncated data");
+    }
+    remove(valid.c_str());
+    remove(truncated.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    const string configDir = argc > 1 ? argv[1] : string(CAMERA_DISTORTION_SOURCE_DIR) + "/example/config_file";
+
+    vector<pair<string, CameraParams> > models;
+    const char* configs[4] = {"example_pinhole.yaml", "example_fisheye.yaml", "example_panotool.yaml", "example_double_sphere.yaml"};
+    for (int i = 0 ; i < 4 ; i++){
+        CameraParams params = CameraParams();
+        if (!readCameraParams(configDir + "/" + configs[i], params)){
+            check(false, string("read ") + configs[i], "");
+            continue;
+        }
+        // example_<model>.yaml
+        const string file = configs[i];
+        models.push_back(make_pair(file.substr(8, file.size() - 13), params));
+    }
+    // The example pinhole and panotool calibrations have no distortion
+    for (size_t i = 0 ; i < models.size() ; i++){
+        CameraParams &params = models[i].second;
+        if (params.distortion_type == DistortionType::PINHOLE){
+            params.radial_distortion_coeffs[0] = -0.3f;
+            params.radial_distortion_coeffs[1] = 0.1f;
+        }
+        else if (params.distortion_type == DistortionType::PANOTOOL){
+            // scale k3 + k2 r + k1 r^2 + k0 r^3, as the OpenHMD headset profiles
+            const float k[4] = {0.098f, 0.324f, -0.241f, 0.819f};
+            for (int c = 0 ; c < 4 ; c++){
+                params.radial_distortion_coeffs[c] = k[c];
+            }
+            params.aberr_scale[0] = 0.996f;
+            params.aberr_scale[2] = 1.014f;
+        }
+    }
+    // The extended OpenCV pinhole terms take their own kernel path
+    if (!models.empty() && models[0].second.distortion_type == DistortionType::PINHOLE){
+        CameraParams params = models[0].second;
+        params.radial_distortion_coeffs[0] = -0.28f;
+        params.radial_distortion_coeffs[1] = 0.07f;
+        params.tangential_distortion_coeffs[0] = 0.001f;
+        params.tangential_distortion_coeffs[1] = -0.0005f;
+        params.rational_distortion_coeffs[0] = 0.05f;
+        params.thin_prism_coeffs[0] = 0.001f;
+        params.thin_prism_coeffs[2] = -0.0008f;
+        params.tilt[0] = 0.01f;
+        params.tilt[1] = -0.02f;
+        params.blackout = true;
+        models.push_back(make_pair(string("pinhole_extended"), params));
+    }
+
+    const vector<Isa> isas = getIsas();
+    const WarpDirection directions[2] = {WarpDirection::FORWARD, WarpDirection::INVERSE};
+    for (size_t m = 0 ; m < models.size() ; m++){
+        for (int d = 0 ; d < 2 ; d++){
+            vector<float> reference(4 * WIDTH * HEIGHT);
+            buildWarpMapReference(models[m].second, WIDTH, HEIGHT, reference.data(), directions[d]);
+            for (size_t i = 0 ; i < isas.size() ; i++){
+                testWarpMap(models[m].first, models[m].second, directions[d], isas[i], reference);
+            }
+            if (directions[d] == WarpDirection::FORWARD){
+                for (size_t i = 0 ; i < isas.size() ; i++){
+                    testRemap(models[m].first, models[m].second, reference, isas[i]);
+                }
+            }
+        }
+    }
+
+    testLensSchedule(configDir);
+    testRemapFile();
+
+    printf("%d failure(s)\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}